@@ -0,0 +1,94 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Compares scanning the marking params and laser assignment of all vector blocks of a work
+ * plane by decoding the full work plane with scanning only the vector block headers, for
+ * increasing numbers of points per vector block.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 20;
+    const int num_vbs = 200;
+
+    for (int num_points : {16, 256, 4096})
+    {
+        std::string path = ovf_bench::TempPath("ovf_bench10_vector_block_headers.ovf");
+        {
+            rw::OvfFileWriter writer{};
+            writer.WriteFullJob(ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points), path);
+        }
+
+        rw::OvfFileReader reader{0};
+        ovf::Job job{};
+        reader.OpenFile(path, job);
+
+        int64_t checksum = 0;
+        ovf::WorkPlane wp{};
+        double full = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_wps; i++)
+            {
+                reader.GetWorkPlane(i, wp);
+                for (const auto& vb : wp.vector_blocks())
+                    checksum += vb.marking_params_key() + vb.laser_index();
+            }
+        });
+
+        google::protobuf::RepeatedPtrField<ovf::VectorBlock> headers;
+        double projected = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_wps; i++)
+            {
+                reader.GetVectorBlockHeaders(i, headers);
+                for (const auto& vb : headers)
+                    checksum -= vb.marking_params_key() + vb.laser_index();
+            }
+        });
+
+        std::cout << std::setw(5) << num_points << " points per block: " << std::fixed << std::setprecision(3)
+                  << "full work plane " << (full * 1e3 / num_wps) << " ms, "
+                  << "headers " << (projected * 1e3 / num_wps) << " ms, "
+                  << std::setprecision(1) << (full / projected) << "x (checksum " << checksum << ")" << std::endl;
+
+        reader.CloseFile();
+        std::filesystem::remove(path);
+    }
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,136 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+#include <atomic>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures building the spatial index, and finding the vector blocks within a region
+ * with it, compared to decoding the whole work plane and testing every vector block.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 20;
+    const int num_vbs = 2000;
+    const int num_points = 64;
+
+    std::string path = ovf_bench::TempPath("ovf_bench11_spatial_index.ovf");
+    {
+        // spread the vector blocks over a 100 x 100 field
+        auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+        for (auto& wp : *job.mutable_work_planes())
+        {
+            for (int i_vb = 0; i_vb < num_vbs; i_vb++)
+            {
+                auto points = wp.mutable_vector_blocks(i_vb)->mutable_line_sequence()->mutable_points();
+                const float offset_x = (float)(i_vb % 50) * 2.0f;
+                const float offset_y = (float)(i_vb / 50) * 2.5f;
+                for (int i = 0; i < points->size(); i += 2)
+                {
+                    points->Set(i, offset_x + points->Get(i) * 0.002f);
+                    points->Set(i + 1, offset_y + points->Get(i + 1) * 0.002f);
+                }
+            }
+        }
+
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(job, path);
+    }
+
+    const rw::BoundingBox region{40.0f, 40.0f, 50.0f, 50.0f};
+    ovf::Job job{};
+
+    {
+        rw::OvfFileReader reader{0};
+        reader.OpenFile(path, job);
+        double seconds = ovf_bench::Measure([&](){ reader.BuildSpatialIndex(); });
+        std::cout << "build parallel:   " << std::fixed << std::setprecision(3)
+                  << (seconds * 1e3 / num_wps) << " ms per work plane" << std::endl;
+    }
+
+    rw::OvfFileReader reader{0};
+    reader.OpenFile(path, job);
+
+    std::vector<int> found;
+    double build = ovf_bench::Measure([&](){
+        for (int i = 0; i < num_wps; i++)
+            reader.FindVectorBlocks(i, region, found);
+    });
+    std::cout << "build on demand:  " << (build * 1e3 / num_wps) << " ms per work plane, "
+              << (num_wps * (double)num_vbs * num_points * sizeof(float) / build / 1e9) << " GB/s of coordinates" << std::endl;
+
+    const int num_queries = 10000;
+    double query = ovf_bench::Measure([&](){
+        for (int i = 0; i < num_queries; i++)
+            reader.FindVectorBlocks(i % num_wps, region, found);
+    });
+    std::cout << "query:            " << std::setprecision(2) << (query * 1e6 / num_queries) << " us, "
+              << found.size() << " of " << num_vbs << " vector blocks" << std::endl;
+
+    google::protobuf::RepeatedPtrField<ovf::VectorBlock> vbs;
+    double fetch = ovf_bench::Measure([&](){
+        for (int i = 0; i < num_wps; i++)
+        {
+            reader.FindVectorBlocks(i, region, found);
+            reader.GetVectorBlocks(i, found, vbs);
+        }
+    });
+    std::cout << "query and fetch:  " << std::setprecision(3) << (fetch * 1e3 / num_wps) << " ms per work plane" << std::endl;
+
+    ovf::WorkPlane wp{};
+    size_t num_matches = 0;
+    double scan = ovf_bench::Measure([&](){
+        for (int i = 0; i < num_wps; i++)
+        {
+            reader.GetWorkPlane(i, wp);
+            for (const auto& vb : wp.vector_blocks())
+            {
+                const auto& points = vb.line_sequence().points();
+                auto box = rw::ComputePointBounds(rw::Span<const float>{points.data(), (size_t)points.size()}, 2);
+                num_matches += box.Intersects(region) ? 1 : 0;
+            }
+        }
+    });
+    std::cout << "decode and test:  " << (scan * 1e3 / num_wps) << " ms per work plane ("
+              << num_matches / num_wps << " matches)" << std::endl;
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Compares collecting all hatches of one part on one laser by decoding every work plane,
+ * by scanning the vector block headers of every work plane, and by querying the attribute
+ * index. Also measures building the attribute index and loading it from its file.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 50;
+    const int num_vbs = 1000;
+    const int num_points = 64;
+
+    std::string path = ovf_bench::TempPath("ovf_bench12_attribute_index.ovf");
+    {
+        auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+        for (auto& wp : *job.mutable_work_planes())
+        {
+            for (int i_vb = 0; i_vb < wp.vector_blocks_size(); i_vb++)
+            {
+                auto vb = wp.mutable_vector_blocks(i_vb);
+                vb->set_laser_index(i_vb % 4);
+                vb->mutable_meta_data()->set_part_key((i_vb / 4) % 16);
+                if (i_vb % 3 == 0)
+                {
+                    auto points = vb->line_sequence().points();
+                    vb->mutable__hatches()->mutable_points()->Swap(&points);
+                }
+            }
+        }
+
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(job, path);
+    }
+    std::filesystem::remove(path + rw::kIndexFileExtension);
+    std::filesystem::remove(path + rw::kAttributeIndexFileExtension);
+
+    const rw::VectorBlockFilter filter{3, 5, ovf::VectorBlock::kHatches};
+    int64_t num_full = 0, num_headers = 0, num_indexed = 0;
+
+    rw::OvfFileReader reader{0, 1};
+    ovf::Job job{};
+    reader.OpenFile(path, job, {}, rw::LutLoading::kIndexFile);
+
+    ovf::WorkPlane wp{};
+    double full = ovf_bench::Measure([&](){
+        for (int i = 0; i < num_wps; i++)
+        {
+            reader.GetWorkPlane(i, wp);
+            for (const auto& vb : wp.vector_blocks())
+                num_full += filter.Matches({vb.laser_index(), vb.meta_data().part_key(), vb.vector_data_case()});
+        }
+    });
+
+    google::protobuf::RepeatedPtrField<ovf::VectorBlock> headers, vbs;
+    std::vector<int> selected;
+    double scanned = ovf_bench::Measure([&](){
+        for (int i = 0; i < num_wps; i++)
+        {
+            reader.GetVectorBlockHeaders(i, headers);
+            selected.clear();
+            for (int i_vb = 0; i_vb < headers.size(); i_vb++)
+            {
+                const auto& vb = headers.Get(i_vb);
+                if (filter.Matches({vb.laser_index(), vb.meta_data().part_key(), vb.vector_data_case()}))
+                    selected.push_back(i_vb);
+            }
+            reader.GetVectorBlocks(i, selected, vbs);
+            num_headers += vbs.size();
+        }
+    });
+
+    double build = ovf_bench::Measure([&](){ reader.BuildAttributeIndex(); });
+
+    double indexed = ovf_bench::Measure([&](){
+        for (int i = 0; i < num_wps; i++)
+        {
+            reader.GetVectorBlocks(i, filter, vbs);
+            num_indexed += vbs.size();
+        }
+    });
+
+    std::vector<rw::VectorBlockLocation> locations;
+    double query = ovf_bench::Measure([&](){ reader.FindVectorBlocks(filter, locations); });
+
+    // reopening loads the attribute index file written by the build
+    reader.CloseFile();
+    reader.OpenFile(path, job, {}, rw::LutLoading::kIndexFile);
+    double load = ovf_bench::Measure([&](){ reader.BuildAttributeIndex(); });
+
+    std::cout << std::fixed << std::setprecision(3)
+              << num_wps << " work planes x " << num_vbs << " vector blocks, " << locations.size() << " selected" << std::endl
+              << "decode and filter:   " << (full * 1e3) << " ms (" << num_full << " matches)" << std::endl
+              << "headers and fetch:   " << (scanned * 1e3) << " ms (" << num_headers << " matches)" << std::endl
+              << "build index:         " << (build * 1e3) << " ms" << std::endl
+              << "load index file:     " << (load * 1e3) << " ms" << std::endl
+              << "query all planes:    " << (query * 1e3) << " ms" << std::endl
+              << "indexed fetch:       " << (indexed * 1e3) << " ms (" << num_indexed << " matches), "
+              << std::setprecision(1) << (full / indexed) << "x vs decode, " << (scanned / indexed) << "x vs headers" << std::endl;
+
+    reader.CloseFile();
+    std::filesystem::remove(path + rw::kIndexFileExtension);
+    std::filesystem::remove(path + rw::kAttributeIndexFileExtension);
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Compares computing the mark length, point count and exposure time of a job by decoding
+ * every work plane and looping over the coordinates, by the statistics module over decoded
+ * work planes, and by the statistics module over zero-copy views of the vector blocks.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 20;
+    const int num_vbs = 500;
+    const int num_points = 256;
+
+    std::string path = ovf_bench::TempPath("ovf_bench13_job_statistics.ovf");
+    {
+        auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+        for (int key = 0; key < 4; key++)
+        {
+            (*job.mutable_marking_params_map())[key].set_laser_speed_in_mm_per_s(500.0f + 100.0f * key);
+            (*job.mutable_marking_params_map())[key].set_jump_speed_in_mm_s(5000.0f);
+        }
+
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(job, path);
+    }
+
+    for (int num_threads : {1, 4})
+    {
+        rw::OvfFileReader reader{0, num_threads};
+        ovf::Job job{};
+        reader.OpenFile(path, job);
+
+        double scalar_time = 0.0;
+        ovf::WorkPlane wp{};
+        double scalar = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_wps; i++)
+            {
+                reader.GetWorkPlane(i, wp);
+                for (const auto& vb : wp.vector_blocks())
+                {
+                    const auto& points = vb.line_sequence().points();
+                    double length = 0.0;
+                    for (int i_pt = 2; i_pt + 1 < points.size(); i_pt += 2)
+                    {
+                        const double dx = points[i_pt] - points[i_pt - 2];
+                        const double dy = points[i_pt + 1] - points[i_pt - 1];
+                        length += std::sqrt(dx * dx + dy * dy);
+                    }
+                    scalar_time += length / job.marking_params_map().at(vb.marking_params_key()).laser_speed_in_mm_per_s();
+                }
+            }
+        });
+
+        double messages_time = 0.0;
+        double messages = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_wps; i++)
+            {
+                reader.GetWorkPlane(i, wp);
+                messages_time += rw::ComputeWorkPlaneStatistics(wp, job.marking_params_map()).total.mark_time_in_s;
+            }
+        });
+
+        rw::JobStatistics statistics;
+        double views = ovf_bench::Measure([&](){ statistics = reader.ComputeStatistics(); });
+
+        std::cout << num_threads << " thread(s), " << num_wps << " work planes x " << num_vbs << " blocks x " << num_points << " points: "
+                  << std::fixed << std::setprecision(3)
+                  << "scalar loops " << (scalar * 1e3) << " ms, "
+                  << "statistics of messages " << (messages * 1e3) << " ms, "
+                  << "statistics of views " << (views * 1e3) << " ms, "
+                  << std::setprecision(1) << (scalar / views) << "x" << std::endl
+                  << std::setprecision(3) << "  mark time " << scalar_time << " / " << messages_time << " / " << statistics.total.mark_time_in_s
+                  << " s, load balance " << statistics.load_balance() << std::endl;
+
+        reader.CloseFile();
+    }
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+#include <atomic>
+#include <cstring>
+#include <numeric>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the cost of writing checksums, the throughput of verifying a whole file compared
+ * to summing its bytes, and the overhead of verifying each work plane on first read.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 40;
+    const int num_vbs = 1000;
+    const int num_points = 256;
+
+    std::string path = ovf_bench::TempPath("ovf_bench14_checksums.ovf");
+    auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+
+    for (auto mode : {rw::ChecksumMode::kNone, rw::ChecksumMode::kWorkPlanes, rw::ChecksumMode::kVectorBlocks})
+    {
+        // overwriting the previous file would add the cost of truncating it
+        std::filesystem::remove(path);
+        double write = ovf_bench::Measure([&](){
+            rw::WriterOptions options{};
+            options.checksum_mode = mode;
+            rw::OvfFileWriter writer{options};
+            writer.WriteFullJob(job, path);
+        });
+        std::cout << "write with checksum mode " << (int)mode << ": " << std::fixed << std::setprecision(3)
+                  << (write * 1e3) << " ms, " << std::filesystem::file_size(path) << " bytes" << std::endl;
+    }
+
+    // baseline for the memory bandwidth of a single thread, summing the file as 64 bit words
+    double file_size_gb;
+    {
+        std::ifstream ifs{path, std::ios::binary};
+        std::vector<uint8_t> bytes{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+        std::vector<uint64_t> words(bytes.size() / sizeof(uint64_t));
+        std::memcpy(words.data(), bytes.data(), words.size() * sizeof(uint64_t));
+        file_size_gb = bytes.size() / 1e9;
+
+        uint64_t sum = 0;
+        double summing = ovf_bench::Measure([&](){ sum += std::accumulate(words.begin(), words.end(), uint64_t{0}); });
+        std::cout << "summing the file: " << std::setprecision(2) << (file_size_gb / summing) << " GB/s (" << (sum & 1) << ")" << std::endl;
+    }
+
+    for (int num_threads : {1, 4})
+    {
+        rw::OvfFileReader reader{0, num_threads};
+        ovf::Job job_shell{};
+        reader.OpenFile(path, job_shell);
+
+        // the first pass pages the file in
+        reader.Verify();
+        rw::VerificationResult result;
+        double verify = ovf_bench::Measure([&](){ result = reader.Verify(); });
+        std::cout << num_threads << " thread(s): verify " << std::setprecision(3) << (verify * 1e3) << " ms, "
+                  << std::setprecision(2) << (file_size_gb / verify) << " GB/s, intact " << result.is_intact() << std::endl;
+    }
+
+    for (bool verify_on_first_read : {false, true})
+    {
+        rw::OvfFileReader reader{0};
+        reader.VerifyOnFirstRead(verify_on_first_read);
+        ovf::Job job_shell{};
+        reader.OpenFile(path, job_shell);
+
+        ovf::WorkPlane wp{};
+        double read = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_wps; i++)
+                reader.GetWorkPlane(i, wp);
+        });
+        std::cout << "reading all work planes once, " << (verify_on_first_read ? "verified" : "not verified") << ": "
+                  << std::setprecision(3) << (read * 1e3) << " ms" << std::endl;
+    }
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "work_plane_stream.h"
+#include "memory_mapping.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the time and page faults of reading all work planes once with a default,
+ * a pre-populated and a locked mapping, and the resident set while streaming the job
+ * with and without releasing the decoded work planes.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 40;
+    const int num_vbs = 1000;
+    const int num_points = 256;
+
+    std::string path = ovf_bench::TempPath("ovf_bench15_mapping_residency.ovf");
+    auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+    rw::OvfFileWriter{}.WriteFullJob(job, path);
+    std::cout << "file size: " << std::filesystem::file_size(path) / 1000000 << " MB" << std::endl;
+
+    const char *names[] = {"default", "populate", "lock"};
+    for (int variant = 0; variant < 3; variant++)
+    {
+        rw::MappingOptions options{};
+        options.populate = variant == 1;
+        options.lock = variant == 2;
+
+        rw::OvfFileReader reader{0};
+        ovf::Job job_shell{};
+        auto before = rw::GetProcessMemoryUsage();
+        double open;
+        try
+        {
+            open = ovf_bench::Measure([&](){ reader.OpenFile(path, job_shell, options); });
+        }
+        catch (const std::exception& e)
+        {
+            std::cout << names[variant] << ": " << e.what() << std::endl;
+            continue;
+        }
+        auto opened = rw::GetProcessMemoryUsage();
+
+        ovf::WorkPlane wp{};
+        double read = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_wps; i++)
+                reader.GetWorkPlane(i, wp);
+        });
+        auto after = rw::GetProcessMemoryUsage();
+        auto memory = reader.GetResidentMemory();
+
+        std::cout << std::fixed << std::setprecision(3) << names[variant] << ": open " << (open * 1e3) << " ms, "
+                  << (opened.page_faults - before.page_faults) << " faults; first read " << (read * 1e3) << " ms, "
+                  << (after.page_faults - opened.page_faults) << " faults; resident " << memory.resident_bytes / 1000000
+                  << " MB, locked " << memory.locked_bytes / 1000000 << " MB" << std::endl;
+    }
+
+    for (bool release_decoded : {false, true})
+    {
+        rw::OvfFileReader reader{0};
+        ovf::Job job_shell{};
+        reader.OpenFile(path, job_shell);
+
+        rw::WorkPlaneStreamOptions stream_options{};
+        stream_options.release_decoded = release_decoded;
+        size_t peak_resident = 0;
+        ovf::WorkPlane wp{};
+        double stream = ovf_bench::Measure([&](){
+            rw::WorkPlaneStream stream{reader, stream_options};
+            while (stream.Next(wp))
+                peak_resident = std::max(peak_resident, reader.GetResidentMemory().resident_bytes);
+        });
+
+        std::cout << "streaming, " << (release_decoded ? "releasing" : "keeping") << " decoded work planes: "
+                  << (stream * 1e3) << " ms, peak resident " << peak_resident / 1000000 << " MB, finally resident "
+                  << reader.GetResidentMemory().resident_bytes / 1000000 << " MB" << std::endl;
+    }
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
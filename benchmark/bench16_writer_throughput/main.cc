@@ -0,0 +1,104 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the throughput of writing a job with many small work planes, in MB/s and work
+ * planes per second, for different sizes of the write buffer, writing the full job at once
+ * and appending work planes and vector blocks in a partial write.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 1000;
+    const int num_vbs = 40;
+    const int num_points = 64;
+    const int num_repetitions = 3;
+
+    std::string path = ovf_bench::TempPath("ovf_bench16_writer_throughput.ovf");
+    auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+
+    auto report = [&](const std::string& name, double seconds){
+        const double file_size_mb = std::filesystem::file_size(path) / 1e6;
+        std::cout << std::fixed << std::setprecision(1) << name << ": " << (seconds * 1e3) << " ms, "
+                  << (file_size_mb / seconds) << " MB/s, " << std::setprecision(0) << (num_wps / seconds)
+                  << " work planes/s" << std::endl;
+    };
+
+    for (size_t buffer_size : {(size_t)0, (size_t)1 << 16, (size_t)1 << 20, rw::OutputFile::kDefaultBufferSize, (size_t)1 << 24})
+    {
+        // best of several runs, overwriting the previous file would add the cost of truncating it
+        double write = 1e9;
+        for (int i = 0; i < num_repetitions; i++)
+        {
+            std::filesystem::remove(path);
+            write = std::min(write, ovf_bench::Measure([&](){
+                rw::WriterOptions options{};
+                options.write_buffer_size = buffer_size;
+                rw::OvfFileWriter writer{options};
+                writer.WriteFullJob(job, path);
+            }));
+        }
+        report("full job, " + std::to_string(buffer_size >> 10) + " KiB buffer", write);
+    }
+
+    ovf::Job job_shell{job};
+    job_shell.clear_work_planes();
+    ovf::WorkPlane wp_shell{};
+    double write = 1e9;
+    for (int i = 0; i < num_repetitions; i++)
+    {
+        std::filesystem::remove(path);
+        write = std::min(write, ovf_bench::Measure([&](){
+            rw::OvfFileWriter writer{};
+            writer.StartWritePartial(job_shell, path);
+            for (const auto& wp : job.work_planes())
+            {
+                writer.AppendWorkPlane(wp_shell);
+                for (const auto& vb : wp.vector_blocks())
+                    writer.AppendVectorBlock(vb);
+            }
+            writer.FinishWrite();
+        }));
+    }
+    report("partial write, default buffer", write);
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_writer.h"
+#include "util.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures a partial write of layers built one after another, like a slicer does, appending
+ * them by copy, by move, and allocated on arenas. Building the layers is included in all
+ * variants and measured on its own as a baseline.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 40;
+    const int num_vbs = 1000;
+    const int num_points = 256;
+    const int num_repetitions = 3;
+
+    std::string path = ovf_bench::TempPath("ovf_bench17_append_moves.ovf");
+    auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+    ovf::Job job_shell{job};
+    job_shell.clear_work_planes();
+
+    auto best_of = [&](auto fn){
+        double best = 1e9;
+        for (int i = 0; i < num_repetitions; i++)
+        {
+            std::filesystem::remove(path);
+            best = std::min(best, ovf_bench::Measure(fn));
+        }
+        return best;
+    };
+    auto report = [&](const std::string& name, double seconds){
+        std::cout << std::fixed << std::setprecision(1) << name << ": " << (seconds * 1e3) << " ms" << std::endl;
+    };
+
+    double build = best_of([&](){
+        for (const auto& wp : job.work_planes())
+        {
+            ovf::WorkPlane layer{wp};
+        }
+    });
+    report("building the layers only", build);
+
+    report("append copies of work planes", best_of([&](){
+        rw::OvfFileWriter writer{};
+        writer.StartWritePartial(job_shell, path);
+        for (const auto& wp : job.work_planes())
+        {
+            ovf::WorkPlane layer{wp};
+            writer.AppendWorkPlane(layer);
+        }
+        writer.FinishWrite();
+    }));
+
+    report("append copies of vector blocks", best_of([&](){
+        rw::OvfFileWriter writer{};
+        writer.StartWritePartial(job_shell, path);
+        for (const auto& wp : job.work_planes())
+        {
+            ovf::WorkPlane layer{wp};
+            writer.AppendWorkPlane(ovf::WorkPlane{});
+            for (const auto& vb : layer.vector_blocks())
+                writer.AppendVectorBlock(vb);
+        }
+        writer.FinishWrite();
+    }));
+
+    report("append moved work planes", best_of([&](){
+        rw::OvfFileWriter writer{};
+        writer.StartWritePartial(job_shell, path);
+        for (const auto& wp : job.work_planes())
+        {
+            ovf::WorkPlane layer{wp};
+            writer.AppendWorkPlane(std::move(layer));
+        }
+        writer.FinishWrite();
+    }));
+
+    report("append moved vector blocks", best_of([&](){
+        rw::OvfFileWriter writer{};
+        writer.StartWritePartial(job_shell, path);
+        for (const auto& wp : job.work_planes())
+        {
+            ovf::WorkPlane layer{wp};
+            writer.AppendWorkPlane(ovf::WorkPlane{});
+            for (auto& vb : *layer.mutable_vector_blocks())
+                writer.AppendVectorBlock(std::move(vb));
+        }
+        writer.FinishWrite();
+    }));
+
+    // a layer is written when it is appended, so its arena can be reset right after
+    report("append arena allocated work planes", best_of([&](){
+        google::protobuf::Arena arena;
+        rw::OvfFileWriter writer{};
+        writer.StartWritePartial(job_shell, path);
+        for (int i = 0; i < num_wps; i++)
+        {
+            auto layer = ovf::util::CreateOnArena<ovf::WorkPlane>(arena);
+            *layer = job.work_planes(i);
+            writer.AppendWorkPlane(*layer);
+            arena.Reset();
+        }
+        writer.FinishWrite();
+    }));
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_writer.h"
+#include "memory_mapping.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the peak resident memory and the throughput of a partial write of a few large
+ * work planes, appending their vector blocks one at a time. The vector block appended is
+ * always the same, so the memory growth is the one of the writer.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 4;
+    const int num_vbs = 50000;
+    const int num_points = 512;
+    const int sample_interval = 1000;
+
+    std::string path = ovf_bench::TempPath("ovf_bench18_streaming_partial_write.ovf");
+    auto job_shell = ovf_bench::MakeSyntheticJob(1, 1, num_points);
+    const ovf::VectorBlock vb = job_shell.work_planes(0).vector_blocks(0);
+    job_shell.clear_work_planes();
+    const ovf::WorkPlane wp_shell{};
+
+    std::filesystem::remove(path);
+    const size_t resident_before = rw::GetProcessMemoryUsage().resident_bytes;
+    size_t peak_resident = resident_before;
+    double write = ovf_bench::Measure([&](){
+        rw::OvfFileWriter writer{};
+        writer.StartWritePartial(job_shell, path);
+        for (int i_wp = 0; i_wp < num_wps; i_wp++)
+        {
+            writer.AppendWorkPlane(wp_shell);
+            for (int i_vb = 0; i_vb < num_vbs; i_vb++)
+            {
+                writer.AppendVectorBlock(vb);
+                if (i_vb % sample_interval == 0)
+                    peak_resident = std::max(peak_resident, rw::GetProcessMemoryUsage().resident_bytes);
+            }
+        }
+        writer.FinishWrite();
+    });
+
+    const double file_size_mb = std::filesystem::file_size(path) / 1e6;
+    std::cout << std::fixed << std::setprecision(1) << "partial write of " << num_wps << " work planes, "
+              << (file_size_mb / num_wps) << " MB each: " << (write * 1e3) << " ms, " << (file_size_mb / write)
+              << " MB/s, peak resident growth " << (peak_resident - resident_before) / 1e6 << " MB" << std::endl;
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the throughput of writing a job, in MB/s, depending on the number of threads
+ * serializing vector blocks, for the full job and for a partial write moving its vector blocks
+ * into the writer. Serialization only scales up to the number of hardware threads, reported first.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 200;
+    const int num_vbs = 200;
+    const int num_points = 256;
+    const int num_repetitions = 3;
+
+    std::string path = ovf_bench::TempPath("ovf_bench19_parallel_serialization.ovf");
+    auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+    ovf::Job job_shell{job};
+    job_shell.clear_work_planes();
+
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+
+    auto report = [&](const std::string& name, double seconds){
+        const double file_size_mb = std::filesystem::file_size(path) / 1e6;
+        std::cout << std::fixed << std::setprecision(1) << name << ": " << (seconds * 1e3) << " ms, "
+                  << (file_size_mb / seconds) << " MB/s" << std::endl;
+    };
+
+    for (int num_threads : {1, 2, 4, 8})
+    {
+        rw::WriterOptions options{};
+        options.checksum_mode = rw::ChecksumMode::kWorkPlanes;
+        options.num_threads = num_threads;
+
+        double full = 1e9;
+        double partial = 1e9;
+        for (int i = 0; i < num_repetitions; i++)
+        {
+            std::filesystem::remove(path);
+            full = std::min(full, ovf_bench::Measure([&](){
+                rw::OvfFileWriter writer{options};
+                writer.WriteFullJob(job, path);
+            }));
+
+            // copies are made outside of the measurement, so both cases serialize the same data
+            ovf::Job job_copy{job};
+            std::filesystem::remove(path);
+            partial = std::min(partial, ovf_bench::Measure([&](){
+                rw::OvfFileWriter writer{options};
+                writer.StartWritePartial(job_shell, path);
+                for (auto& wp : *job_copy.mutable_work_planes())
+                    writer.AppendWorkPlane(std::move(wp));
+                writer.FinishWrite();
+            }));
+        }
+        report("full job, " + std::to_string(num_threads) + " threads", full);
+        report("partial write, " + std::to_string(num_threads) + " threads", partial);
+    }
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
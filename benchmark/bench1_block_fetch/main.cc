@@ -0,0 +1,164 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the latency of fetching single vector blocks with the different
+ * mapping modes. MappingMode::kPerView corresponds to the previous behaviour
+ * of creating and releasing a mapping for every fetch. Additionally measures
+ * zero-copy access through VectorBlockView, and fetching the blocks of one
+ * laser one by one compared to a single GetVectorBlocks() call.
+ */
+int main(int argc, char const *argv[])
+{
+    std::string path;
+    if (argc >= 2)
+    {
+        path = argv[1];
+    }
+    else
+    {
+        path = ovf_bench::TempPath("ovf_bench1_block_fetch.ovf");
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(ovf_bench::MakeSyntheticJob(200, 500, 64), path);
+    }
+
+    const std::pair<const char*, rw::MappingMode> modes[] = {
+        {"per view  ", rw::MappingMode::kPerView},
+        {"windowed  ", rw::MappingMode::kWindowed},
+        {"persistent", rw::MappingMode::kPersistent},
+    };
+
+    for (const auto& [name, mode] : modes)
+    {
+        rw::OvfFileReader reader{};
+        ovf::Job job{};
+
+        rw::MappingOptions options{};
+        options.mode = mode;
+        options.window_size = (size_t)1 << 22;
+        reader.OpenFile(path, job, options);
+        reader.ClearCache();
+
+        size_t num_blocks = 0;
+        ovf::VectorBlock vb{};
+        ovf::WorkPlane wp{};
+
+        // warm up the page cache and collect block counts
+        std::vector<int> block_counts;
+        for (int i_wp = 0; i_wp < job.num_work_planes(); i_wp++)
+        {
+            reader.GetWorkPlane(i_wp, wp);
+            block_counts.push_back(wp.vector_blocks_size());
+        }
+
+        double seconds = ovf_bench::Measure([&](){
+            for (int i_wp = 0; i_wp < job.num_work_planes(); i_wp++)
+            {
+                for (int i_vb = 0; i_vb < block_counts[i_wp]; i_vb++)
+                {
+                    vb.Clear();
+                    reader.GetVectorBlock(i_wp, i_vb, vb);
+                    num_blocks++;
+                }
+            }
+        });
+
+        std::cout << name << ": " << std::fixed << std::setprecision(1)
+                  << (seconds * 1e9 / num_blocks) << " ns per vector block ("
+                  << num_blocks << " blocks)" << std::endl;
+
+        // every block of one laser, fetched one by one vs. as a batch
+        std::vector<std::vector<int>> laser_blocks(job.num_work_planes());
+        for (int i_wp = 0; i_wp < job.num_work_planes(); i_wp++)
+        {
+            for (int i_vb = 1; i_vb < block_counts[i_wp]; i_vb += 2)
+                laser_blocks[i_wp].push_back(i_vb);
+        }
+
+        size_t num_laser_blocks = 0;
+        double single_seconds = ovf_bench::Measure([&](){
+            for (int i_wp = 0; i_wp < job.num_work_planes(); i_wp++)
+            {
+                for (int i_vb : laser_blocks[i_wp])
+                {
+                    vb.Clear();
+                    reader.GetVectorBlock(i_wp, i_vb, vb);
+                    num_laser_blocks++;
+                }
+            }
+        });
+
+        google::protobuf::RepeatedPtrField<ovf::VectorBlock> vbs;
+        double batch_seconds = ovf_bench::Measure([&](){
+            for (int i_wp = 0; i_wp < job.num_work_planes(); i_wp++)
+                reader.GetVectorBlocks(i_wp, laser_blocks[i_wp], vbs);
+        });
+
+        std::cout << "  one laser : " << std::fixed << std::setprecision(1)
+                  << (single_seconds * 1e9 / num_laser_blocks) << " ns single, "
+                  << (batch_seconds * 1e9 / num_laser_blocks) << " ns batched per vector block" << std::endl;
+
+        if (mode != rw::MappingMode::kPersistent)
+            continue;
+
+        // zero-copy access to the coordinates, without parsing
+        double checksum = 0.0;
+        seconds = ovf_bench::Measure([&](){
+            for (int i_wp = 0; i_wp < job.num_work_planes(); i_wp++)
+            {
+                for (int i_vb = 0; i_vb < block_counts[i_wp]; i_vb++)
+                {
+                    auto view = reader.GetVectorBlockView(i_wp, i_vb);
+                    checksum += view.points()[0];
+                }
+            }
+        });
+
+        std::cout << "view      : " << std::fixed << std::setprecision(1)
+                  << (seconds * 1e9 / num_blocks) << " ns per vector block (checksum "
+                  << checksum << ")" << std::endl;
+    }
+
+    if (argc < 2)
+        std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
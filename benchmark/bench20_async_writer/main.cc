@@ -0,0 +1,96 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures how long a slicer loop appending work planes is blocked by the writer, for
+ * synchronous writes and for queued writes with different queue budgets, along with the
+ * total time until the write is finished, the peak queue memory and the time appends stalled
+ * on a full queue. Slicing is simulated by building each work plane before appending it.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 200;
+    const int num_vbs = 100;
+    const int num_points = 256;
+    const int num_repetitions = 3;
+
+    std::string path = ovf_bench::TempPath("ovf_bench20_async_writer.ovf");
+    auto job = ovf_bench::MakeSyntheticJob(num_wps, num_vbs, num_points);
+    ovf::Job job_shell{job};
+    job_shell.clear_work_planes();
+
+    for (size_t queue_budget : {(size_t)0, (size_t)1 << 20, (size_t)1 << 24, rw::OvfFileWriter::kDefaultQueueBudget})
+    {
+        double append = 1e9;
+        double total = 1e9;
+        rw::QueueStatistics statistics;
+        for (int i = 0; i < num_repetitions; i++)
+        {
+            std::filesystem::remove(path);
+            rw::WriterOptions options{};
+            options.queue_budget = queue_budget;
+            rw::OvfFileWriter writer{options};
+            double append_seconds = 0;
+            const double total_seconds = ovf_bench::Measure([&](){
+                writer.StartWritePartial(job_shell, path);
+                for (const auto& wp : job.work_planes())
+                {
+                    ovf::WorkPlane sliced{wp};
+                    append_seconds += ovf_bench::Measure([&](){ writer.AppendWorkPlane(std::move(sliced)); });
+                }
+                writer.FinishWrite();
+            });
+            if (total_seconds < total)
+                statistics = writer.GetQueueStatistics();
+            append = std::min(append, append_seconds);
+            total = std::min(total, total_seconds);
+        }
+
+        std::cout << std::fixed << std::setprecision(1) << (queue_budget == 0 ? std::string{"synchronous"} :
+                     "queued, " + std::to_string(queue_budget >> 10) + " KiB budget") << ": appends " << (append * 1e3)
+                  << " ms, total " << (total * 1e3) << " ms, peak queue " << (statistics.peak_queued_bytes >> 10)
+                  << " KiB, " << statistics.num_stalls << " stalls, " << (statistics.stall_seconds * 1e3) << " ms stalled" << std::endl;
+    }
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <functional>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the throughput of reading full work planes into heap allocated
+ * messages, compared to reading them into an arena that is reset per work plane.
+ */
+int main(int argc, char const *argv[])
+{
+    std::string path;
+    if (argc >= 2)
+    {
+        path = argv[1];
+    }
+    else
+    {
+        path = ovf_bench::TempPath("ovf_bench2_arena_read.ovf");
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(ovf_bench::MakeSyntheticJob(100, 2000, 32), path);
+    }
+
+    rw::OvfFileReader reader{};
+    ovf::Job job{};
+    reader.OpenFile(path, job);
+    reader.ClearCache();
+
+    size_t file_size = std::filesystem::file_size(path);
+
+    const std::pair<const char*, std::function<size_t(int)>> variants[] = {
+        {"heap, new message per work plane ", [&](int i_wp){
+            ovf::WorkPlane wp{};
+            reader.GetWorkPlane(i_wp, wp);
+            return (size_t)wp.vector_blocks_size();
+        }},
+        {"arena, reset per work plane      ", [&](int i_wp){
+            // the whole work plane is released at once on reset
+            static google::protobuf::Arena arena{};
+            arena.Reset();
+            auto wp = reader.GetWorkPlane(i_wp, arena);
+            return (size_t)wp->vector_blocks_size();
+        }},
+    };
+
+    for (const auto& [name, read] : variants)
+    {
+        // warm up the page cache
+        for (int i_wp = 0; i_wp < job.num_work_planes(); i_wp++)
+            read(i_wp);
+
+        size_t num_blocks = 0;
+        double seconds = ovf_bench::Measure([&](){
+            for (int i_wp = 0; i_wp < job.num_work_planes(); i_wp++)
+                num_blocks += read(i_wp);
+        });
+
+        std::cout << name << ": " << std::fixed << std::setprecision(1)
+                  << (job.num_work_planes() / seconds) << " work planes/s, "
+                  << (num_blocks / seconds / 1e6) << " M vector blocks/s, "
+                  << (file_size / seconds / (1 << 20)) << " MiB/s" << std::endl;
+    }
+
+    if (argc < 2)
+        std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <thread>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "work_plane_stream.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Simulates a machine consuming work planes at a fixed pace and measures how long
+ * the consumer waits for the next work plane, reading synchronously compared to
+ * reading through a WorkPlaneStream.
+ */
+int main(int argc, char const *argv[])
+{
+    std::string path;
+    if (argc >= 2)
+    {
+        path = argv[1];
+    }
+    else
+    {
+        path = ovf_bench::TempPath("ovf_bench3_read_ahead.ovf");
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(ovf_bench::MakeSyntheticJob(100, 2000, 32), path);
+    }
+
+    rw::OvfFileReader reader{};
+    ovf::Job job{};
+    rw::MappingOptions mapping_options{};
+    mapping_options.access_pattern = rw::AccessPattern::kSequential;
+    reader.OpenFile(path, job, mapping_options);
+    reader.ClearCache();
+
+    // the consumer takes as long per work plane as decoding it
+    ovf::WorkPlane wp{};
+    double decode_seconds = ovf_bench::Measure([&](){
+        for (int i_wp = 0; i_wp < reader.GetNumWorkPlanes(); i_wp++)
+            reader.GetWorkPlane(i_wp, wp);
+    }) / reader.GetNumWorkPlanes();
+    auto process = [&](){
+        std::this_thread::sleep_for(std::chrono::duration<double>(decode_seconds));
+    };
+
+    std::cout << "decoding    : " << std::fixed << std::setprecision(1)
+              << (decode_seconds * 1e3) << " ms per work plane" << std::endl;
+
+    double wait_seconds = 0.0;
+    for (int i_wp = 0; i_wp < reader.GetNumWorkPlanes(); i_wp++)
+    {
+        wait_seconds += ovf_bench::Measure([&](){ reader.GetWorkPlane(i_wp, wp); });
+        process();
+    }
+
+    std::cout << "synchronous : " << std::fixed << std::setprecision(3)
+              << (wait_seconds * 1e3 / reader.GetNumWorkPlanes()) << " ms wait per work plane" << std::endl;
+
+    for (int look_ahead : {1, 4})
+    {
+        rw::WorkPlaneStreamOptions options{};
+        options.look_ahead = look_ahead;
+        rw::WorkPlaneStream stream{reader, options};
+
+        wait_seconds = 0.0;
+        bool has_next = true;
+        while (has_next)
+        {
+            wait_seconds += ovf_bench::Measure([&](){ has_next = stream.Next(wp); });
+            if (has_next)
+                process();
+        }
+
+        std::cout << "look ahead " << look_ahead << ": " << std::fixed << std::setprecision(3)
+                  << (wait_seconds * 1e3 / reader.GetNumWorkPlanes()) << " ms wait per work plane" << std::endl;
+    }
+
+    if (argc < 2)
+        std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
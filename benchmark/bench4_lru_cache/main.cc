@@ -0,0 +1,104 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Simulates scrubbing back and forth through the work planes around a current
+ * position, as done in an HMI, and measures the time per work plane without a
+ * cache and with byte budgeted caches of recently used work planes.
+ */
+int main(int argc, char const *argv[])
+{
+    std::string path;
+    if (argc >= 2)
+    {
+        path = argv[1];
+    }
+    else
+    {
+        path = ovf_bench::TempPath("ovf_bench4_lru_cache.ovf");
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(ovf_bench::MakeSyntheticJob(200, 1000, 32), path);
+    }
+
+    rw::OvfFileReader reader{};
+    ovf::Job job{};
+    reader.OpenFile(path, job);
+    reader.ClearCache();
+
+    // slowly advancing position, scrubbing up to 10 work planes back and forth
+    std::vector<int> accesses;
+    for (int i = 0; i < 2000; i++)
+    {
+        int i_wp = i / 10 + (int)((i * 7919) % 21) - 10;
+        accesses.push_back(std::clamp(i_wp, 0, reader.GetNumWorkPlanes() - 1));
+    }
+
+    ovf::WorkPlane wp{};
+    reader.GetWorkPlane(0, wp);
+    const size_t wp_size = (size_t)wp.SpaceUsedLong();
+
+    for (int budget_work_planes : {0, 8, 32})
+    {
+        if (budget_work_planes > 0)
+            reader.CacheRecentlyUsed(wp_size * budget_work_planes);
+        else
+            reader.ClearCache();
+
+        double seconds = ovf_bench::Measure([&](){
+            for (int i_wp : accesses)
+                reader.GetWorkPlane(i_wp, wp);
+        });
+
+        auto stats = reader.GetCacheStatistics();
+        std::cout << "budget " << std::setw(2) << budget_work_planes << " work planes ("
+                  << std::setw(4) << (wp_size * budget_work_planes >> 20) << " MiB): "
+                  << std::fixed << std::setprecision(3)
+                  << (seconds * 1e3 / accesses.size()) << " ms per work plane, "
+                  << stats.hits << " hits, " << stats.misses << " misses, "
+                  << stats.evictions << " evictions" << std::endl;
+    }
+
+    if (argc < 2)
+        std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the time to open a job with many work planes, depending on when the
+ * work plane luts are loaded, and the time until the first work plane shell is read.
+ * The index file is written by the first open with kIndexFile and used by the second.
+ */
+int main(int argc, char const *argv[])
+{
+    std::string path;
+    if (argc >= 2)
+    {
+        path = argv[1];
+    }
+    else
+    {
+        path = ovf_bench::TempPath("ovf_bench5_open_latency.ovf");
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(ovf_bench::MakeSyntheticJob(20000, 20, 8), path);
+    }
+
+    const std::pair<const char*, rw::LutLoading> modes[] = {
+        {"eager     ", rw::LutLoading::kEager},
+        {"lazy      ", rw::LutLoading::kLazy},
+        {"background", rw::LutLoading::kBackground},
+        {"index new ", rw::LutLoading::kIndexFile},
+        {"index file", rw::LutLoading::kIndexFile},
+    };
+
+    const std::string index_path = path + rw::kIndexFileExtension;
+    std::filesystem::remove(index_path);
+
+    for (const auto& [name, lut_loading] : modes)
+    {
+        // never cache the job automatically, that would read all luts
+        rw::OvfFileReader reader{0};
+        ovf::Job job{};
+
+        double open_seconds = ovf_bench::Measure([&](){
+            reader.OpenFile(path, job, {}, lut_loading);
+        });
+
+        ovf::WorkPlane wp{};
+        double first_seconds = ovf_bench::Measure([&](){
+            reader.GetWorkPlaneShell(0, wp);
+        });
+
+        std::cout << name << ": " << std::fixed << std::setprecision(3)
+                  << (open_seconds * 1e3) << " ms to open, "
+                  << (first_seconds * 1e3) << " ms to the first work plane shell ("
+                  << reader.GetNumWorkPlanes() << " work planes)" << std::endl;
+    }
+
+    std::filesystem::remove(index_path);
+    if (argc < 2)
+        std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
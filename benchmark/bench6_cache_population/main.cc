@@ -0,0 +1,102 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the time to cache a full job with different numbers of threads, and
+ * the time until CacheFullJobAsync() returns.
+ */
+int main(int argc, char const *argv[])
+{
+    std::string path;
+    if (argc >= 2)
+    {
+        path = argv[1];
+    }
+    else
+    {
+        path = ovf_bench::TempPath("ovf_bench6_cache_population.ovf");
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(ovf_bench::MakeSyntheticJob(200, 1000, 32), path);
+    }
+
+    const int max_threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    std::vector<int> thread_counts{1, 2, 4, max_threads};
+    std::sort(thread_counts.begin(), thread_counts.end());
+    thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()), thread_counts.end());
+
+    for (int num_threads : thread_counts)
+    {
+        rw::OvfFileReader reader{0, num_threads};
+        ovf::Job job{};
+        reader.OpenFile(path, job);
+
+        // warm up the page cache
+        reader.CacheFullJob();
+        reader.ClearCache();
+
+        double seconds = ovf_bench::Measure([&](){ reader.CacheFullJob(); });
+
+        std::cout << std::setw(2) << num_threads << " threads   : " << std::fixed << std::setprecision(1)
+                  << (seconds * 1e3) << " ms to cache the full job" << std::endl;
+
+        if (num_threads != max_threads)
+            continue;
+
+        reader.ClearCache();
+        double async_seconds = ovf_bench::Measure([&](){ reader.CacheFullJobAsync(); });
+        double ready_seconds = async_seconds + ovf_bench::Measure([&](){
+            while (!reader.IsFullJobCached())
+                std::this_thread::yield();
+        });
+
+        std::cout << std::setw(2) << num_threads << " threads, async: " << std::fixed << std::setprecision(3)
+                  << (async_seconds * 1e3) << " ms to return, "
+                  << std::setprecision(1) << (ready_seconds * 1e3) << " ms until cached" << std::endl;
+    }
+
+    if (argc < 2)
+        std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <random>
+#include <string>
+#include <stdexcept>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "ovf_lut.pb.h"
+#include "job_index.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Compares the memory usage and lookup latency of keeping one WorkPlaneLUT message
+ * per work plane against the flat JobIndex, for a job with a million vector blocks.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_work_planes = 2000;
+    const int num_vector_blocks = 500;
+
+    // synthetic luts, as stored in a file
+    ovf::JobLUT job_lut{};
+    std::vector<ovf::WorkPlaneLUT> wp_luts(num_work_planes);
+    uint64_t position = 12;
+    for (int i_wp = 0; i_wp < num_work_planes; i_wp++)
+    {
+        job_lut.add_workplanepositions(position);
+        position += 8;
+        for (int i_vb = 0; i_vb < num_vector_blocks; i_vb++)
+        {
+            wp_luts[i_wp].add_vectorblockspositions(position);
+            position += 100 + (i_vb % 7) * 16;
+        }
+        wp_luts[i_wp].set_workplaneshellposition(position);
+        position += 40;
+    }
+    job_lut.set_jobshellposition(position);
+
+    // parsed like the reader did, instead of built element by element
+    for (auto& wpl : wp_luts)
+    {
+        std::string serialized = wpl.SerializeAsString();
+        wpl = ovf::WorkPlaneLUT{};
+        wpl.ParseFromString(serialized);
+    }
+
+    size_t lut_bytes = wp_luts.capacity() * sizeof(ovf::WorkPlaneLUT);
+    for (const auto& wpl : wp_luts)
+        lut_bytes += (size_t)wpl.SpaceUsedLong() - sizeof(ovf::WorkPlaneLUT);
+
+    rw::JobIndex index{job_lut};
+    index.IndexAll([&](int i, ovf::WorkPlaneLUT& wpl){ wpl.CopyFrom(wp_luts[i]); });
+
+    std::cout << "memory, lut messages : " << std::fixed << std::setprecision(2)
+              << (lut_bytes / double(1 << 20)) << " MiB" << std::endl;
+    std::cout << "memory, flat index   : " << std::fixed << std::setprecision(2)
+              << (index.SpaceUsed() / double(1 << 20)) << " MiB" << std::endl;
+
+    // random vector block lookups
+    std::mt19937 rng{42};
+    std::vector<std::pair<int, int>> lookups(1000000);
+    for (auto& lookup : lookups)
+        lookup = {(int)(rng() % num_work_planes), (int)(rng() % num_vector_blocks)};
+
+    uint64_t checksum = 0;
+    double lut_seconds = ovf_bench::Measure([&](){
+        for (const auto& [i_wp, i_vb] : lookups)
+        {
+            // same validation as the index
+            if (i_wp < 0 || i_wp >= (int)wp_luts.size())
+                throw std::runtime_error("Invalid work plane index");
+            const auto& wpl = wp_luts[i_wp];
+            if (i_vb < 0 || i_vb >= wpl.vectorblockspositions_size())
+                throw std::runtime_error("Invalid vector block index");
+            uint64_t end = i_vb < wpl.vectorblockspositions_size() - 1
+                ? wpl.vectorblockspositions(i_vb + 1)
+                : wpl.workplaneshellposition();
+            checksum += end - wpl.vectorblockspositions(i_vb);
+        }
+    });
+
+    auto load = [&](int i, ovf::WorkPlaneLUT& wpl){ wpl.CopyFrom(wp_luts[i]); };
+    double index_seconds = ovf_bench::Measure([&](){
+        for (const auto& [i_wp, i_vb] : lookups)
+        {
+            size_t start, end;
+            index.GetWorkPlane(i_wp, load).GetVectorBlockRange(i_vb, start, end);
+            checksum -= end - start;
+        }
+    });
+
+    std::cout << "lookup, lut messages : " << std::fixed << std::setprecision(1)
+              << (lut_seconds * 1e9 / lookups.size()) << " ns" << std::endl;
+    std::cout << "lookup, flat index   : " << std::fixed << std::setprecision(1)
+              << (index_seconds * 1e9 / lookups.size()) << " ns (checksum " << checksum << ")" << std::endl;
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Measures the throughput of small reads from many threads at once, i.e. zero-copy
+ * views of vector blocks, where entering and leaving the read path dominates.
+ */
+int main(int argc, char const *argv[])
+{
+    std::string path = ovf_bench::TempPath("ovf_bench8_concurrent_reads.ovf");
+    {
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(ovf_bench::MakeSyntheticJob(50, 200, 16), path);
+    }
+
+    rw::OvfFileReader reader{0};
+    ovf::Job job{};
+    reader.OpenFile(path, job);
+
+    const int reads_per_thread = 1000000;
+    const int max_threads = std::max(16, (int)std::thread::hardware_concurrency());
+
+    for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2)
+    {
+        std::atomic<size_t> num_points{0};
+        double seconds = ovf_bench::Measure([&](){
+            std::vector<std::thread> threads;
+            for (int i_thread = 0; i_thread < num_threads; i_thread++)
+            {
+                threads.emplace_back([&, i_thread](){
+                    size_t points = 0;
+                    for (int i = 0; i < reads_per_thread; i++)
+                    {
+                        auto view = reader.GetVectorBlockView((i + i_thread) % 50, i % 200);
+                        points += view.points().size();
+                    }
+                    num_points += points;
+                });
+            }
+            for (auto& thread : threads)
+                thread.join();
+        });
+
+        std::cout << std::setw(2) << num_threads << " threads: " << std::fixed << std::setprecision(1)
+                  << (num_threads * (double)reads_per_thread / seconds / 1e6) << " M reads/s, "
+                  << (seconds * 1e9 / reads_per_thread) << " ns per read and thread ("
+                  << num_points << " points)" << std::endl;
+    }
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+#include <atomic>
+#include <random>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "bench_common.h"
+
+namespace ovf = open_vector_format;
+namespace rw = open_vector_format::reader_writer;
+
+/**
+ * Compares reading through the memory mapping with reading into buffers, for streaming
+ * whole work planes, single vector blocks at random and batches of scattered vector blocks.
+ * The file is in the page cache for both backends, so this measures the cost of the
+ * backends themselves, not of the storage.
+ */
+int main(int argc, char const *argv[])
+{
+    const int num_wps = 100;
+    const int num_vbs = 500;
+
+    std::string path = ovf_bench::TempPath("ovf_bench9_io_backend.ovf");
+    {
+        rw::OvfFileWriter writer{};
+        writer.WriteFullJob(ovf_bench::MakeSyntheticJob(num_wps, num_vbs, 64), path);
+    }
+
+    const std::pair<const char*, rw::IoBackend> backends[] = {
+        {"mmap    ", rw::IoBackend::kMemoryMapping},
+        {"buffered", rw::IoBackend::kBufferedRead},
+    };
+
+    for (const auto& [name, io_backend] : backends)
+    {
+        rw::MappingOptions options{};
+        options.io_backend = io_backend;
+
+        rw::OvfFileReader reader{0};
+        ovf::Job job{};
+        reader.OpenFile(path, job, options);
+
+        ovf::WorkPlane wp{};
+        double sequential = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_wps; i++)
+                reader.GetWorkPlane(i, wp);
+        });
+
+        const int num_random_reads = 100000;
+        std::mt19937 random{42};
+        ovf::VectorBlock vb{};
+        double random_reads = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_random_reads; i++)
+                reader.GetVectorBlock((int)(random() % num_wps), (int)(random() % num_vbs), vb);
+        });
+
+        // every 8th vector block, so no two of them are adjacent in the file
+        std::vector<int> indices;
+        for (int i = 0; i < num_vbs; i += 8)
+            indices.push_back(i);
+
+        const int num_batches = 2000;
+        google::protobuf::RepeatedPtrField<ovf::VectorBlock> vbs;
+        double batches = ovf_bench::Measure([&](){
+            for (int i = 0; i < num_batches; i++)
+                reader.GetVectorBlocks(i % num_wps, indices, vbs);
+        });
+
+        std::cout << name << std::fixed << std::setprecision(2)
+                  << "  work planes: " << (sequential * 1e3 / num_wps) << " ms each"
+                  << "  random vector blocks: " << (random_reads * 1e6 / num_random_reads) << " us each"
+                  << "  batches of " << indices.size() << ": " << (batches * 1e6 / num_batches) << " us each" << std::endl;
+
+        reader.CloseFile();
+    }
+
+    std::filesystem::remove(path);
+
+    std::cout << "Finished" << std::endl;
+    return 0;
+}
\ No newline at end of file
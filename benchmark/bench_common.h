@@ -0,0 +1,96 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <iostream>
+#include <filesystem>
+
+#include "open_vector_format.pb.h"
+
+namespace ovf_bench {
+
+namespace ovf = open_vector_format;
+
+/**
+ * @brief Creates a synthetic job of line sequence vector blocks.
+ * 
+ * @param num_work_planes Number of work planes in the job.
+ * @param num_vector_blocks Number of vector blocks per work plane.
+ * @param num_points Number of coordinates per vector block.
+ */
+inline ovf::Job MakeSyntheticJob(int num_work_planes, int num_vector_blocks, int num_points)
+{
+    ovf::Job job{};
+    job.mutable_job_meta_data()->set_job_name("benchmark");
+    job.set_num_work_planes(num_work_planes);
+
+    for (int i_wp = 0; i_wp < num_work_planes; i_wp++)
+    {
+        auto wp = job.add_work_planes();
+        wp->set_z_pos_in_mm(0.03f * i_wp);
+        for (int i_vb = 0; i_vb < num_vector_blocks; i_vb++)
+        {
+            auto vb = wp->add_vector_blocks();
+            vb->set_marking_params_key(i_vb % 4);
+            vb->set_laser_index(i_vb % 2);
+            auto points = vb->mutable_line_sequence()->mutable_points();
+            points->Reserve(num_points);
+            for (int i_pt = 0; i_pt < num_points; i_pt++)
+                points->Add((float)((i_pt * 7 + i_vb * 13 + i_wp) % 1000) * 0.1f);
+        }
+    }
+
+    return job;
+}
+
+/**
+ * @brief Path of a scratch file in the system temporary directory.
+ */
+inline std::string TempPath(const std::string& name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+/**
+ * @brief Measures the wall clock time of a callable.
+ * 
+ * @return double The elapsed time in seconds.
+ */
+template <class Fn>
+double Measure(Fn fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,231 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "open_vector_format.pb.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief The attributes of a vector block by which the vector blocks of a job are indexed.
+ */
+struct VectorBlockAttributes
+{
+    /** The index of the laser the vector block is assigned to. */
+    int32_t laser_index = 0;
+
+    /** The part key from the meta data of the vector block. */
+    int32_t part_key = 0;
+
+    /** Which of the vector data types is set, a VectorBlock::VectorDataCase. */
+    int32_t vector_data_case = VectorBlock::VECTOR_DATA_NOT_SET;
+};
+
+/**
+ * @brief Selects vector blocks by their attributes. Attributes which are not set match any value.
+ */
+struct VectorBlockFilter
+{
+    std::optional<int32_t> laser_index;
+    std::optional<int32_t> part_key;
+    std::optional<VectorBlock::VectorDataCase> vector_data_case;
+
+    /** Whether vector blocks with the given attributes are selected. */
+    bool Matches(const VectorBlockAttributes& attributes) const
+    {
+        return (!laser_index.has_value() || *laser_index == attributes.laser_index) &&
+               (!part_key.has_value() || *part_key == attributes.part_key) &&
+               (!vector_data_case.has_value() || *vector_data_case == attributes.vector_data_case);
+    }
+};
+
+/**
+ * @brief The position of a vector block within a job.
+ */
+struct VectorBlockLocation
+{
+    int i_work_plane = 0;
+    int i_vector_block = 0;
+
+    bool operator==(const VectorBlockLocation& other) const
+    {
+        return i_work_plane == other.i_work_plane && i_vector_block == other.i_vector_block;
+    }
+
+    bool operator!=(const VectorBlockLocation& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Inverted index of the vector blocks of a job by laser index, part key and vector data type.
+ * 
+ * The attributes of all vector blocks are stored in a single array in file order, numbering
+ * the vector blocks across all work planes. For every value of each attribute, the numbers of
+ * the vector blocks with that value are stored in ascending order. A query walks the shortest
+ * of these lists among the attributes it selects by and checks the other attributes in the
+ * array, so vector blocks not matching the most selective attribute are never visited.
+ * 
+ * The index can be saved to an attribute index file next to the job file, see
+ * AttributeIndex::Save, and loaded again without reading any vector block.
+ */
+class AttributeIndex
+{
+public:
+    /**
+     * @brief Construct a new Attribute Index object
+     * 
+     * @param attributes The attributes per work plane, each in file order of the vector blocks.
+     * @throws std::runtime_error The job has more vector blocks than can be numbered.
+     */
+    explicit AttributeIndex(const std::vector<std::vector<VectorBlockAttributes>>& attributes);
+
+    /**
+     * @brief Loads the attribute index file of a job, if it is up to date.
+     * 
+     * @param job_path The path of the job file, the index file is expected at job_path + kAttributeIndexFileExtension.
+     * @param job_lut_position The position of the job lut as read from the header of the job file.
+     * @return std::optional<AttributeIndex> The index, or an empty optional if there is no index
+     * file, or it is malformed, of another version, or does not match the size and modification
+     * time of the job file.
+     */
+    static std::optional<AttributeIndex> Load(const std::string& job_path, const uint64_t job_lut_position);
+
+    /**
+     * @brief Saves the index next to the job file, to be loaded with AttributeIndex::Load.
+     * 
+     * Written to a temporary file first and renamed, like JobIndex::Save.
+     * 
+     * @param job_path The path of the job file.
+     * @param job_lut_position The position of the job lut within the job file.
+     * @throws std::runtime_error Writing the index file failed.
+     */
+    void Save(const std::string& job_path, const uint64_t job_lut_position) const;
+
+    /**
+     * @brief Finds the vector blocks selected by a filter.
+     * 
+     * @param filter The attributes to select by.
+     * @param locations Receives the positions of the selected vector blocks in file order.
+     * Any previous content is replaced.
+     * @param first_work_plane The first work plane to search.
+     * @param num_work_planes The number of work planes to search, or -1 for all following work planes.
+     * @throws std::runtime_error The work plane range is invalid.
+     */
+    void Find(const VectorBlockFilter& filter, std::vector<VectorBlockLocation>& locations,
+        const int first_work_plane = 0, const int num_work_planes = -1) const;
+
+    /**
+     * @brief Finds the vector blocks on a single work plane selected by a filter.
+     * 
+     * @param i_vector_blocks Receives the indices of the selected vector blocks in ascending order.
+     * Any previous content is replaced.
+     * @throws std::runtime_error The work plane index is invalid.
+     */
+    void Find(const VectorBlockFilter& filter, const int i_work_plane, std::vector<int>& i_vector_blocks) const;
+
+    /**
+     * @brief Gets the attributes of a specific vector block.
+     * 
+     * @throws std::runtime_error The work plane or vector block index is invalid.
+     */
+    const VectorBlockAttributes& GetAttributes(const int i_work_plane, const int i_vector_block) const;
+
+    /** The distinct laser indices of all vector blocks, in ascending order. */
+    std::vector<int32_t> laser_indices() const { return SortedKeys(by_laser_index_); }
+
+    /** The distinct part keys of all vector blocks, in ascending order. */
+    std::vector<int32_t> part_keys() const { return SortedKeys(by_part_key_); }
+
+    /** The number of work planes in the job. */
+    int num_work_planes() const { return (int)first_vector_blocks_.size() - 1; }
+
+    /** The number of vector blocks on a specific work plane. */
+    int num_vector_blocks(const int i_work_plane) const
+    {
+        CheckWorkPlaneIndex(i_work_plane);
+        return (int)(first_vector_blocks_[i_work_plane + 1] - first_vector_blocks_[i_work_plane]);
+    }
+
+    /** Approximate memory used by the index in bytes. */
+    size_t SpaceUsed() const;
+
+private:
+    /** Ascending numbers of the vector blocks with a specific attribute value. */
+    using PostingList = std::vector<uint32_t>;
+    using PostingLists = std::unordered_map<int32_t, PostingList>;
+
+    /** Number of the first vector block per work plane, followed by the total number of vector blocks. */
+    std::vector<uint32_t> first_vector_blocks_;
+
+    /** The attributes per vector block, indexed by the number of the vector block. */
+    std::vector<VectorBlockAttributes> attributes_;
+
+    PostingLists by_laser_index_;
+    PostingLists by_part_key_;
+    PostingLists by_vector_data_case_;
+
+    AttributeIndex() = default;
+
+    /** Builds the posting lists from the attributes. */
+    void BuildPostingLists();
+
+    /**
+     * @brief Visits the numbers of the vector blocks in [first, last) selected by a filter, in ascending order.
+     */
+    template <class VisitFn>
+    void ForEachMatch(const VectorBlockFilter& filter, const uint32_t first, const uint32_t last, VisitFn visit) const;
+
+    void CheckWorkPlaneIndex(const int i_work_plane) const
+    {
+        if (i_work_plane < 0 || i_work_plane > num_work_planes() - 1)
+            throw std::runtime_error("Invalid work plane index");
+    }
+
+    static std::vector<int32_t> SortedKeys(const PostingLists& lists);
+};
+
+/**
+ * @brief An attribute index built once per open file, on first access.
+ */
+struct LazyAttributeIndex
+{
+    std::once_flag is_building;
+    std::optional<AttributeIndex> index;
+};
+
+}
\ No newline at end of file
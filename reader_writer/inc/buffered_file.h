@@ -0,0 +1,163 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <new>
+#include <algorithm>
+#include <array>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "file_view.h"
+#include "file_source.h"
+#include "memory_mapping.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Pool of aligned read buffers, shared by the platform specific buffered files.
+ * 
+ * Buffers are grouped into size classes of powers of two. Released buffers are kept for
+ * reuse up to a byte budget, so reading ranges of similar sizes, e.g. the work planes or
+ * vector blocks of a job, does not allocate once the pool is warm. Buffers are handed out
+ * as shared pointers, which return them to the pool when the last view using them is
+ * released, even after the file they were read from is closed.
+ */
+class ReadBufferPool : public std::enable_shared_from_this<ReadBufferPool>
+{
+public:
+    /** Alignment of all buffers in bytes, a multiple of common page and sector sizes. */
+    static constexpr size_t kAlignment = 4096;
+
+    /**
+     * @brief Construct a new Read Buffer Pool object
+     * 
+     * @param max_free_bytes Maximum size of the released buffers kept for reuse, in bytes.
+     */
+    explicit ReadBufferPool(size_t max_free_bytes = (size_t)1 << 26)
+        : max_free_bytes_{max_free_bytes}
+    {}
+
+    ReadBufferPool(const ReadBufferPool&) = delete;
+    ReadBufferPool& operator=(const ReadBufferPool&) = delete;
+
+    ~ReadBufferPool()
+    {
+        for (auto& buffers : free_buffers_)
+        {
+            for (uint8_t *buffer : buffers)
+                Free(buffer);
+        }
+    }
+
+    /**
+     * @brief Gets a buffer of at least the requested size, reusing a released one if available.
+     * 
+     * The pool has to be owned by a std::shared_ptr.
+     */
+    std::shared_ptr<uint8_t> Acquire(const size_t size)
+    {
+        size_t size_class = kMinSizeClass;
+        while (size_class < kNumSizeClasses && ((size_t)1 << size_class) < size)
+            size_class++;
+
+        // too large to be pooled
+        if (size_class == kNumSizeClasses)
+        {
+            return std::shared_ptr<uint8_t>{Allocate(size), [](uint8_t *p){ Free(p); }};
+        }
+
+        uint8_t *buffer = nullptr;
+        {
+            std::lock_guard lock{mutex_};
+            auto& buffers = free_buffers_[size_class];
+            if (!buffers.empty())
+            {
+                buffer = buffers.back();
+                buffers.pop_back();
+                free_bytes_ -= (size_t)1 << size_class;
+            }
+        }
+
+        if (buffer == nullptr)
+            buffer = Allocate((size_t)1 << size_class);
+
+        return std::shared_ptr<uint8_t>{
+            buffer,
+            [pool = shared_from_this(), size_class](uint8_t *p){ pool->Release(size_class, p); }
+        };
+    }
+
+private:
+    /** Smallest size class, one page. */
+    static constexpr size_t kMinSizeClass = 12;
+
+    /** Size classes up to 64 MiB are pooled. */
+    static constexpr size_t kNumSizeClasses = 27;
+
+    const size_t max_free_bytes_;
+
+    std::mutex mutex_;
+    std::array<std::vector<uint8_t*>, kNumSizeClasses> free_buffers_;
+    size_t free_bytes_ = 0;
+
+    static uint8_t* Allocate(const size_t size)
+    {
+        return static_cast<uint8_t*>(::operator new(std::max<size_t>(size, 1), std::align_val_t{kAlignment}));
+    }
+
+    static void Free(uint8_t *buffer)
+    {
+        ::operator delete(buffer, std::align_val_t{kAlignment});
+    }
+
+    void Release(const size_t size_class, uint8_t *buffer)
+    {
+        {
+            std::lock_guard lock{mutex_};
+            if (free_bytes_ + ((size_t)1 << size_class) <= max_free_bytes_)
+            {
+                free_buffers_[size_class].push_back(buffer);
+                free_bytes_ += (size_t)1 << size_class;
+                return;
+            }
+        }
+        Free(buffer);
+    }
+};
+
+}
+
+#if (defined WIN32 || defined _WIN32)
+#  include "buffered_file_win32.h"
+#else
+#  include "buffered_file_posix.h"
+#endif
\ No newline at end of file
@@ -0,0 +1,540 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#if (defined WIN32 || defined _WIN32)
+#  error posix headers included for win32 build
+#endif
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <limits>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <linux/io_uring.h>
+#  if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#    define OVF_HAS_IO_URING
+#  endif
+#endif
+
+#include "buffered_file.h"
+
+namespace open_vector_format::reader_writer {
+
+#ifdef OVF_HAS_IO_URING
+
+/**
+ * @brief Minimal io_uring submission and completion ring for batches of reads.
+ * 
+ * Not thread-safe, a ring is used by one thread at a time.
+ */
+class IoUring
+{
+public:
+    /**
+     * @brief Sets up a new ring.
+     * 
+     * @param num_entries Maximum number of reads in flight.
+     * @return std::unique_ptr<IoUring> The ring, or nullptr if io_uring is not supported
+     * or not permitted on this system.
+     */
+    static std::unique_ptr<IoUring> Create(const unsigned num_entries)
+    {
+        io_uring_params params{};
+        int ring = (int)syscall(__NR_io_uring_setup, num_entries, &params);
+        if (ring < 0)
+            return nullptr;
+
+        std::unique_ptr<IoUring> io_uring{new IoUring{ring}};
+        if (!io_uring->Map(params))
+            return nullptr;
+
+        return io_uring;
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring()
+    {
+        if (sqes_ != nullptr)
+            munmap(sqes_, sqes_size_);
+        if (cq_ring_ != nullptr && cq_ring_ != sq_ring_)
+            munmap(cq_ring_, cq_ring_size_);
+        if (sq_ring_ != nullptr)
+            munmap(sq_ring_, sq_ring_size_);
+        close(ring_);
+    }
+
+    /**
+     * @brief Reads several ranges of a file at once.
+     * 
+     * @param file The file descriptor to read from.
+     * @param ranges The ranges to read. Each range must be smaller than 4 GiB.
+     * @param buffers One buffer per range, of at least the size of the range.
+     * @param results One result per range, the number of bytes read or a negative error number.
+     * @throws std::runtime_error The reads could not be submitted. Reads submitted before are
+     * completed before throwing, so their buffers can be released.
+     */
+    void Read(const int file, Span<const ByteRange> ranges, uint8_t *const *buffers, int64_t *results)
+    {
+        for (size_t first = 0; first < ranges.size(); first += num_entries_)
+        {
+            const unsigned count = (unsigned)std::min<size_t>(num_entries_, ranges.size() - first);
+
+            // single producer, the tail is only published after all entries are written
+            unsigned tail = *sq_tail_;
+            for (unsigned i = 0; i < count; i++)
+            {
+                const unsigned index = (tail + i) & sq_mask_;
+                io_uring_sqe& sqe = sqes_[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = file;
+                sqe.off = (uint64_t)ranges[first + i].offset;
+                sqe.addr = (uint64_t)(uintptr_t)buffers[first + i];
+                sqe.len = (uint32_t)ranges[first + i].size;
+                sqe.user_data = first + i;
+                sq_array_[index] = index;
+            }
+            __atomic_store_n(sq_tail_, tail + count, __ATOMIC_RELEASE);
+
+            unsigned num_submitted = 0;
+            unsigned num_completed = 0;
+            while (num_completed < count)
+            {
+                int ret = (int)syscall(__NR_io_uring_enter, ring_, count - num_submitted, count - num_completed,
+                    IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && !IsRetryable(errno))
+                {
+                    const int error = errno;
+                    // the kernel only consumes entries in io_uring_enter, so the unsubmitted ones can be withdrawn
+                    __atomic_store_n(sq_tail_, tail + num_submitted, __ATOMIC_RELEASE);
+                    WaitForCompletions(first, count, num_submitted, num_completed, results);
+                    throw std::runtime_error(std::string{"Submitting reads failed: "} + std::strerror(error));
+                }
+                if (ret > 0)
+                    num_submitted += (unsigned)ret;
+
+                // the completion queue may have to be emptied before busy submissions succeed
+                num_completed += ReapCompletions(first, count, results);
+            }
+        }
+    }
+
+private:
+    int ring_;
+    unsigned num_entries_ = 0;
+
+    void *sq_ring_ = nullptr;
+    size_t sq_ring_size_ = 0;
+    void *cq_ring_ = nullptr;
+    size_t cq_ring_size_ = 0;
+    io_uring_sqe *sqes_ = nullptr;
+    size_t sqes_size_ = 0;
+
+    unsigned *sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned *sq_array_ = nullptr;
+    unsigned *cq_head_ = nullptr;
+    unsigned *cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe *cqes_ = nullptr;
+
+    explicit IoUring(int ring)
+        : ring_{ring}
+    {}
+
+    /**
+     * @brief Whether io_uring_enter failed temporarily, e.g. due to a full completion queue.
+     */
+    static bool IsRetryable(const int error)
+    {
+        return error == EINTR || error == EAGAIN || error == EBUSY;
+    }
+
+    /**
+     * @brief Reads the available completions of the current chunk of reads.
+     * 
+     * Completions of other chunks can only be left over if waiting for them failed, they are dropped.
+     * 
+     * @return unsigned The number of completions of the current chunk.
+     */
+    unsigned ReapCompletions(const size_t first, const unsigned count, int64_t *results)
+    {
+        // single consumer, completions are released after they are read
+        unsigned num_completed = 0;
+        unsigned head = *cq_head_;
+        const unsigned cq_tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != cq_tail; head++)
+        {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            if (cqe.user_data < first || cqe.user_data >= first + count)
+                continue;
+
+            results[cqe.user_data] = cqe.res;
+            num_completed++;
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        return num_completed;
+    }
+
+    /**
+     * @brief Waits until all submitted reads of the current chunk completed, after submitting failed.
+     * 
+     * Gives up if waiting fails as well, which leaves the reads in flight.
+     */
+    void WaitForCompletions(const size_t first, const unsigned count, const unsigned num_submitted,
+        unsigned num_completed, int64_t *results)
+    {
+        num_completed += ReapCompletions(first, count, results);
+        while (num_completed < num_submitted)
+        {
+            int ret = (int)syscall(__NR_io_uring_enter, ring_, 0, num_submitted - num_completed,
+                IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (ret < 0 && !IsRetryable(errno))
+                return;
+
+            num_completed += ReapCompletions(first, count, results);
+        }
+    }
+
+    bool Map(const io_uring_params& params)
+    {
+        sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool is_single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (is_single_mmap)
+            sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+
+        void *sq_ring = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+        if (sq_ring == MAP_FAILED)
+            return false;
+        sq_ring_ = sq_ring;
+
+        if (is_single_mmap)
+        {
+            cq_ring_ = sq_ring_;
+        }
+        else
+        {
+            void *cq_ring = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED)
+                return false;
+            cq_ring_ = cq_ring;
+        }
+
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED)
+            return false;
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        auto sq = static_cast<uint8_t*>(sq_ring_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto cq = static_cast<uint8_t*>(cq_ring_);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        num_entries_ = params.sq_entries;
+        return true;
+    }
+};
+
+#endif
+
+/**
+ * @brief POSIX specific implementation for reading files into buffers.
+ * 
+ * Every view reads its range of the file with pread into a buffer of a ReadBufferPool,
+ * which it owns. Several ranges requested at once are submitted together with io_uring,
+ * if it is available on the system, otherwise they are read one after another.
+ */
+class BufferedFile : public FileSource
+{
+public:
+    /**
+     * @brief Construct a new Buffered File object
+     * 
+     * @param path A valid path to a file.
+     * @param options Options for accessing the file, only the access pattern hint is used.
+     * @throws std::runtime_error The file could not be opened.
+     */
+    BufferedFile(const std::string path, const MappingOptions& options = {})
+        : buffers_{std::make_shared<ReadBufferPool>()}
+    {
+        file_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file_ < 0)
+        {
+            throw std::runtime_error("Opening file \"" + path + "\" failed: " + std::strerror(errno));
+        }
+
+        struct stat file_stat;
+        if (fstat(file_, &file_stat) != 0)
+        {
+            close(file_);
+            throw std::runtime_error("Querying size of file \"" + path + "\" failed: " + std::strerror(errno));
+        }
+        file_size_ = (size_t)file_stat.st_size;
+
+        int fadvice = POSIX_FADV_NORMAL;
+        if (options.access_pattern == AccessPattern::kSequential)
+            fadvice = POSIX_FADV_SEQUENTIAL;
+        else if (options.access_pattern == AccessPattern::kRandom)
+            fadvice = POSIX_FADV_RANDOM;
+        posix_fadvise(file_, 0, 0, fadvice);
+
+#ifdef OVF_HAS_IO_URING
+        io_uring_ = IoUring::Create(kIoUringEntries);
+#endif
+    }
+
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+    /**
+     * @brief Destroy the Buffered File object
+     * 
+     * Closes the file descriptor. Views stay valid, as they own their buffers.
+     */
+    ~BufferedFile()
+    {
+#ifdef OVF_HAS_IO_URING
+        io_uring_.reset();
+#endif
+        close(file_);
+    }
+
+    /**
+     * @brief Create a new FileView by reading a range of the file, see FileSource::CreateView().
+     * 
+     * The view has exactly the requested size.
+     */
+    FileView CreateView(const size_t offset, const size_t min_size) const override
+    {
+        const size_t size = CheckRange(offset, min_size);
+
+        auto buffer = buffers_->Acquire(size);
+        ReadFully(buffer.get(), offset, size);
+        return FileView{buffer.get(), size, std::move(buffer)};
+    }
+
+    /**
+     * @brief Creates views of several ranges at once, see FileSource::CreateViews().
+     * 
+     * The ranges are submitted together if io_uring is available and not in use by another
+     * thread, otherwise they are read one after another.
+     */
+    std::vector<FileView> CreateViews(Span<const ByteRange> ranges) const override
+    {
+        std::vector<ByteRange> checked_ranges(ranges.begin(), ranges.end());
+        std::vector<std::shared_ptr<uint8_t>> buffers(ranges.size());
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+            checked_ranges[i].size = CheckRange(ranges[i].offset, ranges[i].size);
+            buffers[i] = buffers_->Acquire(checked_ranges[i].size);
+        }
+
+        if (!ReadBatch(checked_ranges, buffers))
+        {
+            for (size_t i = 0; i < ranges.size(); i++)
+                ReadFully(buffers[i].get(), checked_ranges[i].offset, checked_ranges[i].size);
+        }
+
+        std::vector<FileView> views;
+        views.reserve(ranges.size());
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+            uint8_t *data = buffers[i].get();
+            views.emplace_back(data, checked_ranges[i].size, std::move(buffers[i]));
+        }
+        return views;
+    }
+
+    /**
+     * @brief Accessor for the size of the full file.
+     * 
+     * @return size_t The size of the full file in bytes.
+     */
+    size_t file_size() const override
+    {
+        return file_size_;
+    }
+
+    /**
+     * @brief Views hold copies of the file contents, see FileSource::copies_data().
+     */
+    bool copies_data() const override
+    {
+        return true;
+    }
+
+    /**
+     * @brief Reports whether several ranges are submitted at once with io_uring.
+     */
+    bool is_io_uring_enabled() const
+    {
+#ifdef OVF_HAS_IO_URING
+        return io_uring_ != nullptr && !is_io_uring_failed_;
+#else
+        return false;
+#endif
+    }
+
+private:
+    /** Maximum number of reads in flight when submitting ranges at once. */
+    static constexpr unsigned kIoUringEntries = 64;
+
+    /** File descriptor of the file. */
+    int file_ = -1;
+
+    /** Full file size, queried on construction. */
+    size_t file_size_ = 0;
+
+    /** Buffers the ranges are read into. */
+    std::shared_ptr<ReadBufferPool> buffers_;
+
+#ifdef OVF_HAS_IO_URING
+    /** Ring for submitting several ranges at once, nullptr if io_uring is not available. */
+    std::unique_ptr<IoUring> io_uring_;
+
+    /** Guards the ring, threads finding it in use read their ranges one after another instead. */
+    mutable std::mutex io_uring_mutex_;
+
+    /** Whether submitting reads failed, so ranges are read one after another from then on. */
+    mutable std::atomic<bool> is_io_uring_failed_{false};
+#endif
+
+    /**
+     * @brief Checks a requested range against the file.
+     * 
+     * @return size_t The size of the range, extended to the end of the file for a min_size of 0.
+     */
+    size_t CheckRange(const size_t offset, const size_t min_size) const
+    {
+        if (offset > file_size_ || min_size > file_size_ - offset)
+            throw std::runtime_error("Requested view exceeds the file");
+
+        return min_size == 0 ? file_size_ - offset : min_size;
+    }
+
+    /**
+     * @brief Reads a range of the file, retrying on interruptions and short reads.
+     */
+    void ReadFully(uint8_t *buffer, size_t offset, size_t size) const
+    {
+        while (size > 0)
+        {
+            ssize_t count = pread(file_, buffer, std::min<size_t>(size, (size_t)1 << 30), (off_t)offset);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count < 0)
+                throw std::runtime_error(std::string{"Reading file failed: "} + std::strerror(errno));
+            if (count == 0)
+                throw std::runtime_error("Reading file failed: unexpected end of file");
+
+            buffer += count;
+            offset += (size_t)count;
+            size -= (size_t)count;
+        }
+    }
+
+    /**
+     * @brief Reads several ranges with io_uring, if available.
+     * 
+     * @return true The ranges were read.
+     * @return false The ranges have to be read one after another.
+     */
+    bool ReadBatch(const std::vector<ByteRange>& ranges, const std::vector<std::shared_ptr<uint8_t>>& buffers) const
+    {
+#ifdef OVF_HAS_IO_URING
+        if (io_uring_ == nullptr || is_io_uring_failed_ || ranges.size() < 2)
+            return false;
+
+        for (const auto& range : ranges)
+        {
+            if (range.size > std::numeric_limits<uint32_t>::max())
+                return false;
+        }
+
+        std::unique_lock lock{io_uring_mutex_, std::try_to_lock};
+        if (!lock.owns_lock())
+            return false;
+
+        std::vector<uint8_t*> data(buffers.size());
+        for (size_t i = 0; i < buffers.size(); i++)
+            data[i] = buffers[i].get();
+
+        std::vector<int64_t> results(ranges.size());
+        try
+        {
+            io_uring_->Read(file_, ranges, data.data(), results.data());
+        }
+        catch (const std::runtime_error&)
+        {
+            // the ring is not used again, in case reads were left in flight
+            is_io_uring_failed_ = true;
+            return false;
+        }
+        lock.unlock();
+
+        // complete short reads, and retry failed ones with pread, which reports the actual error.
+        // reads fail with EINVAL on kernels without IORING_OP_READ
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+            const size_t count = results[i] > 0 ? (size_t)results[i] : 0;
+            if (count < ranges[i].size)
+                ReadFully(data[i] + count, ranges[i].offset + count, ranges[i].size - count);
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+};
+
+}
\ No newline at end of file
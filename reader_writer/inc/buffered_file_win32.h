@@ -0,0 +1,191 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#if (!defined WIN32 && !defined _WIN32)
+#  error win32 headers included for non-win32 build
+#endif
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <windows.h>
+#include <fileapi.h>
+
+#include "buffered_file.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief WIN32 specific implementation for reading files into buffers.
+ * 
+ * Every view reads its range of the file with a positioned ReadFile call into a
+ * buffer of a ReadBufferPool, which it owns. Several ranges requested at once are
+ * read one after another.
+ */
+class BufferedFile : public FileSource
+{
+public:
+    /**
+     * @brief Construct a new Buffered File object
+     * 
+     * @param path A valid path to a file.
+     * @param options Options for accessing the file, only the access pattern hint is used.
+     * @throws std::runtime_error A handle to the file could not be obtained.
+     */
+    BufferedFile(const std::string path, const MappingOptions& options = {})
+        : buffers_{std::make_shared<ReadBufferPool>()}
+    {
+        DWORD access_flags = 0;
+        switch (options.access_pattern)
+        {
+            case AccessPattern::kSequential:
+                access_flags = FILE_FLAG_SEQUENTIAL_SCAN;
+                break;
+            case AccessPattern::kRandom:
+                access_flags = FILE_FLAG_RANDOM_ACCESS;
+                break;
+            default:
+                break;
+        }
+
+        file_ = CreateFileA(
+            path.c_str(),
+            GENERIC_READ,
+            FILE_SHARE_READ,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_ATTRIBUTE_NORMAL | access_flags,
+            nullptr
+        );
+
+        if (file_ == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Opening file \"" + path + "\" failed");
+        }
+
+        DWORD low, high;
+        low = GetFileSize(file_, &high);
+        file_size_ = (((uint64_t)high) << 32) | ((uint64_t)low);
+    }
+
+    BufferedFile(const BufferedFile&) = delete;
+    BufferedFile& operator=(const BufferedFile&) = delete;
+
+    /**
+     * @brief Destroy the Buffered File object
+     * 
+     * Closes the file handle. Views stay valid, as they own their buffers.
+     */
+    ~BufferedFile()
+    {
+        CloseHandle(file_);
+    }
+
+    /**
+     * @brief Create a new FileView by reading a range of the file, see FileSource::CreateView().
+     * 
+     * The view has exactly the requested size.
+     */
+    FileView CreateView(const size_t offset, const size_t min_size) const override
+    {
+        if (offset > file_size_ || min_size > file_size_ - offset)
+            throw std::runtime_error("Requested view exceeds the file");
+
+        const size_t size = min_size == 0 ? file_size_ - offset : min_size;
+
+        auto buffer = buffers_->Acquire(size);
+        ReadFully(buffer.get(), offset, size);
+        return FileView{buffer.get(), size, std::move(buffer)};
+    }
+
+    /**
+     * @brief Accessor for the size of the full file.
+     * 
+     * @return size_t The size of the full file in bytes.
+     */
+    size_t file_size() const override
+    {
+        return file_size_;
+    }
+
+    /**
+     * @brief Views hold copies of the file contents, see FileSource::copies_data().
+     */
+    bool copies_data() const override
+    {
+        return true;
+    }
+
+    /**
+     * @brief Reports whether several ranges are submitted at once, which is not implemented for WIN32.
+     */
+    bool is_io_uring_enabled() const
+    {
+        return false;
+    }
+
+private:
+    /** Handle of the file. */
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+
+    /** Full file size, queried on construction. */
+    size_t file_size_ = 0;
+
+    /** Buffers the ranges are read into. */
+    std::shared_ptr<ReadBufferPool> buffers_;
+
+    /**
+     * @brief Reads a range of the file, in chunks ReadFile can handle.
+     */
+    void ReadFully(uint8_t *buffer, size_t offset, size_t size) const
+    {
+        while (size > 0)
+        {
+            // the offset is passed with every call, so concurrent reads don't share a file pointer
+            OVERLAPPED overlapped{};
+            overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+            overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+
+            DWORD count = 0;
+            const DWORD chunk = (DWORD)std::min<size_t>(size, (size_t)1 << 30);
+            if (!ReadFile(file_, buffer, chunk, &count, &overlapped))
+                throw std::runtime_error("Reading file failed");
+            if (count == 0)
+                throw std::runtime_error("Reading file failed: unexpected end of file");
+
+            buffer += count;
+            offset += count;
+            size -= count;
+        }
+    }
+};
+
+}
\ No newline at end of file
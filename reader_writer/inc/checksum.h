@@ -0,0 +1,159 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <optional>
+
+#include "file_source.h"
+#include "attribute_index.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Granularity of the checksums written to a file.
+ */
+enum class ChecksumMode
+{
+    /** No checksums are written. */
+    kNone,
+    /** A checksum per work plane and one of the remaining parts of the job. */
+    kWorkPlanes,
+    /** Like kWorkPlanes, and additionally a checksum per vector block, to locate corrupted vector blocks. */
+    kVectorBlocks
+};
+
+/**
+ * @brief Computes the CRC32C (Castagnoli) checksum of a range of bytes.
+ * 
+ * Uses the CRC32 instructions of SSE 4.2 or ARMv8 if supported by the processor, and a
+ * table based implementation otherwise.
+ * 
+ * @param data The bytes to checksum.
+ * @param size The number of bytes.
+ * @param crc The checksum of the preceding bytes, to continue a checksum over several ranges.
+ * @return uint32_t The checksum of the preceding and the given bytes.
+ */
+uint32_t Crc32c(const uint8_t *data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief Combines the CRC32C checksums of two adjacent ranges of bytes.
+ * 
+ * Allows checksumming ranges out of order, e.g. when the first bytes of a range are only
+ * known after the rest of it.
+ * 
+ * @param first_crc The checksum of the first range.
+ * @param second_crc The checksum of the second range.
+ * @param second_size The number of bytes of the second range.
+ * @return uint32_t The checksum of both ranges, as if computed in one go.
+ */
+uint32_t Crc32cCombine(uint32_t first_crc, uint32_t second_crc, size_t second_size);
+
+/**
+ * @brief Result of verifying a file against its checksums, see OvfFileReader::Verify.
+ */
+struct VerificationResult
+{
+    /** Whether the file has checksums at all. Files without them can't be verified. */
+    bool has_checksums = false;
+
+    /** Whether the file header, job shell and job lut match their checksum. */
+    bool is_job_intact = true;
+
+    /** The work planes not matching their checksum, in ascending order. */
+    std::vector<int> corrupted_work_planes;
+
+    /** The vector blocks not matching their checksum, in file order. Only determined for files
+     *  written with ChecksumMode::kVectorBlocks, and for corrupted work planes whose lut is readable. */
+    std::vector<VectorBlockLocation> corrupted_vector_blocks;
+
+    /** Whether the file has checksums and all of them match. */
+    bool is_intact() const { return has_checksums && is_job_intact && corrupted_work_planes.empty(); }
+};
+
+/**
+ * @brief Checksums of the parts of a job, stored in an optional section at the end of the file.
+ * 
+ * The section follows the job lut, which is parsed as a length delimited message, so readers
+ * not aware of checksums ignore it. It is located by a trailer of fixed size at the very end
+ * of the file, holding its position, its own checksum and magic bytes. All values are stored
+ * in little endian byte order, like the rest of the file.
+ * 
+ * The work plane checksums cover the byte range of each work plane, up to the next work plane
+ * or the job shell. The vector block checksums cover the range of each vector block, up to the
+ * next vector block or the work plane shell, in file order across all work planes. The job
+ * checksum covers the file header as well as the job shell and job lut, i.e. everything else
+ * but the checksum section.
+ */
+class ChecksumSection
+{
+public:
+    /** Size of the trailer at the end of the file in bytes. */
+    static constexpr size_t kTrailerSize = 16;
+
+    /** Size of the file header covered by the job checksum, i.e. magic bytes and job lut position. */
+    static constexpr size_t kFileHeaderSize = 12;
+
+    uint32_t job_checksum = 0;
+    std::vector<uint32_t> work_plane_checksums;
+
+    /** Whether the section holds vector block checksums, i.e. was written with ChecksumMode::kVectorBlocks. */
+    bool has_vector_block_checksums = false;
+
+    /** Number of vector blocks per work plane, to locate the vector block checksums even if
+     *  the luts of the job are corrupted. Empty without vector block checksums. */
+    std::vector<uint32_t> num_vector_blocks;
+
+    /** Empty without vector block checksums. */
+    std::vector<uint32_t> vector_block_checksums;
+
+    /** The position of the section within the file, where the covered range of the job checksum ends. */
+    uint64_t position = 0;
+
+    /**
+     * @brief Serializes the section, including the trailer, to be appended at the given position.
+     */
+    std::string Serialize(const uint64_t section_position) const;
+
+    /**
+     * @brief Reads the checksum section at the end of a file, if there is one.
+     * 
+     * @param source The file.
+     * @param min_position The position after which the section is expected, i.e. of the job lut.
+     * @return std::optional<ChecksumSection> The section, or an empty optional if the file
+     * does not end with a checksum section trailer.
+     * @throws std::runtime_error The file ends with a trailer, but the section is corrupted.
+     */
+    static std::optional<ChecksumSection> Read(const FileSource& source, const uint64_t min_position);
+};
+
+}
\ No newline at end of file
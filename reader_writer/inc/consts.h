@@ -29,6 +29,7 @@ SOFTWARE.
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 namespace open_vector_format::reader_writer {
 
@@ -38,4 +39,28 @@ const std::array<uint8_t, 4> kMagicBytes{ { 0x4c, 0x56, 0x46, 0x21 } };
 /** Default offset to write while real offset is unknown. */
 const int64_t kDefaultLutOffset = 0;
 
+/** Extension appended to the path of an ovf file to get the path of its index file. */
+const char kIndexFileExtension[] = ".ovfidx";
+
+/** Magic bytes at the beginning of index files. */
+const std::array<uint8_t, 4> kIndexMagicBytes{ { 0x4c, 0x56, 0x46, 0x49 } };
+
+/** Version of the index file layout, incremented on every incompatible change. */
+const uint32_t kIndexFileVersion = 1;
+
+/** Extension appended to the path of an ovf file to get the path of its attribute index file. */
+const char kAttributeIndexFileExtension[] = ".ovfattr";
+
+/** Magic bytes at the beginning of attribute index files. */
+const std::array<uint8_t, 4> kAttributeIndexMagicBytes{ { 0x4c, 0x56, 0x46, 0x41 } };
+
+/** Version of the attribute index file layout, incremented on every incompatible change. */
+const uint32_t kAttributeIndexFileVersion = 1;
+
+/** Magic bytes at the beginning and the end of the optional checksum section of ovf files. */
+const std::array<uint8_t, 4> kChecksumMagicBytes{ { 0x4c, 0x56, 0x46, 0x43 } };
+
+/** Version of the checksum section layout, incremented on every incompatible change. */
+const uint32_t kChecksumSectionVersion = 1;
+
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "file_view.h"
+#include "span.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief A contiguous byte range of a file.
+ */
+struct ByteRange
+{
+    /** The absolute offset in bytes from the beginning of the file. */
+    size_t offset = 0;
+
+    /** The size of the range in bytes. */
+    size_t size = 0;
+};
+
+/**
+ * @brief Memory occupied by the contents of a file in the address space of the process.
+ */
+struct ResidentMemory
+{
+    /** Bytes of the file resident in physical memory, i.e. readable without page faults. */
+    size_t resident_bytes = 0;
+
+    /** Bytes of the file locked into physical memory. */
+    size_t locked_bytes = 0;
+};
+
+/**
+ * @brief Random access source of the contents of a file, e.g. a memory mapping.
+ * 
+ * All methods are thread-safe. Views created from a source stay valid at least as
+ * long as the source exists, and as long as they share ownership of their memory,
+ * see FileView.
+ */
+class FileSource
+{
+public:
+    virtual ~FileSource() = default;
+
+    /**
+     * @brief Create a new FileView
+     * 
+     * @param offset The absolute offset in bytes from the beginning of the file.
+     * @param min_size The minimum size the view has to have, in bytes. When min_size
+     * is 0, the view extends to the end of the file.
+     * @return A new file view. The first byte of its data is guaranteed to be at the
+     * offset specified, and its size is at least as long as min_size.
+     * @throws std::runtime_error The requested range exceeds the file, or could not be accessed.
+     */
+    virtual FileView CreateView(const size_t offset, const size_t min_size) const = 0;
+
+    /**
+     * @brief Creates views of several ranges at once.
+     * 
+     * Sources reading the file can submit the ranges together, instead of one after
+     * another. By default, the views are created one by one.
+     * 
+     * @param ranges The ranges to create views of. A size of 0 extends the view to the end of the file.
+     * @return std::vector<FileView> One view per range, in the order of the ranges.
+     * @throws std::runtime_error Any of the ranges exceeds the file, or could not be accessed.
+     */
+    virtual std::vector<FileView> CreateViews(Span<const ByteRange> ranges) const
+    {
+        std::vector<FileView> views;
+        views.reserve(ranges.size());
+        for (const auto& range : ranges)
+        {
+            views.push_back(CreateView(range.offset, range.size));
+        }
+        return views;
+    }
+
+    /**
+     * @brief Accessor for the size of the full file.
+     * 
+     * @return size_t The size of the full file in bytes.
+     */
+    virtual size_t file_size() const = 0;
+
+    /**
+     * @brief Reports whether views copy the contents of the file.
+     * 
+     * If they do, every byte viewed is read, so views should cover the needed ranges only
+     * instead of spanning over unneeded ones. Otherwise, views are cheap regardless of their size.
+     */
+    virtual bool copies_data() const = 0;
+
+    /**
+     * @brief Locks a range of the file into physical memory, so reading it never page faults.
+     * 
+     * Locking is limited by the operating system, e.g. by RLIMIT_MEMLOCK on POSIX systems.
+     * By default, sources do not support locking.
+     * 
+     * @param offset The absolute offset in bytes from the beginning of the file.
+     * @param size The size of the range in bytes.
+     * @return true The range is locked.
+     * @return false Locking is not supported by the source, or was denied.
+     */
+    virtual bool Lock(const size_t /*offset*/, const size_t /*size*/) const { return false; }
+
+    /**
+     * @brief Unlocks a range of the file locked with Lock(). By default, this is a no-op.
+     */
+    virtual void Unlock(const size_t /*offset*/, const size_t /*size*/) const {}
+
+    /**
+     * @brief Releases the physical memory backing a range of the file, e.g. of work planes already consumed.
+     * 
+     * Views of the range stay valid, reading them again faults the contents back in. Locked
+     * memory is not released. By default, this is a no-op.
+     * 
+     * @param offset The absolute offset in bytes from the beginning of the file.
+     * @param size The size of the range in bytes.
+     */
+    virtual void Release(const size_t /*offset*/, const size_t /*size*/) const {}
+
+    /**
+     * @brief Reports how much of the file occupies physical memory. By default, nothing is reported.
+     */
+    virtual ResidentMemory GetResidentMemory() const { return {}; }
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief A read-only view onto a contiguous byte range of a file.
+ * 
+ * Depending on how the view was created, it either points into a mapping that
+ * outlives it, or it shares ownership of the memory backing it (e.g. a dedicated
+ * mapping or a pinned mapping window), which is released together with the last
+ * view referencing it.
+ */
+class FileView
+{
+public:
+
+    /**
+     * @brief Construct a new File View object
+     * 
+     * @param start_addr The address in memory at which the data starts.
+     * @param size The size of the view in bytes.
+     * @param keep_alive Optional owner of the memory backing the view. The memory
+     * is kept valid at least as long as this view exists.
+     */
+    FileView(uint8_t *start_addr, size_t size, std::shared_ptr<const void> keep_alive = nullptr)
+        : start_addr_{start_addr}, size_{size}, keep_alive_{std::move(keep_alive)}
+    {}
+
+    // Views may share ownership of a mapping, which should not be
+    // duplicated by accident. Moving is fine.
+    FileView(const FileView&) = delete;
+    FileView& operator=(const FileView&) = delete;
+    FileView(FileView&&) = default;
+    FileView& operator=(FileView&&) = default;
+
+    /**
+     * @brief Accessor to the mapped data.
+     * 
+     * @return uint8_t* Pointer to the memory segment representing the exact offset from the
+     * beginning of the file as requested on creation. Guaranteed to be valid for the size
+     * available in the size() accessor.
+     */
+    uint8_t *data() const
+    {
+        return start_addr_;
+    }
+
+    /**
+     * @brief Accessor to the size of mapped data.
+     * 
+     * @return size_t The size in bytes of this view. This number may be higher than the requested
+     * minimum size.
+     */
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    /** The address in memory at which the data starts. */
+    uint8_t *start_addr_;
+
+    /** The size of the view in bytes. */
+    size_t size_;
+
+    /** Owner of the memory backing this view, if the view does not point into a persistent mapping. */
+    std::shared_ptr<const void> keep_alive_;
+};
+
+}
\ No newline at end of file
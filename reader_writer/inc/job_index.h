@@ -0,0 +1,321 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <algorithm>
+
+#include "ovf_lut.pb.h"
+#include "consts.h"
+#include "memory_mapping.h"
+#include "span.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Flat index of the positions of work planes and vector blocks within a file.
+ * 
+ * Replaces the lut messages of the file by plain arrays of positions. When all work
+ * planes are indexed at once, the vector block positions of the whole job are stored
+ * in a single contiguous array, next to arrays of the first vector block and the shell
+ * position per work plane. Work planes indexed on first access get an array of their
+ * own instead, as they can be indexed concurrently and in any order.
+ * 
+ * A fully indexed job can be saved to an index file next to the job file, see
+ * JobIndex::Save. Loading it maps the file and points the arrays directly into the
+ * mapping, so no lut of the job has to be read.
+ */
+class JobIndex
+{
+public:
+    /**
+     * @brief Positions of the contents of a single work plane.
+     */
+    struct WorkPlaneEntry
+    {
+        /** Positions of the vector blocks, in file order. */
+        Span<const uint64_t> vector_block_positions;
+
+        /** Position of the work plane shell, which follows the last vector block. */
+        uint64_t shell_position = 0;
+
+        /** The number of vector blocks on the work plane. */
+        int num_vector_blocks() const { return (int)vector_block_positions.size(); }
+
+        /**
+         * @brief Gets the byte range of a vector block, up to the next vector block or the work plane shell.
+         * 
+         * @throws std::runtime_error The vector block index is invalid.
+         */
+        void GetVectorBlockRange(const int i_vector_block, size_t& start_offset, size_t& end_offset) const
+        {
+            if (i_vector_block < 0 || i_vector_block > num_vector_blocks() - 1)
+                throw std::runtime_error("Invalid vector block index");
+
+            start_offset = vector_block_positions[i_vector_block];
+            end_offset = i_vector_block < num_vector_blocks() - 1
+                ? vector_block_positions[i_vector_block + 1]
+                : shell_position;
+        }
+    };
+
+    /**
+     * @brief Construct a new Job Index object, without indexing any work plane yet.
+     * 
+     * @param job_lut The lut of the job, with the positions of the work planes and the job shell.
+     */
+    explicit JobIndex(const JobLUT& job_lut)
+        : table_storage_(3 * (size_t)job_lut.workplanepositions_size() + 2),
+          work_planes_{std::make_unique<WorkPlaneSlot[]>(job_lut.workplanepositions_size())}
+    {
+        for (int i = 0; i < job_lut.workplanepositions_size(); i++)
+        {
+            table_storage_[i] = (uint64_t)job_lut.workplanepositions(i);
+        }
+        table_storage_[job_lut.workplanepositions_size()] = (uint64_t)job_lut.jobshellposition();
+
+        SetTables(table_storage_.data(), job_lut.workplanepositions_size());
+    }
+
+    // The arrays may point into the storage of this object, which is
+    // preserved when moving, but not when copying.
+    JobIndex(const JobIndex&) = delete;
+    JobIndex& operator=(const JobIndex&) = delete;
+    JobIndex(JobIndex&&) = default;
+    JobIndex& operator=(JobIndex&&) = default;
+
+    /**
+     * @brief Loads the index file of a job, if it is up to date.
+     * 
+     * @param job_path The path of the job file, the index file is expected at job_path + kIndexFileExtension.
+     * @param job_lut_position The position of the job lut as read from the header of the job file.
+     * @return std::optional<JobIndex> The fully indexed job, or an empty optional if there is no
+     * index file, or it is malformed, of another version, or does not match the size and
+     * modification time of the job file, or any of its positions is out of range of its work
+     * plane or of the job file.
+     */
+    static std::optional<JobIndex> Load(const std::string& job_path, const uint64_t job_lut_position);
+
+    /**
+     * @brief Saves the index next to the job file, to be loaded with JobIndex::Load.
+     * 
+     * The job file has to be complete, as its size and modification time are stored for
+     * invalidation. The index file is written to a temporary file first and renamed, so
+     * concurrent loads never see a partially written index file.
+     * 
+     * @param job_path The path of the job file.
+     * @param job_lut_position The position of the job lut within the job file.
+     * @throws std::runtime_error The index is not fully indexed, or writing the index file failed.
+     */
+    void Save(const std::string& job_path, const uint64_t job_lut_position) const;
+
+    /** The number of work planes in the job. */
+    int num_work_planes() const { return (int)work_plane_positions_.size() - 1; }
+
+    /** The position of the job shell, which follows the last work plane. */
+    uint64_t job_shell_position() const { return work_plane_positions_[work_plane_positions_.size() - 1]; }
+
+    /** Whether all work planes are indexed, i.e. JobIndex::IndexAll was called or the index was loaded from file. */
+    bool is_fully_indexed() const { return is_fully_indexed_; }
+
+    /**
+     * @brief Gets the byte range of a work plane, up to the next work plane or the job shell.
+     * 
+     * @throws std::runtime_error The work plane index is invalid.
+     */
+    void GetWorkPlaneRange(const int i_work_plane, size_t& start_offset, size_t& end_offset) const
+    {
+        CheckWorkPlaneIndex(i_work_plane);
+
+        start_offset = work_plane_positions_[i_work_plane];
+        end_offset = work_plane_positions_[i_work_plane + 1];
+    }
+
+    /**
+     * @brief Gets the positions of the contents of a work plane, indexing it on first access.
+     * 
+     * Thread-safe. If indexing fails, the exception is propagated and the next access retries.
+     * 
+     * @param i_work_plane The index of the work plane.
+     * @param load Callable (int i_work_plane, WorkPlaneLUT& wpl) reading the lut of a work plane.
+     * @throws std::runtime_error The work plane index is invalid.
+     */
+    template <class LoadFn>
+    WorkPlaneEntry GetWorkPlane(const int i_work_plane, LoadFn load) const
+    {
+        CheckWorkPlaneIndex(i_work_plane);
+
+        if (is_fully_indexed_)
+        {
+            return WorkPlaneEntry{
+                Span<const uint64_t>{
+                    vector_block_positions_.data() + first_vector_blocks_[i_work_plane],
+                    (size_t)(first_vector_blocks_[i_work_plane + 1] - first_vector_blocks_[i_work_plane])
+                },
+                shell_positions_[i_work_plane]
+            };
+        }
+
+        auto& slot = work_planes_[i_work_plane];
+        if (!slot.is_indexed.load(std::memory_order_acquire))
+        {
+            std::call_once(slot.is_indexing, [&](){
+                WorkPlaneLUT wpl{};
+                load(i_work_plane, wpl);
+
+                const size_t count = (size_t)wpl.vectorblockspositions_size();
+                slot.positions = std::make_unique<uint64_t[]>(count);
+                std::copy(wpl.vectorblockspositions().begin(), wpl.vectorblockspositions().end(), slot.positions.get());
+
+                slot.entry.vector_block_positions = Span<const uint64_t>{slot.positions.get(), count};
+                slot.entry.shell_position = (uint64_t)wpl.workplaneshellposition();
+                slot.is_indexed.store(true, std::memory_order_release);
+            });
+        }
+
+        return slot.entry;
+    }
+
+    /**
+     * @brief Indexes all work planes at once, into contiguous arrays.
+     * 
+     * Must be called before any other access to the work planes. Afterwards, looking
+     * up a work plane only reads from these arrays.
+     * 
+     * @param load Callable (int i_work_plane, WorkPlaneLUT& wpl) reading the lut of a work plane.
+     */
+    template <class LoadFn>
+    void IndexAll(LoadFn load)
+    {
+        const int num_wps = num_work_planes();
+        uint64_t *first_vector_blocks = table_storage_.data() + num_wps + 1;
+        uint64_t *shell_positions = first_vector_blocks + num_wps + 1;
+
+        WorkPlaneLUT wpl{};
+        for (int i = 0; i < num_wps; i++)
+        {
+            wpl.Clear();
+            load(i, wpl);
+
+            first_vector_blocks[i] = vector_block_storage_.size();
+            vector_block_storage_.insert(vector_block_storage_.end(),
+                wpl.vectorblockspositions().begin(), wpl.vectorblockspositions().end());
+            shell_positions[i] = (uint64_t)wpl.workplaneshellposition();
+        }
+        first_vector_blocks[num_wps] = vector_block_storage_.size();
+        vector_block_storage_.shrink_to_fit();
+
+        vector_block_positions_ = Span<const uint64_t>{vector_block_storage_.data(), vector_block_storage_.size()};
+
+        // slots for lazy indexing are not needed anymore
+        work_planes_.reset();
+        is_fully_indexed_ = true;
+    }
+
+    /**
+     * @brief Approximate memory used by the index in bytes, not counting a mapped index file.
+     */
+    size_t SpaceUsed() const
+    {
+        size_t space = sizeof(*this)
+            + table_storage_.capacity() * sizeof(uint64_t)
+            + vector_block_storage_.capacity() * sizeof(uint64_t);
+
+        if (!is_fully_indexed_)
+        {
+            space += num_work_planes() * sizeof(WorkPlaneSlot);
+            for (int i = 0; i < num_work_planes(); i++)
+            {
+                if (work_planes_[i].is_indexed)
+                    space += work_planes_[i].entry.vector_block_positions.size() * sizeof(uint64_t);
+            }
+        }
+
+        return space;
+    }
+
+private:
+    /** A work plane indexed on first access. */
+    struct WorkPlaneSlot
+    {
+        std::atomic<bool> is_indexed{false};
+        std::once_flag is_indexing;
+        WorkPlaneEntry entry;
+        std::unique_ptr<uint64_t[]> positions;
+    };
+
+    JobIndex() = default;
+
+    // The arrays below are laid out as in the index file, either in the storage
+    // vectors or in the mapped index file:
+    //  - positions of all work planes, followed by the position of the job shell
+    //  - first vector block per work plane, followed by the total number of vector blocks
+    //  - shell position per work plane
+    //  - vector block positions of all work planes
+    // The vector block positions of work plane i are stored in
+    // [first_vector_blocks_[i], first_vector_blocks_[i + 1]) of vector_block_positions_.
+    // Except for the work plane positions, the arrays are only valid once fully indexed.
+    std::vector<uint64_t> table_storage_;
+    std::vector<uint64_t> vector_block_storage_;
+
+    std::shared_ptr<MemoryMapping> index_file_;
+    std::optional<FileView> index_file_view_;
+
+    Span<const uint64_t> work_plane_positions_;
+    Span<const uint64_t> first_vector_blocks_;
+    Span<const uint64_t> shell_positions_;
+    Span<const uint64_t> vector_block_positions_;
+
+    bool is_fully_indexed_ = false;
+
+    std::unique_ptr<WorkPlaneSlot[]> work_planes_;
+
+    /** Points the work plane, first vector block and shell position arrays into a table of 3 * num_wps + 2 entries. */
+    void SetTables(const uint64_t *table, const int num_wps)
+    {
+        work_plane_positions_ = Span<const uint64_t>{table, (size_t)num_wps + 1};
+        first_vector_blocks_ = Span<const uint64_t>{table + num_wps + 1, (size_t)num_wps + 1};
+        shell_positions_ = Span<const uint64_t>{table + 2 * num_wps + 2, (size_t)num_wps};
+    }
+
+    void CheckWorkPlaneIndex(const int i_work_plane) const
+    {
+        if (i_work_plane < 0 || i_work_plane > num_work_planes() - 1)
+            throw std::runtime_error("Invalid work plane index");
+    }
+};
+
+}
\ No newline at end of file
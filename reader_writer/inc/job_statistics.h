@@ -0,0 +1,206 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "open_vector_format.pb.h"
+#include "vector_block_view.h"
+#include "spatial_index.h"
+#include "span.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Figures on the vector data of a set of vector blocks, e.g. of a laser on a work plane.
+ * 
+ * Counts describe the geometry as stored, while lengths and times include the repeats of the
+ * vector blocks and work planes, i.e. describe what is actually exposed. Lengths are in the
+ * units of the coordinates, assumed to be mm.
+ */
+struct GeometryStatistics
+{
+    /** Number of vector blocks. */
+    uint64_t num_vector_blocks = 0;
+
+    /** Number of points of line sequences, hatches and point sequences, and number of arc and ellipse centers. */
+    uint64_t num_points = 0;
+
+    /** Number of marked vectors, i.e. line segments, hatch lines, arcs and ellipses. */
+    uint64_t num_vectors = 0;
+
+    /** Total length of the marked vectors. Ellipses and 3D arcs are counted, but not measured. */
+    double mark_length_in_mm = 0.0;
+
+    /** Total length of the jumps, within and between the vector blocks of a laser. */
+    double jump_length_in_mm = 0.0;
+
+    /** Estimated time spent marking, from the laser speed of the marking params. */
+    double mark_time_in_s = 0.0;
+
+    /** Estimated time spent jumping, from the jump speed of the marking params. */
+    double jump_time_in_s = 0.0;
+
+    /** Total time of exposure pauses. */
+    double pause_time_in_s = 0.0;
+
+    /** Length marked or jumped with marking params without a positive speed, so no time could be estimated. */
+    double unestimated_length_in_mm = 0.0;
+
+    /** Bounding box of the points and arc centers in the x-y plane. */
+    BoundingBox bounds{};
+
+    /** The estimated time of marking, jumping and pausing. */
+    double total_time_in_s() const { return mark_time_in_s + jump_time_in_s + pause_time_in_s; }
+
+    /** Adds the figures of other vector blocks. */
+    void Merge(const GeometryStatistics& other);
+};
+
+/**
+ * @brief Figures on the vector blocks assigned to a single laser.
+ */
+struct LaserStatistics : GeometryStatistics
+{
+    int32_t laser_index = 0;
+};
+
+/**
+ * @brief Figures on a single work plane, in total and per laser.
+ */
+struct WorkPlaneStatistics
+{
+    GeometryStatistics total;
+
+    /** One entry per laser with vector blocks on the work plane, ordered by laser index. */
+    std::vector<LaserStatistics> lasers;
+
+    /**
+     * @brief The estimated time to expose the work plane.
+     * 
+     * Lasers are assumed to expose in parallel, so this is the time of the busiest laser.
+     */
+    double estimated_time_in_s() const;
+};
+
+/**
+ * @brief Figures on a whole job, per work plane, per laser and in total.
+ */
+struct JobStatistics
+{
+    std::vector<WorkPlaneStatistics> work_planes;
+
+    GeometryStatistics total;
+
+    /** One entry per laser with vector blocks in the job, ordered by laser index. */
+    std::vector<LaserStatistics> lasers;
+
+    /** The estimated time to expose all work planes, see WorkPlaneStatistics::estimated_time_in_s(). */
+    double estimated_time_in_s = 0.0;
+
+    /**
+     * @brief How evenly the exposure time is distributed over the lasers.
+     * 
+     * The mean divided by the maximum of the total times of the lasers, i.e. 1 if all lasers
+     * are equally busy, and 1 / number of lasers if a single laser does all the work.
+     */
+    double load_balance() const;
+};
+
+/**
+ * @brief Accumulates the statistics of the vector blocks of a work plane, in file order.
+ * 
+ * Jumps between vector blocks are tracked per laser, from the last point of a vector block
+ * to the first point of the next vector block of the same laser, in the x-y plane. The
+ * lengths are computed with SIMD kernels over the packed coordinates where available.
+ */
+class WorkPlaneStatisticsBuilder
+{
+public:
+    /**
+     * @brief Construct a new Work Plane Statistics Builder object
+     * 
+     * @param marking_params_map The marking params of the job, for the speeds.
+     * @param work_plane_repeats The repeats of the work plane, counted as additional passes.
+     */
+    explicit WorkPlaneStatisticsBuilder(const google::protobuf::Map<int32_t, MarkingParams>& marking_params_map,
+        const int work_plane_repeats = 0);
+
+    /** Adds the next vector block of the work plane, read from a view without parsing the coordinates. */
+    void Add(const VectorBlockView& vb);
+
+    /** Adds the next vector block of the work plane. */
+    void Add(const VectorBlock& vb);
+
+    /** Gets the statistics of the vector blocks added so far. */
+    WorkPlaneStatistics Finish() const;
+
+private:
+    struct LaserState
+    {
+        LaserStatistics statistics;
+
+        /** Last point of the previous vector block, to measure the jump to the next one. */
+        float last_x = 0.0f;
+        float last_y = 0.0f;
+        bool has_last_point = false;
+    };
+
+    const google::protobuf::Map<int32_t, MarkingParams>& marking_params_map_;
+    const double passes_;
+
+    /** Per laser, ordered by laser index. */
+    std::vector<LaserState> lasers_;
+
+    LaserState& GetLaser(const int32_t laser_index);
+
+    void AddPoints(const VectorBlock::VectorDataCase vector_data_case, Span<const float> points,
+        const int dimensions, const int32_t marking_params_key, const int32_t laser_index, const uint64_t repeats);
+    void AddGeometry(LaserState& laser, const int32_t marking_params_key, const double mark_length, const double jump_length);
+
+    /** Measures the jump from the previous vector block of a laser, and remembers the last point of the current one. */
+    double JumpFromLastPoint(LaserState& laser, const float first_x, const float first_y, const float last_x, const float last_y) const;
+};
+
+/**
+ * @brief Computes the statistics of a work plane message.
+ * 
+ * @param wp The work plane.
+ * @param marking_params_map The marking params of the job, for the speeds.
+ */
+WorkPlaneStatistics ComputeWorkPlaneStatistics(const WorkPlane& wp, const google::protobuf::Map<int32_t, MarkingParams>& marking_params_map);
+
+/**
+ * @brief Combines the statistics of all work planes of a job into the job statistics.
+ */
+JobStatistics CombineWorkPlaneStatistics(std::vector<WorkPlaneStatistics> work_planes);
+
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+#include "file_view.h"
+#include "file_source.h"
+#include "span.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Source of an ovf file held in memory, e.g. received over the network.
+ * 
+ * Views point directly into the buffer, nothing is copied. The buffer is either
+ * borrowed, in which case the caller keeps it alive and unchanged as long as the
+ * source and its views are in use, or owned, in which case views share ownership
+ * of it and stay valid after the source is destroyed.
+ */
+class MemoryBuffer : public FileSource
+{
+public:
+    /**
+     * @brief Construct a new Memory Buffer object borrowing a buffer.
+     * 
+     * @param buffer The contents of the file, must outlive the source and its views.
+     */
+    explicit MemoryBuffer(Span<const uint8_t> buffer)
+        : buffer_{buffer}
+    {}
+
+    /**
+     * @brief Construct a new Memory Buffer object sharing ownership of a buffer.
+     * 
+     * @param buffer The contents of the file.
+     * @param owner Owner of the memory of the buffer, e.g. a network message. Kept alive
+     * as long as the source or any of its views exist.
+     */
+    MemoryBuffer(Span<const uint8_t> buffer, std::shared_ptr<const void> owner)
+        : buffer_{buffer}, owner_{std::move(owner)}
+    {}
+
+    /**
+     * @brief Construct a new Memory Buffer object taking ownership of a buffer.
+     * 
+     * @param buffer The contents of the file, moved into the source without copying.
+     */
+    explicit MemoryBuffer(std::vector<uint8_t>&& buffer)
+    {
+        auto owned = std::make_shared<const std::vector<uint8_t>>(std::move(buffer));
+        buffer_ = Span<const uint8_t>{owned->data(), owned->size()};
+        owner_ = std::move(owned);
+    }
+
+    /**
+     * @brief Create a new FileView pointing into the buffer, see FileSource::CreateView().
+     * 
+     * The view extends to the end of the buffer.
+     */
+    FileView CreateView(const size_t offset, const size_t min_size) const override
+    {
+        if (offset > buffer_.size() || min_size > buffer_.size() - offset)
+            throw std::runtime_error("Requested view exceeds the buffer");
+
+        // views are read-only, the pointer is only non-const for compatibility with mappings
+        return FileView{const_cast<uint8_t*>(buffer_.data()) + offset, buffer_.size() - offset, owner_};
+    }
+
+    /**
+     * @brief Accessor for the size of the buffer.
+     * 
+     * @return size_t The size of the full file in bytes.
+     */
+    size_t file_size() const override
+    {
+        return buffer_.size();
+    }
+
+    /**
+     * @brief Views point into the buffer, see FileSource::copies_data().
+     */
+    bool copies_data() const override
+    {
+        return false;
+    }
+
+    /**
+     * @brief Reports whether the buffer is owned by the source, rather than borrowed.
+     */
+    bool is_owned() const
+    {
+        return owner_ != nullptr;
+    }
+
+private:
+    /** The contents of the file. */
+    Span<const uint8_t> buffer_;
+
+    /** Owner of the buffer, nullptr if it is borrowed. */
+    std::shared_ptr<const void> owner_;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+
+#include "file_view.h"
+#include "file_source.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Hint on how the mapped file contents are going to be accessed.
+ * 
+ * Forwarded to the operating system, so that read-ahead and page eviction
+ * match the way a job is consumed.
+ */
+enum class AccessPattern
+{
+    /** No specific access pattern, default operating system behaviour. */
+    kNormal,
+    /** Contents are read front to back, e.g. when streaming work planes layer by layer. */
+    kSequential,
+    /** Contents are read at random offsets, e.g. when fetching single vector blocks. */
+    kRandom
+};
+
+/**
+ * @brief Strategy for mapping file contents to the address space.
+ */
+enum class MappingMode
+{
+    /** The whole file is mapped once and views are slices of that mapping. Falls back to
+     *  kWindowed if the file exceeds the address space budget. */
+    kPersistent,
+    /** A small set of fixed size windows is mapped and reused for all views that fit
+     *  into a window. Windows are pinned as long as views into them exist. */
+    kWindowed,
+    /** Every view creates and releases its own mapping. */
+    kPerView
+};
+
+/**
+ * @brief Mechanism to access the contents of a file.
+ */
+enum class IoBackend
+{
+    /** The file is mapped into memory, see MemoryMapping and MappingMode. */
+    kMemoryMapping,
+    /** Ranges of the file are read into reusable buffers, see BufferedFile. Avoids page
+     *  faults while parsing, e.g. on network file systems, at the cost of copying. */
+    kBufferedRead
+};
+
+/**
+ * @brief Options to control how a file is mapped into memory.
+ */
+struct MappingOptions
+{
+    /** Access pattern hint applied to the whole file on construction of the mapping. */
+    AccessPattern access_pattern = AccessPattern::kNormal;
+
+    /** Strategy for mapping the file contents. */
+    MappingMode mode = MappingMode::kPersistent;
+
+    /** Maximum number of bytes of address space the mapping should occupy. 0 is unlimited,
+     *  which is the default on 64 bit systems. */
+    size_t address_space_budget = sizeof(void*) >= 8 ? 0 : ((size_t)1 << 29);
+
+    /** Size of a single mapping window in bytes, used in MappingMode::kWindowed. */
+    size_t window_size = (size_t)1 << 26;
+
+    /** Mechanism to access the file. All other options apply to kMemoryMapping, except
+     *  for the access pattern hint, which applies to both. */
+    IoBackend io_backend = IoBackend::kMemoryMapping;
+
+    /** Whether to read the whole file into memory when mapping it, so that reads do not
+     *  page fault later on (MAP_POPULATE). Applies to MappingMode::kPersistent, and to each
+     *  window or view mapped in the other modes. */
+    bool populate = false;
+
+    /** Whether to lock the whole file into physical memory when mapping it (mlock). Opening
+     *  the file fails if locking is denied, e.g. due to RLIMIT_MEMLOCK. Only applies to
+     *  MappingMode::kPersistent, see MemoryMapping::Lock() for locking selected ranges. */
+    bool lock = false;
+
+    /** Whether to advise backing the mapping with transparent huge pages (MADV_HUGEPAGE),
+     *  which reduces TLB misses on large files. Advisory only, it depends on the operating
+     *  system and file system, and is ignored on Windows. Only applies to MappingMode::kPersistent. */
+    bool huge_pages = false;
+};
+
+/**
+ * @brief Memory usage and page fault counters of the whole process, see GetProcessMemoryUsage().
+ * 
+ * Figures not available on a platform are reported as 0.
+ */
+struct ProcessMemoryUsage
+{
+    /** Resident set size of the process in bytes. */
+    size_t resident_bytes = 0;
+
+    /** Number of page faults of the process so far, including major ones. */
+    size_t page_faults = 0;
+
+    /** Number of page faults which required reading from disk. */
+    size_t major_page_faults = 0;
+};
+
+/**
+ * @brief Cache of pinned mapping windows, shared by the platform specific memory mappings.
+ * 
+ * Each window starts at a multiple of the window size and spans two window sizes, so every
+ * range of up to one window size is fully contained in exactly one window. Least recently
+ * used windows are released from the cache when the budget is exceeded, but stay mapped as
+ * long as views into them exist.
+ */
+class MappingWindowCache
+{
+public:
+    /**
+     * @brief Construct a new Mapping Window Cache object
+     * 
+     * @param window_size Stride of the windows in bytes. Must be a multiple of the mapping granularity.
+     * @param max_windows Maximum number of windows held by the cache.
+     */
+    MappingWindowCache(size_t window_size, size_t max_windows)
+        : window_size_{window_size}, max_windows_{std::max<size_t>(max_windows, 1)}
+    {}
+
+    /**
+     * @brief Reports whether a range can be served from a single window.
+     */
+    bool Fits(const size_t size) const
+    {
+        return size <= window_size_;
+    }
+
+    /**
+     * @brief Creates a view into the window containing the requested range.
+     * 
+     * @tparam MapFn Callable mapping a range of the file, taking offset and size, returning
+     * a std::shared_ptr<uint8_t> owning the mapped memory.
+     * @param offset The absolute offset in bytes from the beginning of the file.
+     * @param file_size Size of the full file in bytes.
+     * @param map Function to map a new window.
+     * @return A file view pinning the window it points into.
+     */
+    template <class MapFn>
+    FileView CreateView(const size_t offset, const size_t file_size, MapFn map)
+    {
+        const size_t window_offset = (offset / window_size_) * window_size_;
+        const size_t window_length = std::min(2 * window_size_, file_size - window_offset);
+
+        std::lock_guard lock{mutex_};
+
+        auto it = std::find_if(windows_.begin(), windows_.end(),
+            [window_offset](const Window& w){ return w.offset == window_offset; });
+
+        if (it != windows_.end())
+        {
+            // move to front, i.e. mark as most recently used
+            windows_.splice(windows_.begin(), windows_, it);
+        }
+        else
+        {
+            windows_.push_front(Window{window_offset, window_length, map(window_offset, window_length)});
+            if (windows_.size() > max_windows_)
+                windows_.pop_back();
+        }
+
+        const auto& window = windows_.front();
+        return FileView{
+            window.base.get() + (offset - window.offset),
+            window.size - (offset - window.offset),
+            window.base
+        };
+    }
+
+private:
+    /** A single mapped window. */
+    struct Window
+    {
+        size_t offset;
+        size_t size;
+        std::shared_ptr<uint8_t> base;
+    };
+
+    /** Stride of the windows in bytes. */
+    size_t window_size_;
+
+    /** Maximum number of windows held by the cache. */
+    size_t max_windows_;
+
+    /** Windows, ordered from most to least recently used. */
+    std::list<Window> windows_;
+
+    /** Guards the window list, as views are created concurrently by readers. */
+    std::mutex mutex_;
+};
+
+}
+
+#if (defined WIN32 || defined _WIN32)
+#  include "memory_mapping_win32.h"
+#else
+#  include "memory_mapping_posix.h"
+#endif
\ No newline at end of file
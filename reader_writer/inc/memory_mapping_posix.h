@@ -0,0 +1,463 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#if (defined WIN32 || defined _WIN32)
+#  error posix headers included for win32 build
+#endif
+
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "memory_mapping.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief POSIX specific implementation for memory mapping files.
+ * 
+ * Implements memory mapping behaviour based on mmap. By default, the whole file is
+ * mapped once on construction, and views are handed out as slices of that mapping.
+ * See MappingMode for alternative strategies.
+ */
+class MemoryMapping : public FileSource
+{
+public:
+
+    /** Views are platform independent, see file_view.h. */
+    using FileView = reader_writer::FileView;
+
+    /**
+     * @brief Construct a new Memory Mapping object
+     * 
+     * @param path A valid path to a file. The contents of this file will be mapped to memory.
+     * @param options Options controlling the mapping, e.g. the expected access pattern.
+     * @throws std::runtime_error The file could not be opened or mapped.
+     */
+    MemoryMapping(const std::string path, const MappingOptions& options = {})
+        : mode_{options.mode}, populate_{options.populate}
+    {
+        page_size_ = (size_t)sysconf(_SC_PAGESIZE);
+
+        file_ = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file_ < 0)
+        {
+            throw std::runtime_error("Opening file \"" + path + "\" failed: " + std::strerror(errno));
+        }
+
+        struct stat file_stat;
+        if (fstat(file_, &file_stat) != 0)
+        {
+            close(file_);
+            throw std::runtime_error("Querying size of file \"" + path + "\" failed: " + std::strerror(errno));
+        }
+        file_size_ = (size_t)file_stat.st_size;
+
+        if (mode_ == MappingMode::kPersistent && options.address_space_budget != 0 &&
+            file_size_ > options.address_space_budget)
+        {
+            mode_ = MappingMode::kWindowed;
+        }
+
+        // mmap does not accept empty mappings
+        if (mode_ == MappingMode::kPersistent && file_size_ > 0)
+        {
+            void *base = mmap(nullptr, file_size_, PROT_READ, MapFlags(), file_, 0);
+            if (base == MAP_FAILED)
+            {
+                close(file_);
+                throw std::runtime_error("Creating file mapping for file \"" + path + "\" failed: " + std::strerror(errno));
+            }
+            base_addr_ = static_cast<uint8_t*>(base);
+
+#ifdef MADV_HUGEPAGE
+            if (options.huge_pages)
+                madvise(base_addr_, file_size_, MADV_HUGEPAGE);
+#endif
+
+            if (options.lock && mlock(base_addr_, file_size_) != 0)
+            {
+                const int error = errno;
+                munmap(base_addr_, file_size_);
+                close(file_);
+                throw std::runtime_error("Locking file \"" + path + "\" into memory failed: " + std::strerror(error));
+            }
+        }
+
+        if (mode_ == MappingMode::kWindowed)
+        {
+            size_t window_size = ((std::max(options.window_size, page_size_) + page_size_ - 1) / page_size_) * page_size_;
+            size_t max_windows = options.address_space_budget == 0 ? 16 : options.address_space_budget / (2 * window_size);
+            windows_ = std::make_unique<MappingWindowCache>(window_size, max_windows);
+        }
+
+        access_pattern_ = options.access_pattern;
+        Advise(0, file_size_, access_pattern_);
+    }
+
+    // RAII and copy constructors are hard to get right.
+    // When they are not necessary, it's better to delete them.
+    MemoryMapping(const MemoryMapping&) = delete;
+    MemoryMapping& operator=(const MemoryMapping&) = delete;
+
+    /**
+     * @brief Destroy the Memory Mapping object
+     * 
+     * Unmaps the persistent mapping and closes the file descriptor. Views into the
+     * persistent mapping are invalidated, while views holding their own mapping or
+     * a mapping window stay valid.
+     */
+    ~MemoryMapping()
+    {
+        if (base_addr_ != nullptr)
+            munmap(base_addr_, file_size_);
+        close(file_);
+    }
+
+    /**
+     * @brief Create a new FileView
+     * 
+     * @param offset The absolute offset in bytes from the beginning of the file.
+     * @param min_size The minimum size the view has to have, in bytes. When min_size
+     * is 0, the view extends to the end of the file.
+     * @return A new file view. The first byte of its data is guaranteed to be at the
+     * offset specified, and its size is at least as long as min_size.
+     * @throws std::runtime_error The requested range exceeds the file, or could not be mapped.
+     */
+    FileView CreateView(const size_t offset, const size_t min_size) const override
+    {
+        if (offset > file_size_ || min_size > file_size_ - offset)
+            throw std::runtime_error("Requested view exceeds the mapped file");
+
+        const size_t size = min_size == 0 ? file_size_ - offset : min_size;
+
+        if (mode_ == MappingMode::kPersistent)
+        {
+            return FileView{base_addr_ + offset, file_size_ - offset};
+        }
+
+        if (mode_ == MappingMode::kWindowed && windows_->Fits(size))
+        {
+            return windows_->CreateView(offset, file_size_,
+                [this](size_t o, size_t s){ return MapRegion(o, s); });
+        }
+
+        // dedicated mapping, released with the view
+        size_t aligned_offset = (offset / page_size_) * page_size_;
+        auto region = MapRegion(aligned_offset, size + (offset - aligned_offset));
+        return FileView{region.get() + (offset - aligned_offset), size, region};
+    }
+
+    /**
+     * @brief Applies an access pattern hint to a range of the file.
+     * 
+     * Hints are forwarded to the page cache (posix_fadvise) and to the mapping (madvise).
+     * They are advisory only, failures are therefore silently ignored.
+     * 
+     * @param offset The absolute offset in bytes from the beginning of the file.
+     * @param size The size of the range in bytes.
+     * @param pattern The expected access pattern for the range.
+     */
+    void Advise(const size_t offset, const size_t size, const AccessPattern pattern) const
+    {
+        if (offset >= file_size_ || size == 0)
+            return;
+
+        int madvice = MADV_NORMAL;
+        int fadvice = POSIX_FADV_NORMAL;
+        switch (pattern)
+        {
+            case AccessPattern::kSequential:
+                madvice = MADV_SEQUENTIAL;
+                fadvice = POSIX_FADV_SEQUENTIAL;
+                break;
+            case AccessPattern::kRandom:
+                madvice = MADV_RANDOM;
+                fadvice = POSIX_FADV_RANDOM;
+                break;
+            default:
+                break;
+        }
+
+        // madvise requires a page aligned start address, and is only
+        // applicable while the range is mapped persistently
+        if (base_addr_ != nullptr)
+        {
+            size_t aligned_offset = (offset / page_size_) * page_size_;
+            size_t aligned_size = std::min(size + (offset - aligned_offset), file_size_ - aligned_offset);
+            madvise(base_addr_ + aligned_offset, aligned_size, madvice);
+        }
+        posix_fadvise(file_, (off_t)offset, (off_t)size, fadvice);
+    }
+
+    /**
+     * @brief Locks a range of the persistent mapping into physical memory (mlock), see FileSource::Lock().
+     * 
+     * Locks whole pages, which may include parts of the neighbouring ranges.
+     */
+    bool Lock(const size_t offset, const size_t size) const override
+    {
+        size_t aligned_offset, aligned_size;
+        if (!GetPageRange(offset, size, false, aligned_offset, aligned_size))
+            return false;
+
+        return mlock(base_addr_ + aligned_offset, aligned_size) == 0;
+    }
+
+    /**
+     * @brief Unlocks a range of the persistent mapping locked with Lock() (munlock).
+     */
+    void Unlock(const size_t offset, const size_t size) const override
+    {
+        size_t aligned_offset, aligned_size;
+        if (GetPageRange(offset, size, false, aligned_offset, aligned_size))
+            munlock(base_addr_ + aligned_offset, aligned_size);
+    }
+
+    /**
+     * @brief Releases the pages of a range of the persistent mapping (MADV_DONTNEED), see FileSource::Release().
+     * 
+     * Only pages lying completely within the range are released, so neighbouring ranges stay
+     * resident. The pages stay in the page cache, they are only removed from the process.
+     */
+    void Release(const size_t offset, const size_t size) const override
+    {
+        size_t aligned_offset, aligned_size;
+        if (GetPageRange(offset, size, true, aligned_offset, aligned_size))
+            madvise(base_addr_ + aligned_offset, aligned_size, MADV_DONTNEED);
+    }
+
+    /**
+     * @brief Reports how much of the persistent mapping is resident in and locked into the process.
+     * 
+     * Read from /proc/self/smaps on Linux. Other systems only report the resident pages
+     * (mincore), which includes pages cached by the operating system but not yet mapped into
+     * the process. Nothing is reported in modes other than MappingMode::kPersistent.
+     */
+    ResidentMemory GetResidentMemory() const override
+    {
+        ResidentMemory memory;
+        if (base_addr_ == nullptr)
+            return memory;
+
+#ifdef __linux__
+        // mlock and madvise may split the mapping into several areas
+        const uintptr_t begin = reinterpret_cast<uintptr_t>(base_addr_);
+        const uintptr_t end = begin + file_size_;
+
+        std::ifstream smaps{"/proc/self/smaps"};
+        std::string line;
+        bool is_in_mapping = false;
+        while (std::getline(smaps, line))
+        {
+            unsigned long long area_begin, area_end;
+            if (std::sscanf(line.c_str(), "%llx-%llx ", &area_begin, &area_end) == 2)
+            {
+                is_in_mapping = area_begin >= begin && area_end <= ((end + page_size_ - 1) / page_size_) * page_size_;
+            }
+            else if (is_in_mapping && line.compare(0, 4, "Rss:") == 0)
+            {
+                memory.resident_bytes += std::strtoull(line.c_str() + 4, nullptr, 10) * 1024;
+            }
+            else if (is_in_mapping && line.compare(0, 7, "Locked:") == 0)
+            {
+                memory.locked_bytes += std::strtoull(line.c_str() + 7, nullptr, 10) * 1024;
+            }
+        }
+#else
+#  ifdef __APPLE__
+        std::vector<char> pages((file_size_ + page_size_ - 1) / page_size_);
+#  else
+        std::vector<unsigned char> pages((file_size_ + page_size_ - 1) / page_size_);
+#  endif
+        if (mincore(base_addr_, file_size_, pages.data()) == 0)
+        {
+            for (auto page : pages)
+                memory.resident_bytes += (page & 1) ? page_size_ : 0;
+        }
+#endif
+
+        return memory;
+    }
+
+    /**
+     * @brief Accessor for the size of the full file.
+     * 
+     * @return size_t The size of the full file in bytes.
+     */
+    size_t file_size() const override
+    {
+        return file_size_;
+    }
+
+    /**
+     * @brief Views point into the mapped file, see FileSource::copies_data().
+     */
+    bool copies_data() const override
+    {
+        return false;
+    }
+
+    /**
+     * @brief Accessor for the effective mapping mode.
+     * 
+     * @return MappingMode The mode in use, which may differ from the requested one if
+     * the file exceeded the address space budget.
+     */
+    MappingMode mode() const
+    {
+        return mode_;
+    }
+
+private:
+    /** File descriptor of the mapped file. */
+    int file_ = -1;
+
+    /** Base address of the persistent mapping of the full file. Null for empty files and other modes. */
+    uint8_t *base_addr_ = nullptr;
+
+    /** Full file size, queried on construction. */
+    size_t file_size_ = 0;
+
+    /** System page size, queried on construction. Mappings must be page-aligned. */
+    size_t page_size_ = 0;
+
+    /** The effective mapping mode. */
+    MappingMode mode_;
+
+    /** The access pattern hint the file was opened with. Applied to each new mapping. */
+    AccessPattern access_pattern_ = AccessPattern::kNormal;
+
+    /** Whether mappings are populated on creation. */
+    bool populate_ = false;
+
+    /** Pinned mapping windows, only used in MappingMode::kWindowed. */
+    std::unique_ptr<MappingWindowCache> windows_;
+
+    /**
+     * @brief Flags for mmap, according to the mapping options.
+     */
+    int MapFlags() const
+    {
+#ifdef MAP_POPULATE
+        return populate_ ? MAP_SHARED | MAP_POPULATE : MAP_SHARED;
+#else
+        return MAP_SHARED;
+#endif
+    }
+
+    /**
+     * @brief Gets the pages of the persistent mapping covering a range of the file.
+     * 
+     * @param inner Whether to only include pages lying completely within the range,
+     * otherwise all pages touched by the range are included.
+     * @return false There is no persistent mapping, or no page is included.
+     */
+    bool GetPageRange(const size_t offset, const size_t size, const bool inner, size_t& aligned_offset, size_t& aligned_size) const
+    {
+        if (base_addr_ == nullptr || offset >= file_size_ || size == 0)
+            return false;
+
+        const size_t end = std::min(offset + size, file_size_);
+        aligned_offset = inner ? ((offset + page_size_ - 1) / page_size_) * page_size_ : (offset / page_size_) * page_size_;
+
+        // the last page of the file counts as complete, as there is nothing behind it
+        const size_t aligned_end = inner && end != file_size_ ? (end / page_size_) * page_size_ : end;
+        if (aligned_end <= aligned_offset)
+            return false;
+
+        aligned_size = aligned_end - aligned_offset;
+        return true;
+    }
+
+    /**
+     * @brief Maps a page aligned range of the file.
+     * 
+     * @param offset Page aligned offset of the range in bytes.
+     * @param size Size of the range in bytes.
+     * @return std::shared_ptr<uint8_t> Owner of the mapped range, unmapping it on release.
+     */
+    std::shared_ptr<uint8_t> MapRegion(const size_t offset, const size_t size) const
+    {
+        if (size == 0)
+            return std::shared_ptr<uint8_t>{};
+
+        void *addr = mmap(nullptr, size, PROT_READ, MapFlags(), file_, (off_t)offset);
+        if (addr == MAP_FAILED)
+            throw std::runtime_error(std::string{"Mapping file view failed: "} + std::strerror(errno));
+
+        if (access_pattern_ != AccessPattern::kNormal)
+            madvise(addr, size, access_pattern_ == AccessPattern::kSequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+        return std::shared_ptr<uint8_t>{
+            static_cast<uint8_t*>(addr),
+            [size](uint8_t *p){ munmap(p, size); }
+        };
+    }
+};
+
+/**
+ * @brief Queries memory usage and page fault counters of the whole process.
+ * 
+ * The resident set size is read from /proc/self/statm, and reported as 0 on systems without it.
+ */
+inline ProcessMemoryUsage GetProcessMemoryUsage()
+{
+    ProcessMemoryUsage usage;
+
+    struct rusage resources;
+    if (getrusage(RUSAGE_SELF, &resources) == 0)
+    {
+        usage.page_faults = (size_t)resources.ru_minflt + (size_t)resources.ru_majflt;
+        usage.major_page_faults = (size_t)resources.ru_majflt;
+    }
+
+    std::ifstream statm{"/proc/self/statm"};
+    size_t total_pages, resident_pages;
+    if (statm >> total_pages >> resident_pages)
+        usage.resident_bytes = resident_pages * (size_t)sysconf(_SC_PAGESIZE);
+
+    return usage;
+}
+
+}
\ No newline at end of file
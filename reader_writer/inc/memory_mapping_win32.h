@@ -33,10 +33,15 @@ SOFTWARE.
 #endif
 
 #include <string>
+#include <memory>
+#include <vector>
 #include <stdexcept>
 #include <windows.h>
 #include <fileapi.h>
 #include <sysinfoapi.h>
+#include <psapi.h>
+
+#include "memory_mapping.h"
 
 namespace open_vector_format::reader_writer {
 
@@ -44,90 +49,40 @@ namespace open_vector_format::reader_writer {
  * @brief WIN32 specific implementation for memory mapping files.
  * 
  * Implements memory mapping behaviour based on direct calls to the WIN32 C API.
+ * By default, the whole file is mapped once on construction, and views are handed
+ * out as slices of that mapping. See MappingMode for alternative strategies.
  */
-class MemoryMapping
+class MemoryMapping : public FileSource
 {
 public:
 
-    /**
-     * @brief WIN32 specific implementation for a memory mapped view of a file.
-     * 
-     * Implements the view of a memory mapped file, abstracting over the WIN32 C API
-     * and page-aligning the memory map.
-     */
-    class FileView
-    {
-    public:
-
-        /**
-         * @brief Construct a new File View object
-         * 
-         * @param base_addr The base address in memory at which the memory mapping starts.
-         * @param start_addr The address in memory at which the data actually starts. Must be greater or equal to base_addr.
-         * @param size_from_base_addr The absolute size of the complete memory mapping.
-         */
-        FileView(uint8_t *base_addr, uint8_t *start_addr, size_t size_from_base_addr)
-            : base_addr_{base_addr}, start_addr_{start_addr}, size_from_base_addr_{size_from_base_addr}
-        {}
-
-        // RAII and copy constructors are hard to get right.
-        // When they are not necessary, it's better to delete them.
-        FileView(const FileView&) = delete;
-        FileView& operator=(const FileView&) = delete;
-        
-        /**
-         * @brief Destroy the File View object
-         * 
-         * Unmaps the file view.
-         */
-        ~FileView()
-        {
-            UnmapViewOfFile(base_addr_);
-        }
-
-        /**
-         * @brief Accessor to the mapped data.
-         * 
-         * @return uint8_t* Pointer to the memory segment representing the exact offset from the
-         * beginning of the file as requested on creation. Guaranteed to be valid for the size
-         * available in the size() accessor.
-         */
-        uint8_t *data() const
-        {
-            return start_addr_;
-        }
-
-        /**
-         * @brief Accessor to the size of mapped data.
-         * 
-         * @return size_t The size in bytes of this mapping. This number may be higher than the requestes
-         * minimum size.
-         */
-        size_t size() const
-        {
-            return size_from_base_addr_ - ((SIZE_T)start_addr_ - (SIZE_T)base_addr_);
-        }
-
-    private:
-        /** The base address in memory at which the memory mapping starts. */
-        uint8_t *base_addr_;
-
-        /** The address in memory at which the data actually starts. Must be greater or equal to base_addr. */
-        uint8_t *start_addr_;
-
-        /** The absolute size of the complete memory mapping. */
-        SIZE_T size_from_base_addr_;
-    };
+    /** Views are platform independent, see file_view.h. */
+    using FileView = reader_writer::FileView;
 
     /**
      * @brief Construct a new Memory Mapping object
      * 
      * @param path A valid path to a file. The contents of this file will be mapped to memory.
+     * @param options Options controlling the mapping, e.g. the expected access pattern.
      * @throws std::runtime_error A handle to the file could not be obtained.
      */
-    MemoryMapping(const std::string path)
+    MemoryMapping(const std::string path, const MappingOptions& options = {})
+        : mode_{options.mode}, populate_{options.populate}
     {
         GetSystemInfo(&system_info_);
+
+        DWORD access_flags = 0;
+        switch (options.access_pattern)
+        {
+            case AccessPattern::kSequential:
+                access_flags = FILE_FLAG_SEQUENTIAL_SCAN;
+                break;
+            case AccessPattern::kRandom:
+                access_flags = FILE_FLAG_RANDOM_ACCESS;
+                break;
+            default:
+                break;
+        }
         
         file_ = CreateFileA(
             path.c_str(),
@@ -135,7 +90,7 @@ public:
             FILE_SHARE_READ,
             nullptr,
             OPEN_EXISTING,
-            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            FILE_ATTRIBUTE_NORMAL | access_flags,
             nullptr
         );
 
@@ -148,6 +103,12 @@ public:
         low = GetFileSize(file_, &high);
         file_size_ = (((uint64_t)high) << 32) | ((uint64_t)low);
 
+        // empty files can't be mapped
+        if (file_size_ == 0)
+        {
+            return;
+        }
+
         file_mapping_ = CreateFileMappingA(
             file_,
             nullptr,
@@ -157,10 +118,47 @@ public:
             nullptr
         );
 
-        if (file_mapping_ == INVALID_HANDLE_VALUE)
+        if (file_mapping_ == nullptr)
         {
-            throw std::runtime_error("Creating file mapping for file \"" + path + "\" failed");
             CloseHandle(file_);
+            throw std::runtime_error("Creating file mapping for file \"" + path + "\" failed");
+        }
+
+        if (mode_ == MappingMode::kPersistent && options.address_space_budget != 0 &&
+            file_size_ > options.address_space_budget)
+        {
+            mode_ = MappingMode::kWindowed;
+        }
+
+        if (mode_ == MappingMode::kPersistent)
+        {
+            base_addr_ = static_cast<uint8_t*>(MapViewOfFile(file_mapping_, FILE_MAP_READ, 0, 0, 0));
+            if (base_addr_ == nullptr)
+            {
+                CloseHandle(file_mapping_);
+                CloseHandle(file_);
+                throw std::runtime_error("Mapping file \"" + path + "\" failed");
+            }
+
+            // large pages are not supported for file mappings, options.huge_pages is ignored
+            if (populate_)
+                Populate(base_addr_, file_size_);
+
+            if (options.lock && !VirtualLock(base_addr_, file_size_))
+            {
+                UnmapViewOfFile(base_addr_);
+                CloseHandle(file_mapping_);
+                CloseHandle(file_);
+                throw std::runtime_error("Locking file \"" + path + "\" into memory failed");
+            }
+        }
+
+        if (mode_ == MappingMode::kWindowed)
+        {
+            SIZE_T granularity = system_info_.dwAllocationGranularity;
+            SIZE_T window_size = ((std::max<SIZE_T>(options.window_size, granularity) + granularity - 1) / granularity) * granularity;
+            SIZE_T max_windows = options.address_space_budget == 0 ? 16 : options.address_space_budget / (2 * window_size);
+            windows_ = std::make_unique<MappingWindowCache>(window_size, max_windows);
         }
     }
 
@@ -172,13 +170,16 @@ public:
     /**
      * @brief Destroy the Memory Mapping object
      * 
-     * Handles to the file mapping and file itself are closed.
-     * This does not invalidate views that are still opened, as those hold
-     * handles to the file mapping themselves.
+     * Handles to the file mapping and file itself are closed, and the persistent
+     * mapping is unmapped. This does not invalidate views holding their own mapping
+     * or a mapping window, as those hold handles to the file mapping themselves.
      */
     ~MemoryMapping()
     {
-        CloseHandle(file_mapping_);
+        if (base_addr_ != nullptr)
+            UnmapViewOfFile(base_addr_);
+        if (file_mapping_ != nullptr)
+            CloseHandle(file_mapping_);
         CloseHandle(file_);
     }
 
@@ -190,38 +191,116 @@ public:
      * is 0, the mapping extends to the end of the file.
      * @return A new file view. The first byte of its data is guaranteed to be at the 
      * offset specified, and its size is at least as long as min_size.
+     * @throws std::runtime_error The requested range exceeds the file, or could not be mapped.
      */
-    FileView CreateView(const size_t offset, const size_t min_size) const
+    FileView CreateView(const size_t offset, const size_t min_size) const override
     {
-        DWORD granularity = system_info_.dwAllocationGranularity;
-        SIZE_T granularized_offset = (offset / granularity) * granularity;
+        if (offset > file_size_ || min_size > file_size_ - offset)
+            throw std::runtime_error("Requested view exceeds the mapped file");
 
-        DWORD offset_low = static_cast<DWORD>(granularized_offset & 0xFFFFFFFFul);
-        DWORD offset_high = static_cast<DWORD>((granularized_offset >> 32) & 0xFFFFFFFFul);
+        const SIZE_T size = min_size == 0 ? file_size_ - offset : min_size;
 
-        SIZE_T corrected_min_size = ((offset - granularized_offset) + min_size);
-        SIZE_T granularized_min_size = (((corrected_min_size + 1) / granularity) * granularity);
-        if (granularized_offset + granularized_min_size >= file_size_)
+        if (mode_ == MappingMode::kPersistent)
         {
-            granularized_min_size = 0; // up to EOF
+            return FileView{base_addr_ + offset, file_size_ - offset};
         }
 
-        auto view = static_cast<uint8_t*>(MapViewOfFile(
-            file_mapping_,
-            FILE_MAP_READ,
-            offset_high,
-            offset_low,
-            min_size == 0 ? 0 : (SIZE_T)granularized_min_size
-        ));
-        
-        MEMORY_BASIC_INFORMATION map_info;
-        VirtualQuery(view, &map_info, sizeof(map_info));
+        if (mode_ == MappingMode::kWindowed && windows_->Fits(size))
+        {
+            return windows_->CreateView(offset, file_size_,
+                [this](size_t o, size_t s){ return MapRegion(o, s); });
+        }
 
-        return FileView{
-            view,
-            view + (offset - granularized_offset),
-            map_info.RegionSize
-        };
+        // dedicated mapping, released with the view
+        DWORD granularity = system_info_.dwAllocationGranularity;
+        SIZE_T aligned_offset = (offset / granularity) * granularity;
+        auto region = MapRegion(aligned_offset, size + (offset - aligned_offset));
+        return FileView{region.get() + (offset - aligned_offset), size, region};
+    }
+
+    /**
+     * @brief Applies an access pattern hint to a range of the file.
+     * 
+     * WIN32 only supports access pattern hints for the whole file when it is opened,
+     * see MappingOptions. Provided for interface compatibility, this is a no-op.
+     * 
+     * @param offset The absolute offset in bytes from the beginning of the file.
+     * @param size The size of the range in bytes.
+     * @param pattern The expected access pattern for the range.
+     */
+    void Advise(const size_t offset, const size_t size, const AccessPattern pattern) const
+    {
+    }
+
+    /**
+     * @brief Locks a range of the persistent mapping into physical memory (VirtualLock), see FileSource::Lock().
+     * 
+     * Locking is limited by the minimum working set size of the process.
+     */
+    bool Lock(const size_t offset, const size_t size) const override
+    {
+        if (base_addr_ == nullptr || offset >= file_size_ || size == 0)
+            return false;
+
+        return VirtualLock(base_addr_ + offset, std::min<SIZE_T>(size, file_size_ - offset)) != FALSE;
+    }
+
+    /**
+     * @brief Unlocks a range of the persistent mapping locked with Lock() (VirtualUnlock).
+     */
+    void Unlock(const size_t offset, const size_t size) const override
+    {
+        if (base_addr_ != nullptr && offset < file_size_ && size != 0)
+            VirtualUnlock(base_addr_ + offset, std::min<SIZE_T>(size, file_size_ - offset));
+    }
+
+    /**
+     * @brief Removes the pages of a range of the persistent mapping from the working set, see FileSource::Release().
+     * 
+     * Only pages lying completely within the range are released, so neighbouring ranges stay resident.
+     */
+    void Release(const size_t offset, const size_t size) const override
+    {
+        if (base_addr_ == nullptr || offset >= file_size_ || size == 0)
+            return;
+
+        const SIZE_T page_size = system_info_.dwPageSize;
+        const SIZE_T end = std::min<SIZE_T>(offset + size, file_size_);
+        const SIZE_T aligned_offset = ((offset + page_size - 1) / page_size) * page_size;
+        const SIZE_T aligned_end = end == file_size_ ? end : (end / page_size) * page_size;
+
+        // unlocking memory which is not locked removes it from the working set
+        if (aligned_end > aligned_offset)
+            VirtualUnlock(base_addr_ + aligned_offset, aligned_end - aligned_offset);
+    }
+
+    /**
+     * @brief Reports how much of the persistent mapping is in the working set of the process, and locked into it.
+     * 
+     * Nothing is reported in modes other than MappingMode::kPersistent.
+     */
+    ResidentMemory GetResidentMemory() const override
+    {
+        ResidentMemory memory;
+        if (base_addr_ == nullptr)
+            return memory;
+
+        const SIZE_T page_size = system_info_.dwPageSize;
+        std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages((file_size_ + page_size - 1) / page_size);
+        for (size_t i = 0; i < pages.size(); i++)
+            pages[i].VirtualAddress = base_addr_ + i * page_size;
+
+        if (!QueryWorkingSetEx(GetCurrentProcess(), pages.data(), (DWORD)(pages.size() * sizeof(PSAPI_WORKING_SET_EX_INFORMATION))))
+            return memory;
+
+        for (const auto& page : pages)
+        {
+            if (page.VirtualAttributes.Valid)
+                memory.resident_bytes += page_size;
+            if (page.VirtualAttributes.Valid && page.VirtualAttributes.Locked)
+                memory.locked_bytes += page_size;
+        }
+        return memory;
     }
 
     /**
@@ -229,24 +308,123 @@ public:
      * 
      * @return size_t The size of the full file in bytes. 
      */
-    size_t file_size() const
+    size_t file_size() const override
     {
         return file_size_;
     }
 
+    /**
+     * @brief Views point into the mapped file, see FileSource::copies_data().
+     */
+    bool copies_data() const override
+    {
+        return false;
+    }
+
+    /**
+     * @brief Accessor for the effective mapping mode.
+     * 
+     * @return MappingMode The mode in use, which may differ from the requested one if
+     * the file exceeded the address space budget.
+     */
+    MappingMode mode() const
+    {
+        return mode_;
+    }
+
 private:
     /** WIN32 handle to the file itself. */ 
     HANDLE file_;
 
-    /** WIN32 handle to the overarching file mapping object. */
-    HANDLE file_mapping_;
+    /** WIN32 handle to the overarching file mapping object. Null for empty files. */
+    HANDLE file_mapping_ = nullptr;
 
     /** Full file size, queried on construction. */
     SIZE_T file_size_;
 
     /** System info, queried on construction. Needed for memory page size, as file views must be page-aligned. */
     SYSTEM_INFO system_info_;
+
+    /** Base address of the persistent mapping of the full file. Null for empty files and other modes. */
+    uint8_t *base_addr_ = nullptr;
+
+    /** The effective mapping mode. */
+    MappingMode mode_;
+
+    /** Whether mappings are populated on creation. */
+    bool populate_ = false;
+
+    /** Pinned mapping windows, only used in MappingMode::kWindowed. */
+    std::unique_ptr<MappingWindowCache> windows_;
+
+    /**
+     * @brief Reads a mapped range into the working set, like MAP_POPULATE does on Linux.
+     */
+    void Populate(uint8_t *addr, const SIZE_T size) const
+    {
+        // read the file with large requests first, then fault in every page
+        WIN32_MEMORY_RANGE_ENTRY range{addr, size};
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+
+        volatile uint8_t sink = 0;
+        for (SIZE_T offset = 0; offset < size; offset += system_info_.dwPageSize)
+            sink ^= addr[offset];
+    }
+
+    /**
+     * @brief Maps an allocation granularity aligned range of the file.
+     * 
+     * @param offset Aligned offset of the range in bytes.
+     * @param size Size of the range in bytes.
+     * @return std::shared_ptr<uint8_t> Owner of the mapped range, unmapping it on release.
+     */
+    std::shared_ptr<uint8_t> MapRegion(const size_t offset, const size_t size) const
+    {
+        if (size == 0)
+            return std::shared_ptr<uint8_t>{};
+
+        DWORD offset_low = static_cast<DWORD>(offset & 0xFFFFFFFFul);
+        DWORD offset_high = static_cast<DWORD>(((uint64_t)offset >> 32) & 0xFFFFFFFFul);
+
+        auto view = static_cast<uint8_t*>(MapViewOfFile(
+            file_mapping_,
+            FILE_MAP_READ,
+            offset_high,
+            offset_low,
+            (SIZE_T)size
+        ));
+
+        if (view == nullptr)
+            throw std::runtime_error("Mapping file view failed");
+
+        if (populate_)
+            Populate(view, (SIZE_T)size);
+
+        return std::shared_ptr<uint8_t>{
+            view,
+            [](uint8_t *p){ UnmapViewOfFile(p); }
+        };
+    }
 };
 
 
+/**
+ * @brief Queries memory usage and page fault counters of the whole process.
+ * 
+ * Windows does not distinguish major page faults in the counters, they are reported as 0.
+ */
+inline ProcessMemoryUsage GetProcessMemoryUsage()
+{
+    ProcessMemoryUsage usage;
+
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        usage.resident_bytes = (size_t)counters.WorkingSetSize;
+        usage.page_faults = (size_t)counters.PageFaultCount;
+    }
+
+    return usage;
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,150 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+#include "google/protobuf/message.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Counters describing the effectiveness of a cache.
+ */
+struct CacheStatistics
+{
+    /** Number of lookups served from the cache. */
+    uint64_t hits = 0;
+
+    /** Number of lookups not served from the cache. */
+    uint64_t misses = 0;
+
+    /** Number of entries removed from the cache to stay within the byte budget. */
+    uint64_t evictions = 0;
+
+    /** Number of entries currently held by the cache. */
+    size_t num_entries = 0;
+
+    /** Memory currently used by the cached messages in bytes, as reported by SpaceUsedLong(). */
+    size_t size_bytes = 0;
+};
+
+/**
+ * @brief Thread-safe cache of decoded messages, bounded by the memory they use.
+ * 
+ * Messages are identified by the index of their work plane and, for single vector
+ * blocks, the index of the vector block. When the byte budget is exceeded, the least
+ * recently used messages are evicted. Messages are shared with the callers that looked
+ * them up, so eviction never invalidates a message still in use.
+ */
+class MessageCache
+{
+public:
+    /** Vector block index used to identify whole work planes. */
+    static constexpr int kWholeWorkPlane = -1;
+
+    /**
+     * @brief Construct a new Message Cache object
+     * 
+     * @param byte_budget Maximum memory used by the cached messages in bytes.
+     */
+    explicit MessageCache(size_t byte_budget);
+
+    /**
+     * @brief Looks up a message and marks it as most recently used.
+     * 
+     * @param i_work_plane The index of the work plane.
+     * @param i_vector_block The index of the vector block, or kWholeWorkPlane.
+     * @return std::shared_ptr<const google::protobuf::Message> The cached message, or nullptr.
+     */
+    std::shared_ptr<const google::protobuf::Message> Get(const int i_work_plane, const int i_vector_block = kWholeWorkPlane);
+
+    /**
+     * @brief Looks up a message without counting a miss if it is not cached.
+     * 
+     * Used for opportunistic lookups, e.g. of a whole work plane when a single vector block is requested.
+     */
+    std::shared_ptr<const google::protobuf::Message> Peek(const int i_work_plane, const int i_vector_block = kWholeWorkPlane);
+
+    /**
+     * @brief Adds a message to the cache, evicting least recently used messages as needed.
+     * 
+     * Messages larger than the byte budget are not cached.
+     * 
+     * @param i_work_plane The index of the work plane.
+     * @param i_vector_block The index of the vector block, or kWholeWorkPlane.
+     * @param message The decoded message.
+     */
+    void Put(const int i_work_plane, const int i_vector_block, std::shared_ptr<const google::protobuf::Message> message);
+
+    /**
+     * @brief Removes all messages, keeping the counters.
+     */
+    void Clear();
+
+    /**
+     * @brief Gets the current counters of the cache.
+     */
+    CacheStatistics GetStatistics() const;
+
+    /**
+     * @brief The maximum memory used by the cached messages in bytes.
+     */
+    size_t byte_budget() const { return byte_budget_; }
+
+private:
+    struct Entry
+    {
+        uint64_t key;
+        std::shared_ptr<const google::protobuf::Message> message;
+        size_t size_bytes;
+    };
+
+    const size_t byte_budget_;
+
+    mutable std::mutex mutex_;
+
+    /** Entries from most to least recently used. */
+    std::list<Entry> entries_;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+    CacheStatistics statistics_;
+
+    static uint64_t MakeKey(const int i_work_plane, const int i_vector_block)
+    {
+        return ((uint64_t)(uint32_t)i_work_plane << 32) | (uint32_t)i_vector_block;
+    }
+
+    std::shared_ptr<const google::protobuf::Message> Find(const uint64_t key);
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,216 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#if (defined WIN32 || defined _WIN32)
+#  include "output_file_win32.h"
+#else
+#  include "output_file_posix.h"
+#endif
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Buffered output of a file that is written front to back.
+ * 
+ * Appended bytes are collected in a buffer of a fixed size, which is written with a single
+ * positional write when full, so writing a job takes few large sequential writes. Appends
+ * larger than the buffer are written directly. The logical offset of the next byte is tracked
+ * in memory instead of being queried from the file, and bytes that were appended earlier can
+ * be overwritten, in the buffer if they are not written yet, or with a positional write.
+ * 
+ * Not thread-safe.
+ */
+class OutputFile
+{
+public:
+    /** Default size of the buffer in bytes. */
+    static constexpr size_t kDefaultBufferSize = (size_t)1 << 22;
+
+    /**
+     * @brief Creates the file, or truncates it if it exists.
+     * 
+     * @param path The path to write the file to.
+     * @param buffer_size Size of the buffer in bytes. With a size of zero, every append is
+     * written directly.
+     * @throws std::runtime_error The file could not be created.
+     */
+    OutputFile(const std::string path, const size_t buffer_size = kDefaultBufferSize)
+        : file_{path},
+          buffer_{new uint8_t[buffer_size]},
+          buffer_capacity_{buffer_size}
+    {}
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    /**
+     * @brief Destroy the Output File object.
+     * 
+     * If the file was not closed, e.g. because writing was aborted, buffered bytes are
+     * discarded.
+     */
+    ~OutputFile() = default;
+
+    /**
+     * @brief Appends bytes to the file.
+     * 
+     * @throws std::runtime_error Writing the file failed.
+     */
+    void Write(const void *data, const size_t size)
+    {
+        if (size > buffer_capacity_ - buffer_size_)
+        {
+            Flush();
+
+            if (size >= buffer_capacity_)
+            {
+                file_.WriteAt(buffer_offset_, static_cast<const uint8_t*>(data), size);
+                buffer_offset_ += size;
+                return;
+            }
+        }
+
+        std::memcpy(buffer_.get() + buffer_size_, data, size);
+        buffer_size_ += size;
+    }
+
+    /**
+     * @brief Appends bytes that are filled in by the caller, in place in the buffer.
+     * 
+     * @param size The number of bytes to append.
+     * @return uint8_t* Where to fill in the bytes, valid until the next call. nullptr if the
+     * bytes don't fit into the buffer, then nothing is appended.
+     * @throws std::runtime_error Writing the buffered bytes to make room failed.
+     */
+    uint8_t* WriteInPlace(const size_t size)
+    {
+        if (size > buffer_capacity_ - buffer_size_)
+        {
+            if (size > buffer_capacity_)
+                return nullptr;
+
+            Flush();
+        }
+
+        uint8_t *data = buffer_.get() + buffer_size_;
+        buffer_size_ += size;
+        return data;
+    }
+
+    /**
+     * @brief Overwrites bytes that were appended before, without moving the offset of the
+     * next append.
+     * 
+     * @param offset The offset of the bytes in the file.
+     * @throws std::runtime_error The range was not appended yet, or writing the file failed.
+     */
+    void WriteAt(const uint64_t offset, const void *data, const size_t size)
+    {
+        if (offset + size > this->offset())
+            throw std::runtime_error("Writing beyond the end of the file");
+
+        // bytes still in the buffer are patched there, bytes partially written are written out first
+        if (offset >= buffer_offset_)
+        {
+            std::memcpy(buffer_.get() + (offset - buffer_offset_), data, size);
+            return;
+        }
+        if (offset + size > buffer_offset_)
+            Flush();
+
+        file_.WriteAt(offset, static_cast<const uint8_t*>(data), size);
+    }
+
+    /**
+     * @brief Writes the buffered bytes to the file.
+     * 
+     * @throws std::runtime_error Writing the file failed.
+     */
+    void Flush()
+    {
+        if (buffer_size_ == 0)
+            return;
+
+        file_.WriteAt(buffer_offset_, buffer_.get(), buffer_size_);
+        buffer_offset_ += buffer_size_;
+        buffer_size_ = 0;
+    }
+
+    /**
+     * @brief Writes the buffered bytes and waits until the file is stored on the device.
+     * 
+     * @throws std::runtime_error Writing or syncing the file failed.
+     */
+    void Sync()
+    {
+        Flush();
+        file_.Sync();
+    }
+
+    /**
+     * @brief Writes the buffered bytes and closes the file.
+     * 
+     * @throws std::runtime_error Writing or closing the file failed.
+     */
+    void Close()
+    {
+        Flush();
+        file_.Close();
+    }
+
+    /**
+     * @brief Accessor for the offset of the next appended byte, i.e. the size of the file
+     * once all buffered bytes are written.
+     */
+    uint64_t offset() const
+    {
+        return buffer_offset_ + buffer_size_;
+    }
+
+private:
+    /** The file, written with positional writes only. */
+    OutputFileHandle file_;
+
+    /** Bytes appended but not written yet. */
+    std::unique_ptr<uint8_t[]> buffer_;
+    /** Size of the buffer in bytes. */
+    const size_t buffer_capacity_;
+    /** Number of bytes in the buffer. */
+    size_t buffer_size_ = 0;
+    /** Offset of the first byte of the buffer in the file. */
+    uint64_t buffer_offset_ = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,139 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#if (defined WIN32 || defined _WIN32)
+#  error posix headers included for win32 build
+#endif
+
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief POSIX specific handle of a file that is written.
+ * 
+ * All writes are positional (pwrite), so writes back into the file don't move a file pointer.
+ */
+class OutputFileHandle
+{
+public:
+    /**
+     * @brief Creates the file, or truncates it if it exists.
+     * 
+     * @param path The path to write the file to.
+     * @throws std::runtime_error The file could not be created.
+     */
+    explicit OutputFileHandle(const std::string path)
+    {
+        file_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (file_ < 0)
+        {
+            throw std::runtime_error("Opening file \"" + path + "\" for writing failed: " + std::strerror(errno));
+        }
+    }
+
+    OutputFileHandle(const OutputFileHandle&) = delete;
+    OutputFileHandle& operator=(const OutputFileHandle&) = delete;
+
+    /**
+     * @brief Destroy the Output File Handle object, closing the file if still open.
+     */
+    ~OutputFileHandle()
+    {
+        if (file_ >= 0)
+            close(file_);
+    }
+
+    /**
+     * @brief Writes a range of the file, in chunks pwrite can handle.
+     * 
+     * @throws std::runtime_error Writing the file failed.
+     */
+    void WriteAt(uint64_t offset, const uint8_t *data, size_t size)
+    {
+        while (size > 0)
+        {
+            ssize_t count = pwrite(file_, data, std::min<size_t>(size, (size_t)1 << 30), (off_t)offset);
+            if (count < 0 && errno == EINTR)
+                continue;
+            if (count <= 0)
+                throw std::runtime_error(std::string{"Writing file failed: "} + std::strerror(errno));
+
+            data += count;
+            offset += (uint64_t)count;
+            size -= (size_t)count;
+        }
+    }
+
+    /**
+     * @brief Waits until the written data is stored on the device, not only in the page cache.
+     * 
+     * @throws std::runtime_error Syncing the file failed.
+     */
+    void Sync()
+    {
+#ifdef __APPLE__
+        // fsync only hands the data over to the drive on macOS, F_FULLFSYNC isn't supported by all file systems
+        int ret = fcntl(file_, F_FULLFSYNC);
+        if (ret != 0)
+            ret = fsync(file_);
+#else
+        int ret = fdatasync(file_);
+#endif
+        if (ret != 0)
+            throw std::runtime_error(std::string{"Syncing file failed: "} + std::strerror(errno));
+    }
+
+    /**
+     * @brief Closes the file.
+     * 
+     * @throws std::runtime_error Closing the file failed, e.g. because deferred writes failed.
+     */
+    void Close()
+    {
+        const int file = file_;
+        file_ = -1;
+        if (file >= 0 && close(file) != 0)
+            throw std::runtime_error(std::string{"Closing file failed: "} + std::strerror(errno));
+    }
+
+private:
+    /** File descriptor of the file, -1 once closed. */
+    int file_ = -1;
+};
+
+}
\ No newline at end of file
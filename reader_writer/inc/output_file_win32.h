@@ -0,0 +1,141 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#if (!defined WIN32 && !defined _WIN32)
+#  error win32 headers included for non-win32 build
+#endif
+
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <windows.h>
+#include <fileapi.h>
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief WIN32 specific handle of a file that is written.
+ * 
+ * All writes pass their offset, so writes back into the file don't depend on the file pointer.
+ */
+class OutputFileHandle
+{
+public:
+    /**
+     * @brief Creates the file, or truncates it if it exists.
+     * 
+     * @param path The path to write the file to.
+     * @throws std::runtime_error A handle to the file could not be obtained.
+     */
+    explicit OutputFileHandle(const std::string path)
+    {
+        file_ = CreateFileA(
+            path.c_str(),
+            GENERIC_WRITE,
+            FILE_SHARE_READ,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+            nullptr
+        );
+
+        if (file_ == INVALID_HANDLE_VALUE)
+        {
+            throw std::runtime_error("Opening file \"" + path + "\" for writing failed");
+        }
+    }
+
+    OutputFileHandle(const OutputFileHandle&) = delete;
+    OutputFileHandle& operator=(const OutputFileHandle&) = delete;
+
+    /**
+     * @brief Destroy the Output File Handle object, closing the file if still open.
+     */
+    ~OutputFileHandle()
+    {
+        if (file_ != INVALID_HANDLE_VALUE)
+            CloseHandle(file_);
+    }
+
+    /**
+     * @brief Writes a range of the file, in chunks WriteFile can handle.
+     * 
+     * @throws std::runtime_error Writing the file failed.
+     */
+    void WriteAt(uint64_t offset, const uint8_t *data, size_t size)
+    {
+        while (size > 0)
+        {
+            OVERLAPPED overlapped{};
+            overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+            overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+            DWORD count = 0;
+            const DWORD chunk = (DWORD)std::min<size_t>(size, (size_t)1 << 30);
+            if (!WriteFile(file_, data, chunk, &count, &overlapped) || count == 0)
+                throw std::runtime_error("Writing file failed");
+
+            data += count;
+            offset += count;
+            size -= count;
+        }
+    }
+
+    /**
+     * @brief Waits until the written data is stored on the device, not only in the file cache.
+     * 
+     * @throws std::runtime_error Syncing the file failed.
+     */
+    void Sync()
+    {
+        if (!FlushFileBuffers(file_))
+            throw std::runtime_error("Syncing file failed");
+    }
+
+    /**
+     * @brief Closes the file.
+     * 
+     * @throws std::runtime_error Closing the file failed.
+     */
+    void Close()
+    {
+        const HANDLE file = file_;
+        file_ = INVALID_HANDLE_VALUE;
+        if (file != INVALID_HANDLE_VALUE && !CloseHandle(file))
+            throw std::runtime_error("Closing file failed");
+    }
+
+private:
+    /** Handle of the file, INVALID_HANDLE_VALUE once closed. */
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+};
+
+}
\ No newline at end of file
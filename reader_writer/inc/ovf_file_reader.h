@@ -31,13 +31,22 @@ SOFTWARE.
 #include <optional>
 #include <fstream>
 #include <optional>
-#include <shared_mutex>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
 
-#if (defined WIN32 || defined _WIN32)
-#  include "memory_mapping_win32.h"
-#else
-#  error POSIX
-#endif
+#include "memory_mapping.h"
+#include "buffered_file.h"
+#include "memory_buffer.h"
+#include "message_cache.h"
+#include "job_index.h"
+#include "spatial_index.h"
+#include "attribute_index.h"
+#include "job_statistics.h"
+#include "checksum.h"
+#include "snapshot_publisher.h"
+#include "vector_block_view.h"
 
 #include "open_vector_format.pb.h"
 #include "ovf_lut.pb.h"
@@ -46,8 +55,30 @@ SOFTWARE.
 
 namespace open_vector_format::reader_writer {
 
+/**
+ * @brief Strategy for loading the look up tables of the work planes when opening a file.
+ */
+enum class LutLoading
+{
+    /** All work plane luts are read when opening the file. */
+    kEager,
+    /** Each work plane lut is read on first access of its work plane. */
+    kLazy,
+    /** Like kLazy, but a background thread reads the remaining work plane luts after opening the file. */
+    kBackground,
+    /** Like kEager, but the work plane luts are taken from the index file next to the job file
+     *  (path + kIndexFileExtension) if it is up to date. Otherwise, they are read from the job file
+     *  and the index file is written for the next time the file is opened. */
+    kIndexFile
+};
+
 /**
  * @brief Implements an incremental file reader for the open vector format.
+ * 
+ * Reading is thread-safe, and lock-free unless recently used work planes are cached, see
+ * CacheRecentlyUsed(). The open file and its caches form an immutable
+ * snapshot, which is replaced as a whole when opening or closing a file or changing the
+ * caches, see SnapshotPublisher.
  */
 class OvfFileReader
 {
@@ -57,8 +88,15 @@ public:
      * 
      * @param auto_cache_threshold The file size threshold in bytes up to which the
      * full job will be cached to memory. Defaults to 64MiB. 
+     * @param num_cache_threads The number of threads decoding work planes when populating
+     * the cache. Defaults to one per hardware thread.
+     */
+    OvfFileReader(size_t auto_cache_threshold = 67108864, int num_cache_threads = 0);
+
+    /**
+     * @brief Destroy the OvfFileReader object, closing the file if still open.
      */
-    OvfFileReader(size_t auto_cache_threshold = 67108864);
+    ~OvfFileReader();
     
     // Deleting copy and copy assignment because we are handling file streams.
     OvfFileReader(const OvfFileReader&) = delete;
@@ -69,11 +107,71 @@ public:
      * 
      * @param path The path from which the file should be read.
      * @param job A reference to the job object into which the job shell should be read.
+     * @param mapping_options Options for mapping the file into memory, e.g. a hint whether
+     * work planes are going to be streamed sequentially or vector blocks are accessed randomly.
+     * By default, the whole file is mapped once and all reads are served from that mapping.
+     * With IoBackend::kBufferedRead, the ranges needed are read into buffers instead.
+     * @param lut_loading When to read the look up tables of the work planes. With kLazy or
+     * kBackground, only the job lut and job shell are read before returning, so the time to open
+     * the file does not depend on the number of work planes. Errors in a work plane lut are then
+     * only reported once that work plane is accessed. With kIndexFile, an up to date index file
+     * replaces all luts of the job, including the job lut.
+     */
+    void OpenFile(const std::string path, Job& job, const MappingOptions& mapping_options = {}, const LutLoading lut_loading = LutLoading::kEager);
+
+    /**
+     * @brief Opens an ovf file held in memory, borrowing the buffer.
+     * 
+     * Reads point directly into the buffer, the same way they point into a mapped file.
+     * 
+     * @param buffer The contents of the file. Must stay valid and unchanged until the file is
+     * closed, including views handed out by GetVectorBlockView() and readers sharing the file.
+     * @param job A reference to the job object into which the job shell should be read.
+     * @param lut_loading When to read the look up tables of the work planes, see OpenFile().
+     * kIndexFile behaves like kEager, as there is no job file to keep an index file next to.
+     */
+    void OpenBuffer(Span<const uint8_t> buffer, Job& job, const LutLoading lut_loading = LutLoading::kEager);
+
+    /**
+     * @brief Opens an ovf file held in memory, taking ownership of the buffer.
+     * 
+     * @param buffer The contents of the file, moved into the reader without copying. Released
+     * once the file is closed and no view or reader sharing the file uses it anymore.
+     * @param job A reference to the job object into which the job shell should be read.
+     * @param lut_loading When to read the look up tables of the work planes, see OpenBuffer().
+     */
+    void OpenBuffer(std::vector<uint8_t>&& buffer, Job& job, const LutLoading lut_loading = LutLoading::kEager);
+
+    /**
+     * @brief Opens an ovf file from any random access source, e.g. a MemoryBuffer sharing
+     * ownership of a network message, or a custom implementation of FileSource.
+     * 
+     * @param source The source of the file contents, owned by the reader until the file is closed.
+     * @param job A reference to the job object into which the job shell should be read.
+     * @param lut_loading When to read the look up tables of the work planes, see OpenBuffer().
+     * @throws std::runtime_error The source is nullptr, or does not contain an ovf file.
+     */
+    void OpenSource(std::unique_ptr<FileSource> source, Job& job, const LutLoading lut_loading = LutLoading::kEager);
+
+    /**
+     * @brief Opens the file currently open in another reader, without mapping it again.
+     * 
+     * Both readers share the mapping, the look up tables and the caches of the file at the time
+     * of the call, except for the cache of recently used work planes, see CacheRecentlyUsed(),
+     * which starts out empty with the same budget. Later changes of the caches only apply to the
+     * reader they are made on.
+     * 
+     * @param other The reader to share the open file of. May be used and closed independently afterwards.
+     * @param job A reference to the job object into which the job shell should be read.
+     * @throws std::runtime_error The other reader has no open file.
      */
-    void OpenFile(const std::string path, Job& job);
+    void ShareFile(const OvfFileReader& other, Job& job);
 
     /**
      * @brief Closes the file and file stream.
+     * 
+     * Reads in progress on other threads finish before the file is closed. Readers sharing
+     * the file keep it open.
      */
     void CloseFile();
     
@@ -82,6 +180,11 @@ public:
      */
     bool IsFileOpen() const;
 
+    /**
+     * @brief Gets the number of work planes in the currently open file.
+     */
+    int GetNumWorkPlanes() const;
+
     /**
      * @brief Gets a specific work plane from the currently open file.
      * 
@@ -111,6 +214,256 @@ public:
      */
     void GetVectorBlock(const int i_work_plane, const int i_vector_block, VectorBlock& vb) const;
 
+    /**
+     * @brief Gets a selection of vector blocks on a specific work plane from the currently open file.
+     * 
+     * Compared to calling GetVectorBlock() for each index, the file is only accessed once
+     * and the vector blocks are decoded in file order, regardless of the order of the indices.
+     * 
+     * @param i_work_plane The index of the work plane the vector blocks are located on.
+     * @param i_vector_blocks The indices of the vector blocks to get, in any order. Indices may repeat.
+     * @param vbs A reference to the container into which the vector blocks should be read. Any previous
+     * content is replaced, the vector blocks are stored in the order of the indices.
+     * @throws std::runtime_error Any of the indices is invalid.
+     */
+    void GetVectorBlocks(const int i_work_plane, Span<const int> i_vector_blocks, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const;
+
+    /**
+     * @brief Gets a contiguous range of vector blocks on a specific work plane from the currently open file.
+     * 
+     * @param i_work_plane The index of the work plane the vector blocks are located on.
+     * @param i_first_vector_block The index of the first vector block to get.
+     * @param count The number of vector blocks to get.
+     * @param vbs A reference to the container into which the vector blocks should be read. Any previous
+     * content is replaced.
+     * @throws std::runtime_error The range exceeds the vector blocks of the work plane.
+     */
+    void GetVectorBlocks(const int i_work_plane, const int i_first_vector_block, const int count, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const;
+
+    /**
+     * @brief Gets the headers of all vector blocks on a specific work plane from the currently open file.
+     * 
+     * A header is a vector block without its vector data, i.e. with the marking params key,
+     * laser index, repeats and meta data only. The vector data oneof is set to an empty message
+     * of the stored type, so vector_data_case() still reports it. The geometry is skipped on the
+     * wire without being decoded, so scanning the headers of a work plane takes time proportional
+     * to the number of vector blocks rather than the number of points.
+     * 
+     * @param i_work_plane The index of the work plane the vector blocks are located on.
+     * @param vbs A reference to the container into which the headers should be read. Any previous
+     * content is replaced, the headers are stored in file order.
+     */
+    void GetVectorBlockHeaders(const int i_work_plane, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const;
+
+    /**
+     * @brief Gets a specific work plane from the currently open file, allocated on an arena.
+     * 
+     * Gets the full work plane, including all vector blocks. All vector blocks and repeated
+     * fields are allocated on the arena as well, so a whole work plane is released at once
+     * when the arena is reset or destroyed.
+     * 
+     * @param i_work_plane The index of the work plane to get.
+     * @param arena The arena to allocate the work plane on.
+     * @return WorkPlane* The work plane, owned by the arena.
+     */
+    WorkPlane* GetWorkPlane(const int i_work_plane, google::protobuf::Arena& arena) const;
+
+    /**
+     * @brief Gets a specific work plane shell from the currently open file, allocated on an arena.
+     * 
+     * Only gets the work plane shell, without any vector blocks.
+     * 
+     * @param i_work_plane The index of the work plane to get.
+     * @param arena The arena to allocate the work plane shell on.
+     * @return WorkPlane* The work plane shell, owned by the arena.
+     */
+    WorkPlane* GetWorkPlaneShell(const int i_work_plane, google::protobuf::Arena& arena) const;
+
+    /**
+     * @brief Gets a specific vector block on a specific work plane from the currently open file,
+     * allocated on an arena.
+     * 
+     * @param i_work_plane The index of the work plane the vector block is located on.
+     * @param i_vector_block The index of the vector block to get.
+     * @param arena The arena to allocate the vector block on.
+     * @return VectorBlock* The vector block, owned by the arena.
+     */
+    VectorBlock* GetVectorBlock(const int i_work_plane, const int i_vector_block, google::protobuf::Arena& arena) const;
+
+    /**
+     * @brief Gets a zero-copy view of a specific vector block from the currently open file.
+     * 
+     * The vector block is not parsed, instead its point coordinates are exposed directly
+     * from the mapped file, see VectorBlockView. The cache is not used.
+     * 
+     * @param i_work_plane The index of the work plane the vector block is located on.
+     * @param i_vector_block The index of the vector block to get.
+     * @return VectorBlockView A view of the vector block. Only valid as long as the file is open.
+     */
+    VectorBlockView GetVectorBlockView(const int i_work_plane, const int i_vector_block) const;
+
+    /**
+     * @brief Finds the vector blocks on a specific work plane whose bounding box intersects a region.
+     * 
+     * Served from the spatial index of the work plane, which is built on first access unless
+     * BuildSpatialIndex() or BuildSpatialIndexAsync() built it before. Vector blocks without
+     * points, but with geometry, i.e. arcs and ellipses, match every region. Vector blocks without
+     * any geometry, e.g. exposure pauses, match none.
+     * 
+     * @param i_work_plane The index of the work plane to search.
+     * @param region The region to search, in the coordinates of the vector data.
+     * @param i_vector_blocks Receives the indices of the matching vector blocks in ascending order,
+     * which can be passed on to GetVectorBlocks(). Any previous content is replaced.
+     */
+    void FindVectorBlocks(const int i_work_plane, const BoundingBox& region, std::vector<int>& i_vector_blocks) const;
+
+    /**
+     * @brief Gets the bounding box of a specific vector block from the spatial index, see FindVectorBlocks().
+     * 
+     * @return BoundingBox The bounding box in the x-y plane. Empty for vector blocks without geometry,
+     * unbounded for vector blocks without points.
+     */
+    BoundingBox GetVectorBlockBounds(const int i_work_plane, const int i_vector_block) const;
+
+    /**
+     * @brief Builds the spatial index of all work planes, in parallel.
+     * 
+     * Uses as many threads as populating the cache. Otherwise, the spatial index of a work
+     * plane is built on first access.
+     */
+    void BuildSpatialIndex();
+
+    /**
+     * @brief Builds the spatial index of all work planes in the background.
+     * 
+     * Returns immediately. Work planes accessed in the meantime are indexed on demand.
+     */
+    void BuildSpatialIndexAsync();
+
+    /**
+     * @brief Finds the vector blocks of the job selected by their laser index, part key and vector data type.
+     * 
+     * Served from the attribute index of the job, which is built on first access unless
+     * BuildAttributeIndex() built it before. Building it scans the headers of all vector blocks
+     * once, see GetVectorBlockHeaders(). If the file was opened with LutLoading::kIndexFile, the
+     * attribute index is loaded from the attribute index file next to the job file
+     * (path + kAttributeIndexFileExtension) if it is up to date, and written there otherwise.
+     * 
+     * @param filter The attributes to select by, e.g. all hatches of a part on a laser.
+     * @param locations Receives the positions of the selected vector blocks in file order.
+     * Any previous content is replaced.
+     * @param first_work_plane The first work plane to search.
+     * @param num_work_planes The number of work planes to search, or -1 for all following work planes.
+     */
+    void FindVectorBlocks(const VectorBlockFilter& filter, std::vector<VectorBlockLocation>& locations,
+        const int first_work_plane = 0, const int num_work_planes = -1) const;
+
+    /**
+     * @brief Gets the vector blocks on a specific work plane selected by a filter, see FindVectorBlocks().
+     * 
+     * Only the selected vector blocks are read, in a single batch like GetVectorBlocks().
+     * 
+     * @param i_work_plane The index of the work plane the vector blocks are located on.
+     * @param filter The attributes to select by.
+     * @param vbs A reference to the container into which the vector blocks should be read.
+     * Any previous content is replaced, the vector blocks are stored in file order.
+     * @param i_vector_blocks If not nullptr, receives the indices of the selected vector blocks.
+     */
+    void GetVectorBlocks(const int i_work_plane, const VectorBlockFilter& filter,
+        google::protobuf::RepeatedPtrField<VectorBlock>& vbs, std::vector<int> *i_vector_blocks = nullptr) const;
+
+    /**
+     * @brief Gets the distinct laser indices of all vector blocks of the job, in ascending order.
+     */
+    std::vector<int32_t> GetLaserIndices() const;
+
+    /**
+     * @brief Gets the distinct part keys of all vector blocks of the job, in ascending order.
+     */
+    std::vector<int32_t> GetPartKeys() const;
+
+    /**
+     * @brief Computes per work plane and per laser figures of the job, and estimates the time to expose it.
+     * 
+     * Reads the vector blocks as zero-copy views from the file, without parsing their coordinates,
+     * and runs over the work planes in parallel, using as many threads as populating the cache.
+     * Times are estimated from the speeds in the marking params map of the job, see
+     * WorkPlaneStatisticsBuilder.
+     * 
+     * @return JobStatistics The figures of all work planes, lasers and the whole job.
+     */
+    JobStatistics ComputeStatistics() const;
+
+    /**
+     * @brief Builds the attribute index of the job, reading the work planes in parallel.
+     * 
+     * Uses as many threads as populating the cache. Otherwise, the attribute index is built
+     * on first access.
+     */
+    void BuildAttributeIndex();
+
+    /**
+     * @brief Verifies the open file against the checksums written with it, see ChecksumMode.
+     * 
+     * Reads the whole file, checksumming the work planes in parallel with as many threads as
+     * populating the cache. The vector blocks of corrupted work planes are checked as well if
+     * the file holds checksums per vector block. Caches are bypassed.
+     * 
+     * @return VerificationResult The corrupted parts of the file, or has_checksums = false if
+     * the file was written without checksums.
+     */
+    VerificationResult Verify() const;
+
+    /**
+     * @brief Verifies each work plane of files opened afterwards against its checksum before it is first read.
+     * 
+     * Reads of a corrupted work plane, including its shell and lut, throw std::runtime_error
+     * instead of returning corrupted data. Each work plane is verified once, on top of the cost
+     * of reading it. Files without checksums are read without verification.
+     * 
+     * @param enable Whether to verify work planes on first read.
+     */
+    void VerifyOnFirstRead(bool enable = true);
+
+    /**
+     * @brief Locks the file contents of a range of work planes into physical memory, so reading them never page faults.
+     * 
+     * Only supported for files opened with MappingMode::kPersistent, see FileSource::Lock().
+     * To lock the whole file, open it with MappingOptions::lock instead.
+     * 
+     * @param first_work_plane The index of the first work plane to lock.
+     * @param num_work_planes The number of work planes to lock.
+     * @return true The work planes are locked.
+     * @return false Locking is not supported by the file source, or was denied by the operating system.
+     * @throws std::runtime_error The work plane range is invalid.
+     */
+    bool LockWorkPlanes(const int first_work_plane, const int num_work_planes = 1) const;
+
+    /**
+     * @brief Unlocks a range of work planes locked with LockWorkPlanes().
+     */
+    void UnlockWorkPlanes(const int first_work_plane, const int num_work_planes = 1) const;
+
+    /**
+     * @brief Releases the physical memory backing the file contents of a range of work planes, e.g. once they are consumed.
+     * 
+     * Keeps the memory used by long jobs bounded. Reading the work planes again is still
+     * possible, but page faults. Cached work planes are not affected. Locked work planes
+     * are not released, see FileSource::Release().
+     * 
+     * @param first_work_plane The index of the first work plane to release.
+     * @param num_work_planes The number of work planes to release.
+     * @throws std::runtime_error The work plane range is invalid.
+     */
+    void ReleaseWorkPlanes(const int first_work_plane, const int num_work_planes = 1) const;
+
+    /**
+     * @brief Reports how much of the open file occupies physical memory, see FileSource::GetResidentMemory().
+     * 
+     * Figures for the whole process are available from GetProcessMemoryUsage().
+     */
+    ResidentMemory GetResidentMemory() const;
+
     
     /**
      * @brief Caches the full job into memory.
@@ -119,6 +472,18 @@ public:
      */
     void CacheFullJob();
 
+    /**
+     * @brief Caches the full job into memory in the background.
+     * 
+     * Returns immediately. Until a work plane is decoded, reads of it are served
+     * from the file. Once all work planes are decoded, the full job is cached just
+     * like after CacheFullJob(). If decoding a work plane fails, caching is aborted
+     * and the work planes keep being read from the file.
+     * 
+     * Overrides any previous calls regarding caching strategy.
+     */
+    void CacheFullJobAsync();
+
     /**
      * @brief Only caches the work plane shells into memory.
      * 
@@ -126,6 +491,30 @@ public:
      */
     void CacheWorkPlaneShells();
 
+    /**
+     * @brief Caches recently used work planes into memory, up to a byte budget.
+     * 
+     * Decoded work planes, and optionally single vector blocks, are kept as long as
+     * the memory they use stays within the budget, least recently used ones are evicted
+     * first. Suited for jobs too large to be cached fully, which are accessed repeatedly,
+     * e.g. when scrubbing back and forth through the work planes.
+     * 
+     * Overrides any previous calls regarding caching strategy.
+     * 
+     * @param byte_budget Maximum memory used by the cached messages in bytes, measured
+     * with SpaceUsedLong().
+     * @param include_vector_blocks Whether single vector blocks requested via GetVectorBlock()
+     * are cached as well. Otherwise, only work planes requested as a whole are cached.
+     */
+    void CacheRecentlyUsed(size_t byte_budget, bool include_vector_blocks = false);
+
+    /**
+     * @brief Gets hit, miss and eviction counters of the cache of recently used work planes.
+     * 
+     * All counters are zero unless CacheRecentlyUsed() was called.
+     */
+    CacheStatistics GetCacheStatistics() const;
+
     /**
      * @brief Clears all caches.
      * 
@@ -147,45 +536,208 @@ public:
     bool IsFullJobCached() const;
 
 private:
-    mutable std::shared_mutex rwlock_;
+    /**
+     * @brief State of an open file, which does not change until the file is closed.
+     * 
+     * The path is empty for files opened from a buffer or custom source.
+     */
+    struct OpenedFile
+    {
+        OpenedFile(const std::string& path, std::unique_ptr<FileSource> source)
+            : path{path}, source{std::move(source)}
+        {}
+
+        std::string path;
+        std::unique_ptr<FileSource> source;
+        Job job_shell;
+        std::optional<JobIndex> index;
+        std::optional<SpatialIndex> spatial_index;
+
+        /** Position of the job lut, which identifies the job in index files. */
+        uint64_t job_lut_position = 0;
+
+        /** Whether index files next to the job file are loaded and written. */
+        bool use_index_files = false;
+
+        std::unique_ptr<LazyAttributeIndex> attribute_index = std::make_unique<LazyAttributeIndex>();
 
-    std::optional<std::string> path_;
-    std::optional<MemoryMapping> mapping_;
+        /** The checksum section of the file, if it was written with checksums. */
+        std::optional<ChecksumSection> checksums;
 
-    std::optional<Job> job_shell_;
-    std::optional<JobLUT> job_lut_;
-    std::optional<std::vector<WorkPlaneLUT>> wp_luts_;
+        /** Verification state per work plane, nullptr unless work planes are verified on first read. */
+        std::unique_ptr<std::atomic<uint8_t>[]> work_plane_verification;
+    };
+
+    /**
+     * @brief Work planes decoded in the background, each of which is read-only once marked as ready.
+     */
+    struct WarmingCache
+    {
+        Job job;
+        std::unique_ptr<std::atomic<bool>[]> is_ready;
+    };
+
+    /**
+     * @brief Immutable snapshot of the open file and its caches.
+     * 
+     * Changing the caches publishes a new snapshot sharing the open file, reads in progress
+     * finish on the snapshot they started with.
+     */
+    struct Snapshot
+    {
+        std::shared_ptr<const OpenedFile> file = nullptr;
+
+        std::shared_ptr<const Job> cache = nullptr;
+        bool are_vector_blocks_cached = false;
+
+        std::shared_ptr<WarmingCache> warming_cache = nullptr;
+
+        std::shared_ptr<MessageCache> recently_used_cache = nullptr;
+        bool are_single_vector_blocks_cached = false;
+    };
+
+    /** The current snapshot, nullptr while no file is open. */
+    SnapshotPublisher<Snapshot> snapshot_;
+
+    /** Serializes changes of the snapshot, as caches are changed based on the current snapshot. */
+    std::mutex state_mutex_;
+    /** Serializes starting and stopping the background threads. Locked before state_mutex_, which
+     *  is never held while joining a thread, as the cache warmer locks it to publish its cache. */
+    std::mutex threads_mutex_;
+
+    std::thread lut_loader_;
+    std::atomic<bool> is_lut_loader_stopped_ = true;
     
     size_t auto_cache_threshold_;
-    std::optional<Job> cache_;
-    std::optional<bool> are_vector_blocks_cached_;
+    int num_cache_threads_;
+
+    /** Whether files opened afterwards verify work planes on first read. */
+    bool verify_on_first_read_ = false;
+
+    std::thread cache_warmer_;
+    std::atomic<bool> is_cache_warmer_stopped_ = true;
+
+    std::thread spatial_indexer_;
+    std::atomic<bool> is_spatial_indexer_stopped_ = true;
     
-    void GetWorkPlaneImpl(const int i_work_plane, WorkPlane& wp, bool include_vector_blocks, bool try_cache = true) const;
-    void GetVectorBlockImpl(const int i_work_plane, const int i_vector_block, VectorBlock& vb, bool try_cache = true) const;
-    void GetVectorBlocksImpl(const int i_work_plane, WorkPlane& wp, MemoryMapping::FileView& work_plane_view, size_t wp_offset_abs) const;
+    void OpenSourceImpl(const std::string& path, std::unique_ptr<FileSource> source, Job& job, const LutLoading lut_loading);
+    std::shared_ptr<OpenedFile> OpenFileImpl(const std::string& path, std::unique_ptr<FileSource> source, Job& job, const LutLoading lut_loading) const;
+    void LoadWorkPlaneLUTs(std::shared_ptr<const OpenedFile> file);
+    void StopLoadingLUTs();
+
+    Job CreateEmptyCache(const OpenedFile& file) const;
+    void WarmCache(std::shared_ptr<const OpenedFile> file, std::shared_ptr<WarmingCache> warming_cache);
+    void StopCacheWarming();
+
+    void BuildSpatialIndexInBackground(std::shared_ptr<const OpenedFile> file);
+    void StopSpatialIndexing();
+
+    void GetWorkPlaneImpl(const Snapshot& snapshot, const int i_work_plane, WorkPlane& wp, bool include_vector_blocks, bool try_cache = true) const;
+    void GetVectorBlockImpl(const Snapshot& snapshot, const int i_work_plane, const int i_vector_block, VectorBlock& vb, bool try_cache = true) const;
+    void GetVectorBlocksImpl(const OpenedFile& file, const int i_work_plane, WorkPlane& wp, FileView& work_plane_view, size_t wp_offset_abs) const;
+    void GetVectorBlocksImpl(const Snapshot& snapshot, const int i_work_plane, Span<const int> i_vector_blocks, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const;
+    void GetVectorBlockHeadersImpl(const Snapshot& snapshot, const int i_work_plane, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const;
 
-    inline void CheckIsFileOpened() const
+    static void LoadWorkPlaneLUT(const OpenedFile& file, const int i_work_plane, WorkPlaneLUT& wpl);
+    static std::vector<BoundingBox> ComputeVectorBlockBounds(const OpenedFile& file, const int i_work_plane);
+    static std::vector<VectorBlockAttributes> ReadVectorBlockAttributes(const OpenedFile& file, const int i_work_plane);
+
+    const AttributeIndex& GetAttributeIndex(const OpenedFile& file) const;
+
+    static bool IsWorkPlaneIntact(const OpenedFile& file, const int i_work_plane);
+    static void VerifyWorkPlaneOnFirstRead(const OpenedFile& file, const int i_work_plane);
+
+    static inline void CheckIsFileOpened(const Snapshot *snapshot)
     {
-        if (!path_.has_value() || !mapping_.has_value() || !job_lut_.has_value())
+        if (snapshot == nullptr)
             throw std::runtime_error("Can't read data without opening a file first");
     }
 
-    inline MemoryMapping::FileView GetWorkPlaneFileView(const int i_work_plane, size_t *start_offset = nullptr, size_t *end_offset = nullptr) const
+    static inline ByteRange GetWorkPlanesByteRange(const OpenedFile& file, const int first_work_plane, const int num_work_planes)
     {
-        auto count_work_planes = job_lut_->workplanepositions_size();
-    
-        if (i_work_plane < 0 || i_work_plane > count_work_planes - 1)
-            throw std::runtime_error("Invalid work plane index");
-        
-        size_t lower_offset = job_lut_->workplanepositions(i_work_plane);
-        size_t upper_offset = i_work_plane < count_work_planes - 1
-            ? job_lut_->workplanepositions(i_work_plane + 1)
-            : job_lut_->jobshellposition();
+        if (num_work_planes < 1 || first_work_plane < 0 || first_work_plane > file.index->num_work_planes() - num_work_planes)
+            throw std::runtime_error("Invalid work plane range");
+
+        size_t lower_offset, upper_offset, unused;
+        file.index->GetWorkPlaneRange(first_work_plane, lower_offset, unused);
+        file.index->GetWorkPlaneRange(first_work_plane + num_work_planes - 1, unused, upper_offset);
+        return ByteRange{lower_offset, upper_offset - lower_offset};
+    }
+
+    static inline FileView GetWorkPlaneFileView(const OpenedFile& file, const int i_work_plane, size_t *start_offset = nullptr, size_t *end_offset = nullptr)
+    {
+        size_t lower_offset, upper_offset;
+        file.index->GetWorkPlaneRange(i_work_plane, lower_offset, upper_offset);
 
         if (start_offset != nullptr) *start_offset = lower_offset;
         if (end_offset != nullptr) *end_offset = upper_offset;
 
-        return mapping_->CreateView(lower_offset, (upper_offset - lower_offset));
+        return file.source->CreateView(lower_offset, (upper_offset - lower_offset));
+    }
+
+    static inline const WorkPlane* GetWarmedWorkPlane(const Snapshot& snapshot, const int i_work_plane)
+    {
+        if (snapshot.warming_cache == nullptr || !snapshot.warming_cache->is_ready[i_work_plane].load(std::memory_order_acquire))
+            return nullptr;
+
+        return &snapshot.warming_cache->job.work_planes(i_work_plane);
+    }
+
+    static inline JobIndex::WorkPlaneEntry GetWorkPlaneIndex(const OpenedFile& file, const int i_work_plane)
+    {
+        // every read from the file of a work plane goes through its lut
+        if (file.work_plane_verification != nullptr)
+            VerifyWorkPlaneOnFirstRead(file, i_work_plane);
+
+        return GetUnverifiedWorkPlaneIndex(file, i_work_plane);
+    }
+
+    /** Like GetWorkPlaneIndex(), without verifying the work plane, for reads which only need its lut. */
+    static inline JobIndex::WorkPlaneEntry GetUnverifiedWorkPlaneIndex(const OpenedFile& file, const int i_work_plane)
+    {
+        return file.index->GetWorkPlane(i_work_plane, [&file](int i, WorkPlaneLUT& wpl){ LoadWorkPlaneLUT(file, i, wpl); });
+    }
+
+    /**
+     * @brief Calls fn(int i_vector_block, const VectorBlockView& vb) for all vector blocks of a work plane, in file order.
+     */
+    template <class Fn>
+    static void ForEachVectorBlockView(const OpenedFile& file, const int i_work_plane, Fn fn)
+    {
+        const auto wp_index = GetWorkPlaneIndex(file, i_work_plane);
+        if (wp_index.num_vector_blocks() == 0)
+            return;
+
+        // a single view from the first vector block up to the work plane shell
+        size_t lower_offset = (size_t)wp_index.vector_block_positions[0];
+        size_t upper_offset = (size_t)wp_index.shell_position;
+        if (upper_offset < lower_offset)
+            throw std::runtime_error("Invalid work plane shell position, file might be corrupted");
+
+        auto view = file.source->CreateView(lower_offset, upper_offset - lower_offset);
+
+        for (int i = 0; i < wp_index.num_vector_blocks(); i++)
+        {
+            size_t vb_offset = (size_t)wp_index.vector_block_positions[i] - lower_offset;
+            if (vb_offset >= view.size())
+                throw std::runtime_error("Invalid vector block position, file might be corrupted");
+
+            // the work plane view outlives the vector block view
+            fn(i, VectorBlockView{FileView{view.data() + vb_offset, view.size() - vb_offset}});
+        }
+    }
+
+    static inline const BoundingBoxTree& GetSpatialIndex(const OpenedFile& file, const int i_work_plane)
+    {
+        return file.spatial_index->GetWorkPlane(i_work_plane, [&file](int i){ return ComputeVectorBlockBounds(file, i); });
+    }
+
+    static inline FileView GetVectorBlockFileView(const OpenedFile& file, const int i_work_plane, const int i_vector_block)
+    {
+        size_t lower_offset, upper_offset;
+        GetWorkPlaneIndex(file, i_work_plane).GetVectorBlockRange(i_vector_block, lower_offset, upper_offset);
+
+        return file.source->CreateView(lower_offset, (upper_offset - lower_offset));
     }
 };
 
@@ -28,23 +28,78 @@ SOFTWARE.
 
 #pragma once
 
-#include <fstream>
+#include <memory>
 #include <optional>
+#include <string>
+#include <vector>
 
 #include "open_vector_format.pb.h"
 #include "ovf_lut.pb.h"
+#include "checksum.h"
+#include "output_file.h"
+#include "serialization_pipeline.h"
 #include "ovf_reader_writer_export.h"
 
 namespace open_vector_format::reader_writer {
 
 
+/**
+ * @brief Options to control how files are written, see OvfFileWriter.
+ */
+struct WriterOptions
+{
+    /** Whether to write an index file next to each written file (path + kIndexFileExtension), so
+     *  readers opening the file with LutLoading::kIndexFile do not have to read the luts of the
+     *  job. Requires keeping the positions of all vector blocks in memory until the write is
+     *  finished. Failing to write the index file, e.g. in a read-only directory, does not fail
+     *  the write, as readers then read the luts of the job. */
+    bool write_index_file = false;
+
+    /** Which checksums to append to each written file, in a section that readers not aware of
+     *  checksums ignore, see ChecksumSection and OvfFileReader::Verify. */
+    ChecksumMode checksum_mode = ChecksumMode::kNone;
+
+    /** Size of the buffer output is collected in before it is written to the file, in bytes.
+     *  Work planes larger than the buffer are written directly. */
+    size_t write_buffer_size = OutputFile::kDefaultBufferSize;
+
+    /** The number of threads serializing vector blocks, or zero for one per hardware thread.
+     *  With one, vector blocks are serialized on the calling thread unless a queue budget is set.
+     *  With more, batches of vector blocks are serialized in parallel, and written to the file
+     *  in order by an additional thread. */
+    int num_threads = 1;
+
+    /** Maximum memory of vector blocks queued for serialization and writing, in bytes. If set,
+     *  appends return once the vector blocks are queued, as copies unless they are moved or
+     *  passed by unique_ptr, and block while the budget is used up. Errors of the background
+     *  threads are reported by the next append or by finishing the write, which aborts the
+     *  write. Zero writes synchronously with a single thread, and uses
+     *  OvfFileWriter::kDefaultQueueBudget with more. */
+    size_t queue_budget = 0;
+
+    /** Whether finishing a write waits until the file is stored on the device (fdatasync,
+     *  FlushFileBuffers on Windows), so it survives a crash of the system. Otherwise, the file
+     *  may still be held in the cache of the operating system. */
+    bool sync_on_finish = false;
+};
+
 /**
  * @brief Implements an incremental file writer for the open vector file format.
  * 
  * This class implements an incremental file writer. Therefore, work planes and vector
- * blocks can be fed incrementally, and will be committed and written to the output
- * stream after each work plane is finalized. This enables writing of large jobs that
- * would otherwise not fit into system memory.
+ * blocks can be fed incrementally. Vector blocks are written to the output as soon as
+ * they are appended, and work plane shells and luts once the next work plane is appended,
+ * so the memory used by the writer depends on the size of vector blocks, not of work
+ * planes. This enables writing of large jobs, and of large work planes, that would
+ * otherwise not fit into system memory.
+ * 
+ * Output is collected in a buffer and written with few large sequential writes, see
+ * OutputFile. Optionally, vector blocks are serialized by a pool of threads, while another
+ * thread writes them to the file in order, see SerializationPipeline. Appends then only queue
+ * vector blocks, so the calling thread does not wait for the file system unless the queue is full.
+ * 
+ * If writing fails, the write is aborted, leaving the incomplete file behind, and the writer
+ * can start a new one.
  * 
  * Note that due to internal state tracking, this file writer does not support concurrency.
  * Multiple methods must not be called similtaneously.
@@ -54,10 +109,17 @@ class OVF_READER_WRITER_EXPORT OvfFileWriter
 public:
     /**
      * @brief Construct a new OvfFileWriter object.
+     * 
+     * @param options Options for writing files, e.g. whether to write checksums or to
+     * serialize vector blocks on multiple threads.
      */
-    OvfFileWriter();
+    explicit OvfFileWriter(const WriterOptions& options = {});
+
+    /** Budget of queued vector blocks if they are serialized by multiple threads, in bytes,
+     *  see WriterOptions::queue_budget. */
+    static constexpr size_t kDefaultQueueBudget = (size_t)1 << 26;
     
-    // Deleting copy and copy assignment because we are handling file streams.
+    // Deleting copy and copy assignment because we are handling files.
     OvfFileWriter(const OvfFileWriter&) = delete;
     OvfFileWriter& operator=(const OvfFileWriter&) = delete;
 
@@ -77,31 +139,70 @@ public:
     /**
      * @brief Appends a work plane during a partial write.
      * 
-     * Any previous work plane is committed and written to the file stream, and a new work plane
-     * based on the provided object is initialized in memory. All vector blocks of the provided
-     * work plane are preserved, however additional vector blocks can be added with 
-     * OvfFileWriter::AppendVectorBlock.
+     * Any previous work plane is finished by writing its shell and lut to the file. The vector
+     * blocks of the provided work plane are written right away, and only its shell and the
+     * positions of its vector blocks are kept in memory. Additional vector blocks can be added
+     * with OvfFileWriter::AppendVectorBlock. If writing fails, the write is aborted, leaving the
+     * incomplete file behind, and a new one can be started.
      * 
      * @param wp The next work plane to append to the file.
      */
     void AppendWorkPlane(const WorkPlane& wp);
 
+    /**
+     * @brief Appends a work plane during a partial write, see
+     * OvfFileWriter::AppendWorkPlane(const WorkPlane&).
+     * 
+     * The work plane is serialized right away instead of being copied, or its vector blocks are
+     * moved to the threads serializing them. It is left in a valid but unspecified state.
+     * 
+     * @param wp The next work plane to append to the file.
+     */
+    void AppendWorkPlane(WorkPlane&& wp);
+
     /**
      * @brief Appends additional vector blocks to a work plane during a partial write.
      * 
      * Only valid if there is a work plane in memory, i.e. OvfFileWriter::AppendWorkPlane was called
-     * at least once. In that case, appends a copy of the provided vector block to the last work plane
-     * provided in OvfFileWriter::AppendWorkPlane.
+     * at least once. In that case, writes the provided vector block to the file, as part of the last
+     * work plane provided in OvfFileWriter::AppendWorkPlane. Only its position is kept in memory.
+     * If writing fails, the write is aborted like in OvfFileWriter::AppendWorkPlane.
      * 
      * @param vb The vector block to append to the work plane.
      */
     void AppendVectorBlock(const VectorBlock& vb);
 
+    /**
+     * @brief Appends an additional vector block during a partial write, see
+     * OvfFileWriter::AppendVectorBlock(const VectorBlock&).
+     * 
+     * The vector block is serialized right away instead of being copied, or moved to the threads
+     * serializing vector blocks. It is left in a valid but unspecified state.
+     * 
+     * @param vb The vector block to append to the work plane.
+     */
+    void AppendVectorBlock(VectorBlock&& vb);
+
+    /**
+     * @brief Appends an additional vector block during a partial write, taking ownership of it,
+     * see OvfFileWriter::AppendVectorBlock(const VectorBlock&).
+     * 
+     * The vector block is deleted once it is written, and handed to the threads serializing
+     * vector blocks without copying it. Vector blocks allocated on an arena are appended by
+     * reference or moved instead.
+     * 
+     * @param vb The vector block to append to the work plane.
+     */
+    void AppendVectorBlock(std::unique_ptr<VectorBlock> vb);
+
     /**
      * @brief Finishes a partial write operation and closes the file stream.
      * 
-     * Commits and writes the last pending work plane, if available, and finishes the file writing
+     * Finishes writing the last pending work plane, if available, and finishes the file writing
      * process. Then closes the stream and reverts the file operation of this writer back to none.
+     * Blocks until all queued vector blocks are written and the file is closed, and until the
+     * file is stored on the device if enabled with WriterOptions::sync_on_finish. If writing
+     * fails, the write is aborted, leaving the incomplete file behind, and a new one can be started.
      */
     void FinishWrite();
 
@@ -111,6 +212,7 @@ public:
      * 
      * This method can be used for smaller jobs that easily fit into memory.
      * Note that the job shell can not be altered before it is committed to the output file.
+     * If writing fails, the write is aborted, leaving the incomplete file behind.
      * 
      * @param job The full job, including all work planes and vector blocks.
      * @param path The path to write the ovf file to. Must be valid and have write permissions.
@@ -122,6 +224,14 @@ public:
      *  will be committed and written to the file. */
     Job& job_shell();
 
+    /**
+     * @brief Gets the queue depth, and how often and how long appends blocked on a full queue,
+     * to size the queue budget.
+     * 
+     * All counters are zero if vector blocks are written synchronously, see WriterOptions::queue_budget.
+     */
+    QueueStatistics GetQueueStatistics() const;
+
 private:
     /**
      * @brief A file operation modelling the different modes of writing of this class.
@@ -148,11 +258,36 @@ private:
     // Optionals are guaranteed to hold a value during file operations kPartialWrite
     // and kCompleteWrite.
 
-    /** Output file stream to write to when writing operation is in progress. */
-    std::optional<std::ofstream> ofs_;
+    /** Output file to write to when writing operation is in progress. */
+    std::optional<OutputFile> output_file_;
+    /** Size of the buffer of the output file. */
+    size_t write_buffer_size_;
+    /** Whether the output file is synced to the device before it is closed. */
+    bool sync_on_finish_;
     
-    /** The current work plane held in memory before it is committed and written. */
-    std::optional<WorkPlane> current_wp_;
+    /**
+     * @brief A work plane that is being written.
+     * 
+     * Its vector blocks are written as they are appended, its shell and lut once it is finished.
+     */
+    struct WorkPlaneInProgress
+    {
+        /** Position of the work plane in the file. */
+        uint64_t position = 0;
+        /** The work plane without vector blocks, with its final work plane number, written when
+         *  the work plane is finished. */
+        WorkPlane shell;
+        /** The positions of the vector blocks written so far. */
+        WorkPlaneLUT lut;
+        /** Checksum of the bytes written after the work plane lut offset so far. */
+        uint32_t checksum = 0;
+    };
+
+    /** The work plane that is being written to the file. */
+    std::optional<WorkPlaneInProgress> current_wp_;
+    /** Whether a work plane was appended and can still be appended to. Unlike current_wp_,
+     *  tracked by the calling thread if vector blocks are serialized by multiple threads. */
+    bool is_work_plane_open_ = false;
     /** The job shell held in memory before it is committed and written. */
     std::optional<Job> job_shell_;
     /** The job lut held in memory to be updated with offsets before it is written. */
@@ -161,6 +296,36 @@ private:
      *  will be written. */
     std::optional<uint64_t> job_lut_offset_offset_;
 
+    /** Whether an index file is written next to each written file. */
+    bool write_index_file_;
+    /** The path of the file that is written, to derive the path of the index file. */
+    std::optional<std::string> path_;
+    /** The luts of all written work planes, kept in memory for the index file. */
+    std::vector<WorkPlaneLUT> work_plane_luts_;
+
+    /** Which checksums are written. */
+    ChecksumMode checksum_mode_;
+    /** The checksums of all written work planes and vector blocks, written with the footer. */
+    std::vector<uint32_t> work_plane_checksums_;
+    std::vector<uint32_t> num_vector_blocks_;
+    std::vector<uint32_t> vector_block_checksums_;
+
+    /** Buffer vector blocks and work plane shells are serialized into before they are written,
+     *  reused across them. */
+    std::string serialize_buffer_;
+
+    /** Vector blocks serialized in parallel as one task, and the result. */
+    struct VectorBlockBatch;
+    /** Vector blocks collected for the next task of the pipeline. */
+    std::shared_ptr<VectorBlockBatch> pending_batch_;
+    /** Memory of owned vector blocks at which a batch is submitted, a fraction of the queue budget. */
+    size_t max_batch_bytes_ = 0;
+
+    /** Threads serializing vector blocks and writing them in order, nullptr if vector blocks
+     *  are serialized on the calling thread. Declared last, so the threads are stopped before
+     *  the state they write to is destroyed. */
+    std::unique_ptr<SerializationPipeline> pipeline_;
+
     /**
      * @brief Performs the write operation of the file header.
      * 
@@ -181,30 +346,106 @@ private:
      */
     void WriteFullWorkPlane(const WorkPlane& wp);
 
+    /**
+     * @brief Begins a work plane, finishing the previous one if available.
+     * 
+     * Only the shell of the provided work plane is used, its vector blocks have to be added
+     * with OvfFileWriter::AddVectorBlock.
+     * 
+     * @param wp The work plane to begin.
+     */
+    void BeginWorkPlane(const WorkPlane& wp);
+
+    /**
+     * @brief Adds a vector block to the current work plane.
+     * 
+     * Writes the vector block right away, or adds it to the next batch serialized by the pipeline.
+     * 
+     * @param vb The vector block to add.
+     * @param is_borrowed Whether the vector block stays valid until the write is finished, so the
+     * batch can refer to it. Otherwise it is copied into the batch.
+     */
+    void AddVectorBlock(const VectorBlock& vb, bool is_borrowed);
+
+    /** Like AddVectorBlock(const VectorBlock&, bool), but moves the vector block into the batch. */
+    void AddVectorBlock(VectorBlock&& vb);
+
+    /** Like AddVectorBlock(const VectorBlock&, bool), but passes ownership to the batch. */
+    void AddVectorBlock(std::unique_ptr<VectorBlock> vb);
+
+    /**
+     * @brief Finishes the current work plane, if available.
+     */
+    void FinishWorkPlane();
+
+    /**
+     * @brief Submits the pending batch of vector blocks to the pipeline, if available.
+     */
+    void SubmitBatch();
+
+    /**
+     * @brief Writes the start of a work plane, a placeholder for its lut offset.
+     * 
+     * @param shell The work plane shell, with its final work plane number.
+     */
+    void WriteWorkPlaneStart(WorkPlane&& shell);
+
+    /**
+     * @brief Serializes a vector block and writes it as part of the current work plane.
+     * 
+     * @param vb The vector block to write.
+     */
+    void WriteVectorBlock(const VectorBlock& vb);
+
+    /**
+     * @brief Writes a batch of serialized vector blocks as part of the current work plane.
+     * 
+     * @param batch The batch, serialized by the pipeline.
+     */
+    void WriteVectorBlocks(const VectorBlockBatch& batch);
+
+    /**
+     * @brief Writes the end of the current work plane, its shell and lut, and inserts the lut
+     * offset into its placeholder.
+     */
+    void WriteWorkPlaneEnd();
+
+    /**
+     * @brief Aborts the write in progress after an error, so a new one can be started.
+     * 
+     * Called by every method starting, appending to or finishing a write if writing throws,
+     * whether vector blocks are written synchronously or by the pipeline. Waits for the tasks
+     * of the pipeline, and closes the incomplete file.
+     */
+    void AbortWrite();
+
+    /**
+     * @brief Checks for a partial write in progress with a work plane in memory, before appending
+     * a vector block.
+     * 
+     * Throws a corresponding exception otherwise.
+     */
+    void CheckCanAppendVectorBlock();
+
     /**
      * @brief Performs the write operation of the file footer and inserts missing offsets.
      * 
-     * Commits and writes a pending work plane in memory, if available, then writes job shell
+     * Finishes a pending work plane, if available, then writes job shell
      * and job lut to the file, and inserts missing offsets into the placeholder bytes. Finally
      * flushes and closes the stream.
      */
     void WriteFooter();
 
     /**
-     * @brief Checks for health of the output file stream.
+     * @brief Checks for the output file to be open.
      * 
-     * Throws a corresponding exception if the stream is degraded or closed.
+     * Throws a corresponding exception if it is not. Errors writing the file are thrown
+     * by the write that fails.
      */
     inline void CheckFsHealth()
     {
-        if (!ofs_.has_value())
-            throw std::runtime_error("Output file stream was not set");
-
-        if (!ofs_->is_open())
-            throw std::runtime_error("Output file stream closed unexpectedly");
-
-        if (!ofs_->good())
-            throw std::runtime_error("Output file stream encountered an error");
+        if (!output_file_.has_value())
+            throw std::runtime_error("Output file was not set");
     }
 
     /**
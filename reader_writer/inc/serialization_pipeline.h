@@ -0,0 +1,184 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Counters describing the queue of a SerializationPipeline, to size its byte budget.
+ */
+struct QueueStatistics
+{
+    /** Number of tasks currently submitted and not committed yet. */
+    size_t num_queued_tasks = 0;
+
+    /** Memory currently held by the queued tasks in bytes. */
+    size_t queued_bytes = 0;
+
+    /** Maximum memory held by the queued tasks at once in bytes. */
+    size_t peak_queued_bytes = 0;
+
+    /** Number of submissions that blocked because the queue was full. */
+    uint64_t num_stalls = 0;
+
+    /** Total time submissions blocked because the queue was full, in seconds. */
+    double stall_seconds = 0;
+};
+
+/**
+ * @brief Runs tasks in two stages, a parallel one and an ordered one.
+ * 
+ * Each submitted task has a serialize step, run by any of a pool of worker threads, and a
+ * commit step, run by a single committer thread in the order the tasks were submitted, once
+ * their serialize step is done. Used by OvfFileWriter to serialize vector blocks in parallel
+ * while writing them to the file in order.
+ * 
+ * The number of submitted tasks that are not committed yet and the memory they hold are
+ * bounded, submitting blocks while a bound is reached. If a step throws, the steps of all
+ * following tasks are skipped, and the exception is rethrown to the submitting thread until
+ * the pipeline is reset with Wait().
+ */
+class SerializationPipeline
+{
+public:
+    /**
+     * @brief Construct a new Serialization Pipeline object and starts its threads.
+     * 
+     * @param num_threads The number of worker threads running serialize steps, at least one.
+     * @param max_pending_tasks The maximum number of tasks submitted but not committed yet.
+     * @param max_pending_bytes The maximum memory held by tasks submitted but not committed yet,
+     * in bytes. A task exceeding it on its own is submitted once the queue is empty.
+     */
+    SerializationPipeline(int num_threads, size_t max_pending_tasks, size_t max_pending_bytes);
+
+    /**
+     * @brief Destroy the Serialization Pipeline object, discarding pending tasks and stopping its threads.
+     */
+    ~SerializationPipeline();
+
+    // Deleting copy and move because the threads refer to this object.
+    SerializationPipeline(const SerializationPipeline&) = delete;
+    SerializationPipeline& operator=(const SerializationPipeline&) = delete;
+
+    /**
+     * @brief Submits a task, blocking while the maximum number of tasks or bytes is pending.
+     * 
+     * @param serialize The step run by a worker thread, may be empty. Returns the memory the
+     * task holds from then on until it is committed, in bytes.
+     * @param commit The step run by the committer thread after the serialize steps of this and
+     * all previous tasks.
+     * @param size The memory the task holds until it is serialized, in bytes.
+     * @throws std::exception A step of a previous task threw.
+     */
+    void Submit(std::function<size_t()> serialize, std::function<void()> commit, size_t size = 0);
+
+    /**
+     * @brief Waits until all submitted tasks are committed.
+     * 
+     * @throws std::exception A step of a task threw.
+     */
+    void Drain();
+
+    /**
+     * @brief Rethrows the error of a step, without waiting for other tasks unless one threw.
+     * 
+     * Cheap enough to be called for every appended vector block.
+     * 
+     * @throws std::exception A step of a task threw.
+     */
+    void ThrowIfFailed();
+
+    /**
+     * @brief Waits until all submitted tasks are committed or skipped, without throwing.
+     * 
+     * Used when aborting, so no task refers to data of the caller afterwards. Errors are cleared.
+     */
+    void Wait();
+
+    /**
+     * @brief Gets the queue depth and the time submissions blocked on a full queue, since construction.
+     */
+    QueueStatistics GetStatistics() const;
+
+private:
+    /** A submitted task, the memory it holds, and whether its serialize step is done. */
+    struct Task
+    {
+        std::function<size_t()> serialize;
+        std::function<void()> commit;
+        size_t size = 0;
+        bool is_serialized = false;
+    };
+
+    const size_t max_pending_tasks_;
+    const size_t max_pending_bytes_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable submitted_;
+    std::condition_variable serialized_;
+    std::condition_variable committed_;
+
+    /** Pending tasks in the order of submission. References stay valid until a task is committed,
+     *  as tasks are only added at the back and removed at the front. */
+    std::deque<Task> tasks_;
+    /** Sequence number of the task at the front of tasks_, counting all submitted tasks. */
+    uint64_t first_task_ = 0;
+    /** Sequence number of the next task to serialize. */
+    uint64_t next_to_serialize_ = 0;
+
+    /** Memory held by the pending tasks in bytes. */
+    size_t pending_bytes_ = 0;
+    QueueStatistics statistics_;
+
+    /** The first exception thrown by a step since the last Wait. */
+    std::exception_ptr error_;
+    /** Whether error_ is set, read without locking by ThrowIfFailed. */
+    std::atomic<bool> has_failed_{false};
+    bool is_stopped_ = false;
+
+    std::vector<std::thread> workers_;
+    std::thread committer_;
+
+    void SerializeTasks();
+    void CommitTasks();
+    void SetError(std::exception_ptr error);
+    void ThrowError(std::unique_lock<std::mutex>& lock);
+};
+
+}
\ No newline at end of file
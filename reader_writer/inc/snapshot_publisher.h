@@ -0,0 +1,184 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <cstdint>
+#include <utility>
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Publishes immutable snapshots of some state to concurrent readers without locking.
+ * 
+ * Readers enter a read section, in which the snapshot they loaded stays valid, by
+ * incrementing a counter of their own stripe and loading a plain pointer. Publishing
+ * a new snapshot replaces the pointer and then waits for a grace period, i.e. until all
+ * read sections that might still use the previous snapshot are left, before releasing
+ * its reference to the previous snapshot. Readers on different threads thereby do not
+ * write to a shared cache line, unlike e.g. with a std::shared_mutex.
+ * 
+ * Snapshots are reference counted, so a snapshot can also be shared with other publishers
+ * or kept by the caller of Get(), beyond the lifetime of its publication.
+ * 
+ * Publishing from within a read section of the same publisher deadlocks.
+ * 
+ * @tparam T The type of the snapshots.
+ */
+template <class T>
+class SnapshotPublisher
+{
+private:
+    /** Counters of the read sections per epoch parity, padded to a cache line. */
+    struct alignas(64) Stripe
+    {
+        std::atomic<uint32_t> num_readers[2] = {0, 0};
+    };
+
+public:
+    /**
+     * @brief A read section, in which the loaded snapshot stays valid.
+     */
+    class ReadGuard
+    {
+    public:
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+        ~ReadGuard()
+        {
+            num_readers_.fetch_sub(1, std::memory_order_release);
+        }
+
+        /** The snapshot at the time of entering the read section, nullptr if none is published. */
+        const T* get() const { return snapshot_; }
+        const T& operator*() const { return *snapshot_; }
+        const T* operator->() const { return snapshot_; }
+
+    private:
+        friend class SnapshotPublisher;
+
+        ReadGuard(std::atomic<uint32_t>& num_readers, const T *snapshot)
+            : num_readers_{num_readers}, snapshot_{snapshot}
+        {}
+
+        std::atomic<uint32_t>& num_readers_;
+        const T *snapshot_;
+    };
+
+    SnapshotPublisher() = default;
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    /**
+     * @brief Enters a read section and loads the current snapshot.
+     * 
+     * Lock-free, the snapshot has to be used within the lifetime of the returned guard only.
+     */
+    ReadGuard Read() const
+    {
+        auto& stripe = stripes_[ThisThreadStripe()];
+
+        // the snapshot has to be loaded after incrementing the counter,
+        // seq_cst orders both against Publish(), which does the reverse
+        auto& num_readers = stripe.num_readers[epoch_.load() & 1];
+        num_readers.fetch_add(1);
+
+        return ReadGuard{num_readers, current_.load()};
+    }
+
+    /**
+     * @brief Gets a reference to the current snapshot, valid beyond any read section.
+     * 
+     * Takes a lock, meant for sharing a snapshot rather than for reading from it.
+     */
+    std::shared_ptr<const T> Get() const
+    {
+        std::lock_guard lock{mutex_};
+        return owner_;
+    }
+
+    /**
+     * @brief Replaces the current snapshot.
+     * 
+     * Returns once no read section uses the previous snapshot anymore. Concurrent calls
+     * are serialized.
+     * 
+     * @param snapshot The new snapshot, or nullptr.
+     */
+    void Publish(std::shared_ptr<const T> snapshot)
+    {
+        std::shared_ptr<const T> previous;
+        {
+            std::lock_guard lock{mutex_};
+
+            previous = std::exchange(owner_, std::move(snapshot));
+            current_.store(owner_.get());
+
+            // Readers that entered before the snapshot was replaced may still use the previous one.
+            // They might have read an epoch of any parity before incrementing, so both parities are
+            // drained, each after flipping the epoch to direct new readers to the other parity.
+            for (int i = 0; i < 2; i++)
+            {
+                const uint32_t parity = epoch_.fetch_add(1) & 1;
+                for (auto& stripe : stripes_)
+                {
+                    while (stripe.num_readers[parity].load() != 0)
+                        std::this_thread::yield();
+                }
+            }
+        }
+
+        // the previous snapshot is released outside of the lock, which might e.g. unmap a file
+    }
+
+private:
+    static constexpr size_t kNumStripes = 32;
+
+    mutable std::array<Stripe, kNumStripes> stripes_;
+    std::atomic<uint32_t> epoch_{0};
+    std::atomic<const T*> current_{nullptr};
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const T> owner_;
+
+    /** Stripes are assigned to threads round robin, on the first read section of a thread. */
+    static size_t ThisThreadStripe()
+    {
+        static std::atomic<size_t> next_stripe{0};
+        thread_local const size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % kNumStripes;
+        return stripe;
+    }
+};
+
+}
\ No newline at end of file
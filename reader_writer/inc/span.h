@@ -0,0 +1,103 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Non-owning view of a contiguous sequence of objects.
+ * 
+ * Minimal stand-in for C++20 std::span, as this library is built as C++17.
+ * 
+ * @tparam T The element type. Use a const type for read-only views.
+ */
+template <typename T>
+class Span
+{
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    /**
+     * @brief Construct a new, empty Span object
+     */
+    constexpr Span() noexcept = default;
+
+    /**
+     * @brief Construct a new Span object
+     * 
+     * @param data Pointer to the first element.
+     * @param size Number of elements.
+     */
+    constexpr Span(T *data, size_t size) noexcept
+        : data_{data}, size_{size}
+    {}
+
+    /**
+     * @brief Construct a new Span object viewing a contiguous container.
+     * 
+     * @param container Any container providing data() and size(), e.g. std::vector
+     * or google::protobuf::RepeatedField.
+     */
+    template <class Container,
+              class = std::enable_if_t<std::is_convertible_v<decltype(std::declval<Container&>().data()), T*>>>
+    constexpr Span(Container& container) noexcept
+        : data_{container.data()}, size_{(size_t)container.size()}
+    {}
+
+    constexpr T *data() const noexcept { return data_; }
+    constexpr size_t size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr iterator begin() const noexcept { return data_; }
+    constexpr iterator end() const noexcept { return data_ + size_; }
+
+    constexpr T& operator[](size_t i) const { return data_[i]; }
+
+    /**
+     * @brief Creates a view of a subrange of this span.
+     * 
+     * @param offset Index of the first element of the subrange.
+     * @param count Number of elements in the subrange.
+     */
+    constexpr Span subspan(size_t offset, size_t count) const
+    {
+        return Span{data_ + offset, count};
+    }
+
+private:
+    T *data_ = nullptr;
+    size_t size_ = 0;
+};
+
+}
\ No newline at end of file
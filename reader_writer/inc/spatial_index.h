@@ -0,0 +1,232 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+
+#include "span.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Axis aligned rectangle in the x-y plane, in the coordinates of the vector data.
+ * 
+ * Default constructed boxes are empty and intersect nothing.
+ */
+struct BoundingBox
+{
+    float x_min = std::numeric_limits<float>::infinity();
+    float y_min = std::numeric_limits<float>::infinity();
+    float x_max = -std::numeric_limits<float>::infinity();
+    float y_max = -std::numeric_limits<float>::infinity();
+
+    /** A box covering the whole plane, which intersects every non-empty box. */
+    static BoundingBox Unbounded()
+    {
+        const float inf = std::numeric_limits<float>::infinity();
+        return BoundingBox{-inf, -inf, inf, inf};
+    }
+
+    /** Whether the box contains no point at all. */
+    bool is_empty() const { return !(x_min <= x_max && y_min <= y_max); }
+
+    /** Whether the box extends infinitely in any direction. */
+    bool is_unbounded() const
+    {
+        const float inf = std::numeric_limits<float>::infinity();
+        return x_min == -inf || y_min == -inf || x_max == inf || y_max == inf;
+    }
+
+    /** Whether both boxes share at least one point, touching edges included. */
+    bool Intersects(const BoundingBox& other) const
+    {
+        return x_min <= other.x_max && other.x_min <= x_max &&
+               y_min <= other.y_max && other.y_min <= y_max;
+    }
+
+    /** Extends the box to include another one. */
+    void Extend(const BoundingBox& other)
+    {
+        x_min = std::min(x_min, other.x_min);
+        y_min = std::min(y_min, other.y_min);
+        x_max = std::max(x_max, other.x_max);
+        y_max = std::max(y_max, other.y_max);
+    }
+};
+
+/**
+ * @brief Computes the bounding box of interleaved point coordinates.
+ * 
+ * Uses SIMD min/max instructions where available. Only x and y are taken into account,
+ * for 3D points the z coordinate is skipped. NaN coordinates are ignored.
+ * 
+ * @param points Coordinates interleaved as x, y(, z).
+ * @param dimensions Number of coordinates per point, 2 or 3.
+ * @return BoundingBox The bounding box, empty if there are no points.
+ */
+BoundingBox ComputePointBounds(Span<const float> points, const int dimensions);
+
+/**
+ * @brief Packed Hilbert R-tree over the bounding boxes of the vector blocks of a work plane.
+ * 
+ * The boxes are sorted along a Hilbert curve through their centers and packed bottom up
+ * into nodes of kNodeSize children, stored level by level in flat arrays. Boxes covering
+ * the whole plane, i.e. of vector blocks whose extent is not known, are kept in a separate
+ * list and match every query. Empty boxes never match.
+ */
+class BoundingBoxTree
+{
+public:
+    /** Maximum number of children per node. */
+    static constexpr int kNodeSize = 16;
+
+    BoundingBoxTree() = default;
+
+    /**
+     * @brief Construct a new Bounding Box Tree object
+     * 
+     * @param boxes The bounding box per vector block, indexed like the vector blocks.
+     */
+    explicit BoundingBoxTree(std::vector<BoundingBox> boxes);
+
+    /**
+     * @brief Finds the vector blocks whose bounding box intersects a region.
+     * 
+     * @param region The region to query.
+     * @param i_vector_blocks Receives the indices of the matching vector blocks in ascending,
+     * i.e. file order. Any previous content is replaced.
+     */
+    void Query(const BoundingBox& region, std::vector<int>& i_vector_blocks) const;
+
+    /** The bounding box per vector block, indexed like the vector blocks. */
+    const std::vector<BoundingBox>& boxes() const { return boxes_; }
+
+    /** The union of all bounded boxes, empty if there are none. */
+    BoundingBox bounds() const { return nodes_.empty() ? BoundingBox{} : nodes_.back(); }
+
+    /** Approximate memory used by the tree in bytes. */
+    size_t SpaceUsed() const
+    {
+        return sizeof(*this)
+            + (boxes_.capacity() + nodes_.capacity()) * sizeof(BoundingBox)
+            + (node_children_.capacity() + unbounded_.capacity()) * sizeof(int)
+            + level_ends_.capacity() * sizeof(size_t);
+    }
+
+private:
+    /** The bounding box per vector block. */
+    std::vector<BoundingBox> boxes_;
+
+    // Nodes of all levels, leaves first and the root last. For leaves, node_children_ holds
+    // the index of the vector block, for inner nodes the position of their first child.
+    std::vector<BoundingBox> nodes_;
+    std::vector<int> node_children_;
+
+    /** End position in nodes_ per level, from the leaves up to the root. */
+    std::vector<size_t> level_ends_;
+
+    /** Vector blocks matching every query. */
+    std::vector<int> unbounded_;
+};
+
+/**
+ * @brief Spatial index of the vector blocks of a job, one BoundingBoxTree per work plane.
+ * 
+ * Work planes are indexed on first access, or all at once in advance. Like the lazily
+ * indexed work planes of JobIndex, each tree is built exactly once and read-only afterwards.
+ */
+class SpatialIndex
+{
+public:
+    /**
+     * @brief Construct a new Spatial Index object, without indexing any work plane yet.
+     * 
+     * @param num_work_planes The number of work planes in the job.
+     */
+    explicit SpatialIndex(const int num_work_planes)
+        : num_work_planes_{num_work_planes},
+          work_planes_{std::make_unique<WorkPlaneSlot[]>(num_work_planes)}
+    {}
+
+    /**
+     * @brief Gets the tree of a work plane, building it on first access.
+     * 
+     * Thread-safe. If building fails, the exception is propagated and the next access retries.
+     * 
+     * @param i_work_plane The index of the work plane.
+     * @param build Callable (int i_work_plane) returning the bounding box per vector block.
+     * @throws std::runtime_error The work plane index is invalid.
+     */
+    template <class BuildFn>
+    const BoundingBoxTree& GetWorkPlane(const int i_work_plane, BuildFn build) const
+    {
+        if (i_work_plane < 0 || i_work_plane > num_work_planes_ - 1)
+            throw std::runtime_error("Invalid work plane index");
+
+        auto& slot = work_planes_[i_work_plane];
+        if (!slot.is_indexed.load(std::memory_order_acquire))
+        {
+            std::call_once(slot.is_indexing, [&](){
+                slot.tree = BoundingBoxTree{build(i_work_plane)};
+                slot.is_indexed.store(true, std::memory_order_release);
+            });
+        }
+
+        return slot.tree;
+    }
+
+    /** Whether the tree of a work plane is built already. */
+    bool IsIndexed(const int i_work_plane) const
+    {
+        return work_planes_[i_work_plane].is_indexed.load(std::memory_order_acquire);
+    }
+
+    /** The number of work planes in the job. */
+    int num_work_planes() const { return num_work_planes_; }
+
+private:
+    struct WorkPlaneSlot
+    {
+        std::atomic<bool> is_indexed{false};
+        std::once_flag is_indexing;
+        BoundingBoxTree tree;
+    };
+
+    const int num_work_planes_;
+    std::unique_ptr<WorkPlaneSlot[]> work_planes_;
+};
+
+}
\ No newline at end of file
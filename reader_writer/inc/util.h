@@ -29,9 +29,17 @@ SOFTWARE.
 #pragma once
 
 #include "google/protobuf/message.h"
+#include "google/protobuf/arena.h"
 #include <fcntl.h>
 #include <iostream>
 #include <functional>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <exception>
+#include <algorithm>
 
 namespace open_vector_format::util {
 
@@ -117,6 +125,92 @@ void MergeExcluding(const google::protobuf::Message& source,
     }
 }
 
+/**
+ * @brief Reports whether a field number belongs to the vector_data oneof of VectorBlock.
+ * 
+ * Looked up once from the descriptor, so that vector data types added to the format
+ * are recognized without changes.
+ */
+bool IsVectorDataField(const int field_number);
+
+/**
+ * @brief Queries the size and modification time of a file, used to detect outdated index files.
+ * 
+ * @return true If both could be queried.
+ * @return false If the file does not exist or can't be accessed.
+ */
+bool GetFileStamp(const std::string& path, uint64_t& file_size, int64_t& file_time);
+
+/**
+ * @brief Creates a message owned by an arena.
+ * 
+ * Submessages and repeated fields of the created message are allocated on the same arena.
+ * Abstracts over the protobuf versions, as Arena::Create only follows the arena protocol
+ * of messages since protobuf 22, while Arena::CreateMessage got removed later on.
+ * 
+ * @tparam T The message type to create.
+ * @param arena The arena to allocate the message on.
+ * @return T* The message, owned by the arena.
+ */
+template <class T>
+inline T* CreateOnArena(google::protobuf::Arena& arena)
+{
+#if GOOGLE_PROTOBUF_VERSION < 4022000
+    return google::protobuf::Arena::CreateMessage<T>(&arena);
+#else
+    return google::protobuf::Arena::Create<T>(&arena);
+#endif
+}
+
+/**
+ * @brief Calls a function for every index in [0, count), distributed over multiple threads.
+ * 
+ * Indices are handed out one at a time, so tasks of uneven cost are balanced across
+ * the threads. If any call throws, the remaining indices are skipped and the first
+ * exception is rethrown after all threads finished.
+ * 
+ * @param count The number of indices.
+ * @param num_threads The number of threads to use, including the calling thread.
+ * @param fn The function to call with each index.
+ */
+template <class Fn>
+void ParallelFor(const int count, const int num_threads, Fn fn)
+{
+    std::atomic<int> next_index{0};
+    std::atomic<bool> has_failed{false};
+    std::exception_ptr error;
+
+    auto run = [&](){
+        for (int i = next_index++; i < count && !has_failed; i = next_index++)
+        {
+            try
+            {
+                fn(i);
+            }
+            catch (...)
+            {
+                if (!has_failed.exchange(true))
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < std::min(num_threads, count); i++)
+    {
+        threads.emplace_back(run);
+    }
+    run();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
 /**
  * @brief Determines the endianness of the host system at runtime.
  * 
@@ -143,8 +237,6 @@ inline bool IsSystemBigEndian()
 template <typename T>
 inline void WriteAsLittleEndian(T integer, std::ostream& os)
 {
-    std::cout << sizeof(integer) << std::endl;
-
     if (IsSystemBigEndian())
     {
         uint8_t buf[sizeof(integer)];
@@ -159,6 +251,29 @@ inline void WriteAsLittleEndian(T integer, std::ostream& os)
     }
 }
 
+/**
+ * @brief Writes an integer to an array in little-endian byte order.
+ * 
+ * @tparam T The type of the integer to write.
+ * @param integer The integer to write.
+ * @param out The output array to write to, with room for at least sizeof(T) bytes.
+ * @return uint8_t* Pointer past the written bytes.
+ */
+template <typename T>
+inline uint8_t* WriteAsLittleEndian(T integer, uint8_t *out)
+{
+    if (IsSystemBigEndian())
+    {
+        for (size_t i = 0; i < sizeof(integer); i++)
+            out[i] = ((uint8_t*)(&integer))[sizeof(integer) - i - 1];
+    }
+    else
+    {
+        memcpy(out, (uint8_t*)(&integer), sizeof(integer));
+    }
+    return out + sizeof(integer);
+}
+
 /**
  * @brief Reads an integer from a stream in little-endian byte order.
  * 
@@ -0,0 +1,144 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "open_vector_format.pb.h"
+#include "ovf_reader_writer_export.h"
+#include "file_view.h"
+#include "span.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Read-only, zero-copy view of a serialized vector block.
+ * 
+ * Instead of parsing the full protobuf message, only the wire format structure of
+ * the vector block is scanned. Scalar fields are decoded, while the packed coordinates
+ * of LineSequence, Hatches and PointSequence blocks (and their 3D variants) are
+ * exposed directly from the underlying file view.
+ * 
+ * The view keeps the file view it was created from. When created from a persistently
+ * mapped file, it is only valid as long as the file stays open in the reader.
+ */
+class OVF_READER_WRITER_EXPORT VectorBlockView
+{
+public:
+    /**
+     * @brief Construct a new Vector Block View object
+     * 
+     * @param view File view starting at a length delimited, serialized vector block.
+     * The view may extend beyond the vector block.
+     * @throws std::runtime_error The vector block is malformed or exceeds the view.
+     */
+    explicit VectorBlockView(FileView view);
+
+    // Owning a file view, which can only be moved.
+    VectorBlockView(const VectorBlockView&) = delete;
+    VectorBlockView& operator=(const VectorBlockView&) = delete;
+    VectorBlockView(VectorBlockView&&) = default;
+    VectorBlockView& operator=(VectorBlockView&&) = default;
+
+    /** Which of the vector data types is set, same as VectorBlock::vector_data_case(). */
+    VectorBlock::VectorDataCase vector_data_case() const { return vector_data_case_; }
+
+    /** The key into the marking params map of the job. */
+    int32_t marking_params_key() const { return marking_params_key_; }
+
+    /** The index of the laser this vector block is assigned to. */
+    int32_t laser_index() const { return laser_index_; }
+
+    /** The number of repeats of this vector block. */
+    uint64_t repeats() const { return repeats_; }
+
+    /**
+     * @brief Reports whether the vector data consists of packed point coordinates.
+     * 
+     * True for LineSequence, Hatches and PointSequence, as well as their 3D variants.
+     * Only for these, points() and point_dimensions() are meaningful.
+     */
+    bool has_points() const { return point_dimensions_ != 0; }
+
+    /** Number of coordinates per point, i.e. 2 for 2D and 3 for 3D vector data, 0 without points. */
+    int point_dimensions() const { return point_dimensions_; }
+
+    /**
+     * @brief Accessor to the point coordinates, interleaved as x, y(, z).
+     * 
+     * Points directly into the file view if the coordinates are suitably aligned and
+     * the host is little endian. Otherwise, the coordinates were copied into a buffer
+     * owned by this view, see is_zero_copy().
+     */
+    Span<const float> points() const
+    {
+        return points_;
+    }
+
+    /** Reports whether points() points directly into the file view. */
+    bool is_zero_copy() const { return points_buffer_.empty(); }
+
+    /** The raw, little endian bytes of the packed point coordinates in the file view. */
+    Span<const uint8_t> raw_points() const { return raw_points_; }
+
+    /** The serialized vector block, excluding the length delimiter. */
+    Span<const uint8_t> message_bytes() const { return message_; }
+
+    /**
+     * @brief Fully parses the vector block, as a fallback for data not exposed by the view.
+     * 
+     * @param vb A reference to the object into which the vector block should be parsed.
+     * @throws std::runtime_error The vector block could not be parsed.
+     */
+    void Parse(VectorBlock& vb) const;
+
+private:
+    /** The file view the vector block is read from. */
+    FileView view_;
+
+    /** The serialized vector block within the file view. */
+    Span<const uint8_t> message_;
+
+    VectorBlock::VectorDataCase vector_data_case_ = VectorBlock::VECTOR_DATA_NOT_SET;
+    int32_t marking_params_key_ = 0;
+    int32_t laser_index_ = 0;
+    uint64_t repeats_ = 0;
+
+    int point_dimensions_ = 0;
+    Span<const uint8_t> raw_points_;
+    Span<const float> points_;
+
+    /** Copy of the coordinates, only used when they can't be accessed in place. */
+    std::vector<float> points_buffer_;
+
+    void ScanVectorData(const uint8_t *data, int size, int dimensions);
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <condition_variable>
+
+#include "open_vector_format.pb.h"
+#include "ovf_reader_writer_export.h"
+#include "ovf_file_reader.h"
+
+namespace open_vector_format::reader_writer {
+
+/**
+ * @brief Options to control how work planes are read ahead by a WorkPlaneStream.
+ */
+struct WorkPlaneStreamOptions
+{
+    /** Maximum number of work planes decoded ahead of the consumer. */
+    int look_ahead = 2;
+
+    /** Number of background threads decoding work planes. */
+    int num_threads = 1;
+
+    /** Index of the first work plane of the stream. */
+    int first_work_plane = 0;
+
+    /** Number of work planes to stream, or -1 for all work planes from the first one on. */
+    int num_work_planes = -1;
+
+    /** Whether to release the file contents of each work plane once it is decoded, see
+     *  OvfFileReader::ReleaseWorkPlanes(), so streaming long jobs uses bounded memory. */
+    bool release_decoded = false;
+};
+
+/**
+ * @brief Streams the work planes of an open file in order, decoding upcoming work planes in the background.
+ * 
+ * While the consumer processes work plane N, background threads read and decode
+ * work planes N+1 to N+look_ahead. Decoded work planes are handed over through a
+ * bounded queue, so the time until the next work plane is available does not
+ * depend on disk or parsing latency as long as the consumer is the slower side.
+ * 
+ * For large files, opening the file with AccessPattern::kSequential additionally
+ * lets the operating system read ahead on the file level.
+ * 
+ * The reader must stay open for the lifetime of the stream.
+ */
+class OVF_READER_WRITER_EXPORT WorkPlaneStream
+{
+public:
+    /**
+     * @brief Construct a new Work Plane Stream object and starts decoding in the background.
+     * 
+     * @param reader The reader of the file to stream. Must have a file opened.
+     * @param options Options on the work planes to stream and how far to read ahead.
+     * @throws std::runtime_error No file is opened, or the options are invalid.
+     */
+    WorkPlaneStream(const OvfFileReader& reader, const WorkPlaneStreamOptions& options = {});
+
+    /**
+     * @brief Destroy the Work Plane Stream object, stopping the background threads.
+     */
+    ~WorkPlaneStream();
+
+    // Deleting copy and move because background threads refer to this object.
+    WorkPlaneStream(const WorkPlaneStream&) = delete;
+    WorkPlaneStream& operator=(const WorkPlaneStream&) = delete;
+
+    /**
+     * @brief Gets the next work plane of the stream.
+     * 
+     * Blocks until the next work plane is decoded. The previous contents of wp are
+     * recycled for decoding upcoming work planes.
+     * 
+     * @param wp A reference to the object into which the work plane should be read.
+     * @return true A work plane was read.
+     * @return false The end of the stream was reached, wp is left unchanged.
+     * @throws std::runtime_error Reading the work plane failed. The stream continues
+     * with the following work plane on the next call.
+     */
+    bool Next(WorkPlane& wp);
+
+    /**
+     * @brief The index of the work plane returned by the next call to Next().
+     */
+    int next_work_plane() const;
+
+private:
+    /** A decoded work plane, or the error that occurred while decoding it. */
+    struct Slot
+    {
+        WorkPlane wp;
+        std::exception_ptr error;
+        bool is_ready = false;
+    };
+
+    const OvfFileReader& reader_;
+    const int end_;
+    const int look_ahead_;
+    const bool release_decoded_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable decoded_;
+    std::condition_variable consumed_;
+
+    /** Ring buffer of look_ahead_ slots, work plane i is decoded into slot i % look_ahead_. */
+    std::vector<Slot> slots_;
+    int next_to_consume_;
+    int next_to_decode_;
+    bool is_stopped_ = false;
+
+    std::vector<std::thread> threads_;
+
+    void DecodeWorkPlanes();
+};
+
+}
\ No newline at end of file
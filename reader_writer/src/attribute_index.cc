@@ -0,0 +1,314 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+
+#include <limits>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "attribute_index.h"
+#include "consts.h"
+#include "util.h"
+
+namespace open_vector_format::reader_writer {
+
+namespace {
+
+/**
+ * @brief Header of an attribute index file.
+ * 
+ * Followed by the number of the first vector block per work plane, including the total
+ * number of vector blocks, and the attributes of all vector blocks. Stored in the byte
+ * order of the machine writing the file, like index files, see JobIndex.
+ */
+struct AttributeIndexFileHeader
+{
+    uint8_t magic[4];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t reserved;
+    uint64_t job_file_size;
+    int64_t job_file_time;
+    uint64_t job_lut_position;
+    uint64_t num_work_planes;
+    uint64_t num_vector_blocks;
+};
+
+static_assert(sizeof(VectorBlockAttributes) == 3 * sizeof(int32_t), "Attributes are stored without padding");
+
+const uint32_t kByteOrderMark = 0x01020304;
+
+}
+
+AttributeIndex::AttributeIndex(const std::vector<std::vector<VectorBlockAttributes>>& attributes)
+{
+    size_t num_vector_blocks = 0;
+    for (const auto& wp_attributes : attributes)
+        num_vector_blocks += wp_attributes.size();
+
+    if (num_vector_blocks > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("Too many vector blocks to index");
+
+    first_vector_blocks_.reserve(attributes.size() + 1);
+    attributes_.reserve(num_vector_blocks);
+    for (const auto& wp_attributes : attributes)
+    {
+        first_vector_blocks_.push_back((uint32_t)attributes_.size());
+        attributes_.insert(attributes_.end(), wp_attributes.begin(), wp_attributes.end());
+    }
+    first_vector_blocks_.push_back((uint32_t)attributes_.size());
+
+    BuildPostingLists();
+}
+
+std::optional<AttributeIndex> AttributeIndex::Load(const std::string& job_path, const uint64_t job_lut_position)
+{
+    const std::string index_path = job_path + kAttributeIndexFileExtension;
+
+    std::error_code ec;
+    if (!std::filesystem::exists(index_path, ec))
+        return {};
+
+    uint64_t job_file_size;
+    int64_t job_file_time;
+    if (!util::GetFileStamp(job_path, job_file_size, job_file_time))
+        return {};
+
+    const uint64_t index_file_size = (uint64_t)std::filesystem::file_size(index_path, ec);
+    if (ec || index_file_size < sizeof(AttributeIndexFileHeader))
+        return {};
+
+    std::ifstream ifs{index_path, std::ios::binary};
+
+    AttributeIndexFileHeader header;
+    if (!ifs.read((char*)&header, sizeof(header)))
+        return {};
+
+    if (!std::equal(kAttributeIndexMagicBytes.begin(), kAttributeIndexMagicBytes.end(), header.magic) ||
+        header.version != kAttributeIndexFileVersion ||
+        header.byte_order_mark != kByteOrderMark ||
+        header.job_file_size != job_file_size ||
+        header.job_file_time != job_file_time ||
+        header.job_lut_position != job_lut_position ||
+        header.num_work_planes > (uint64_t)std::numeric_limits<int>::max() ||
+        header.num_vector_blocks > (uint64_t)std::numeric_limits<uint32_t>::max())
+    {
+        return {};
+    }
+
+    const uint64_t expected_size = sizeof(AttributeIndexFileHeader)
+        + (header.num_work_planes + 1) * sizeof(uint32_t)
+        + header.num_vector_blocks * sizeof(VectorBlockAttributes);
+    if (index_file_size != expected_size)
+        return {};
+
+    AttributeIndex index{};
+    index.first_vector_blocks_.resize(header.num_work_planes + 1);
+    index.attributes_.resize(header.num_vector_blocks);
+
+    if (!ifs.read((char*)index.first_vector_blocks_.data(), index.first_vector_blocks_.size() * sizeof(uint32_t)) ||
+        !ifs.read((char*)index.attributes_.data(), index.attributes_.size() * sizeof(VectorBlockAttributes)))
+    {
+        return {};
+    }
+
+    // lookups rely on the vector block ranges of the work planes
+    if (index.first_vector_blocks_.front() != 0 || index.first_vector_blocks_.back() != header.num_vector_blocks ||
+        !std::is_sorted(index.first_vector_blocks_.begin(), index.first_vector_blocks_.end()))
+    {
+        return {};
+    }
+
+    index.BuildPostingLists();
+    return std::optional<AttributeIndex>{std::move(index)};
+}
+
+void AttributeIndex::Save(const std::string& job_path, const uint64_t job_lut_position) const
+{
+    AttributeIndexFileHeader header{};
+    std::copy(kAttributeIndexMagicBytes.begin(), kAttributeIndexMagicBytes.end(), header.magic);
+    header.version = kAttributeIndexFileVersion;
+    header.byte_order_mark = kByteOrderMark;
+    header.job_lut_position = job_lut_position;
+    header.num_work_planes = (uint64_t)num_work_planes();
+    header.num_vector_blocks = (uint64_t)attributes_.size();
+
+    if (!util::GetFileStamp(job_path, header.job_file_size, header.job_file_time))
+        throw std::runtime_error("Querying size and modification time of file \"" + job_path + "\" failed");
+
+    const std::string index_path = job_path + kAttributeIndexFileExtension;
+    const std::string temp_path = index_path + ".tmp";
+    {
+        std::ofstream ofs{temp_path, std::ios::binary | std::ios::trunc};
+
+        ofs.write((const char*)&header, sizeof(header));
+        ofs.write((const char*)first_vector_blocks_.data(), first_vector_blocks_.size() * sizeof(uint32_t));
+        ofs.write((const char*)attributes_.data(), attributes_.size() * sizeof(VectorBlockAttributes));
+        ofs.close();
+
+        if (!ofs)
+        {
+            std::error_code ec;
+            std::filesystem::remove(temp_path, ec);
+            throw std::runtime_error("Writing attribute index file \"" + index_path + "\" failed");
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, index_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        throw std::runtime_error("Writing attribute index file \"" + index_path + "\" failed");
+    }
+}
+
+template <class VisitFn>
+void AttributeIndex::ForEachMatch(const VectorBlockFilter& filter, const uint32_t first, const uint32_t last, VisitFn visit) const
+{
+    // the shortest posting list of the attributes selected by, nullptr if none is selected by
+    const PostingList *shortest = nullptr;
+    const std::pair<const PostingLists*, std::optional<int32_t>> selections[] = {
+        {&by_laser_index_, filter.laser_index},
+        {&by_part_key_, filter.part_key},
+        {&by_vector_data_case_, filter.vector_data_case.has_value()
+            ? std::optional<int32_t>{(int32_t)*filter.vector_data_case}
+            : std::nullopt}
+    };
+    for (const auto& [lists, value] : selections)
+    {
+        if (!value.has_value())
+            continue;
+
+        auto it = lists->find(*value);
+        if (it == lists->end())
+            return;
+
+        if (shortest == nullptr || it->second.size() < shortest->size())
+            shortest = &it->second;
+    }
+
+    if (shortest == nullptr)
+    {
+        for (uint32_t number = first; number < last; number++)
+            visit(number);
+        return;
+    }
+
+    auto it = std::lower_bound(shortest->begin(), shortest->end(), first);
+    auto end = std::lower_bound(it, shortest->end(), last);
+    for (; it != end; ++it)
+    {
+        if (filter.Matches(attributes_[*it]))
+            visit(*it);
+    }
+}
+
+void AttributeIndex::Find(const VectorBlockFilter& filter, std::vector<VectorBlockLocation>& locations,
+    const int first_work_plane, const int num_work_planes) const
+{
+    const int end_work_plane = num_work_planes < 0 ? this->num_work_planes() : first_work_plane + num_work_planes;
+    if (first_work_plane < 0 || end_work_plane > this->num_work_planes() || end_work_plane < first_work_plane)
+        throw std::runtime_error("Invalid work plane range");
+
+    locations.clear();
+
+    // matches are visited in ascending order, so the work plane only moves forward
+    int i_work_plane = first_work_plane;
+    ForEachMatch(filter, first_vector_blocks_[first_work_plane], first_vector_blocks_[end_work_plane], [&](uint32_t number){
+        if (number >= first_vector_blocks_[i_work_plane + 1])
+        {
+            i_work_plane = (int)(std::upper_bound(
+                first_vector_blocks_.begin() + i_work_plane + 1,
+                first_vector_blocks_.begin() + end_work_plane + 1,
+                number) - first_vector_blocks_.begin()) - 1;
+        }
+        locations.push_back(VectorBlockLocation{i_work_plane, (int)(number - first_vector_blocks_[i_work_plane])});
+    });
+}
+
+void AttributeIndex::Find(const VectorBlockFilter& filter, const int i_work_plane, std::vector<int>& i_vector_blocks) const
+{
+    CheckWorkPlaneIndex(i_work_plane);
+
+    i_vector_blocks.clear();
+
+    const uint32_t first = first_vector_blocks_[i_work_plane];
+    ForEachMatch(filter, first, first_vector_blocks_[i_work_plane + 1], [&](uint32_t number){
+        i_vector_blocks.push_back((int)(number - first));
+    });
+}
+
+const VectorBlockAttributes& AttributeIndex::GetAttributes(const int i_work_plane, const int i_vector_block) const
+{
+    if (i_vector_block < 0 || i_vector_block > num_vector_blocks(i_work_plane) - 1)
+        throw std::runtime_error("Invalid vector block index");
+
+    return attributes_[first_vector_blocks_[i_work_plane] + i_vector_block];
+}
+
+size_t AttributeIndex::SpaceUsed() const
+{
+    size_t space = sizeof(*this)
+        + first_vector_blocks_.capacity() * sizeof(uint32_t)
+        + attributes_.capacity() * sizeof(VectorBlockAttributes);
+
+    for (const auto *lists : {&by_laser_index_, &by_part_key_, &by_vector_data_case_})
+    {
+        for (const auto& [value, list] : *lists)
+            space += sizeof(value) + sizeof(list) + list.capacity() * sizeof(uint32_t);
+    }
+
+    return space;
+}
+
+void AttributeIndex::BuildPostingLists()
+{
+    for (uint32_t number = 0; number < (uint32_t)attributes_.size(); number++)
+    {
+        const auto& attributes = attributes_[number];
+        by_laser_index_[attributes.laser_index].push_back(number);
+        by_part_key_[attributes.part_key].push_back(number);
+        by_vector_data_case_[attributes.vector_data_case].push_back(number);
+    }
+}
+
+std::vector<int32_t> AttributeIndex::SortedKeys(const PostingLists& lists)
+{
+    std::vector<int32_t> keys;
+    keys.reserve(lists.size());
+    for (const auto& entry : lists)
+        keys.push_back(entry.first);
+
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+}
\ No newline at end of file
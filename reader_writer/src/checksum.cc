@@ -0,0 +1,367 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OVF_CRC32C_SSE42
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#define OVF_CRC32C_ARMV8
+#include <arm_acle.h>
+#endif
+
+#include "checksum.h"
+#include "consts.h"
+#include "util.h"
+
+namespace open_vector_format::reader_writer {
+
+namespace {
+
+/** Reversed Castagnoli polynomial. */
+const uint32_t kCrc32cPolynomial = 0x82f63b78;
+
+/**
+ * @brief Lookup tables for slicing-by-8, table k advances the checksum by a byte followed by k zero bytes.
+ */
+using Crc32cTables = std::array<std::array<uint32_t, 256>, 8>;
+
+const Crc32cTables& GetCrc32cTables()
+{
+    static const Crc32cTables tables = [](){
+        Crc32cTables tables;
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++)
+                crc = (crc >> 1) ^ (kCrc32cPolynomial & (0u - (crc & 1)));
+            tables[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            for (size_t k = 1; k < tables.size(); k++)
+                tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xff];
+        }
+        return tables;
+    }();
+    return tables;
+}
+
+/** Software fallback, crc is passed and returned without the final inversion. */
+uint32_t Crc32cSoftware(const uint8_t *data, size_t size, uint32_t crc)
+{
+    const auto& t = GetCrc32cTables();
+
+    for (; size > 0 && reinterpret_cast<uintptr_t>(data) % 8 != 0; data++, size--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xff];
+
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint32_t low, high;
+        util::ReadFromLittleEndian(low, const_cast<uint8_t*>(data));
+        util::ReadFromLittleEndian(high, const_cast<uint8_t*>(data) + 4);
+        low ^= crc;
+        crc = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+              t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+    }
+
+    for (; size > 0; data++, size--)
+        crc = (crc >> 8) ^ t[0][(crc ^ *data) & 0xff];
+
+    return crc;
+}
+
+#if defined(OVF_CRC32C_SSE42)
+
+#ifdef _MSC_VER
+#define OVF_TARGET_SSE42
+#else
+#define OVF_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+
+OVF_TARGET_SSE42 uint32_t Crc32cHardware(const uint8_t *data, size_t size, uint32_t crc)
+{
+    for (; size > 0 && reinterpret_cast<uintptr_t>(data) % 8 != 0; data++, size--)
+        crc = _mm_crc32_u8(crc, *data);
+
+    uint64_t crc64 = crc;
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        crc64 = _mm_crc32_u64(crc64, value);
+    }
+    crc = (uint32_t)crc64;
+
+    for (; size > 0; data++, size--)
+        crc = _mm_crc32_u8(crc, *data);
+
+    return crc;
+}
+
+bool HasHardwareCrc32c()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 20)) != 0;
+#else
+    return __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+#elif defined(OVF_CRC32C_ARMV8)
+
+uint32_t Crc32cHardware(const uint8_t *data, size_t size, uint32_t crc)
+{
+    for (; size > 0 && reinterpret_cast<uintptr_t>(data) % 8 != 0; data++, size--)
+        crc = __crc32cb(crc, *data);
+
+    for (; size >= 8; data += 8, size -= 8)
+    {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        crc = __crc32cd(crc, value);
+    }
+
+    for (; size > 0; data++, size--)
+        crc = __crc32cb(crc, *data);
+
+    return crc;
+}
+
+bool HasHardwareCrc32c()
+{
+    return true;
+}
+
+#endif
+
+/**
+ * @brief Header of the checksum section, followed by the work plane and vector block checksums.
+ * 
+ * Stored field by field in little endian byte order, see ChecksumSection.
+ */
+struct ChecksumSectionHeader
+{
+    uint32_t version;
+    uint32_t algorithm;
+    uint32_t flags;
+    uint32_t job_checksum;
+    uint64_t num_work_planes;
+    uint64_t num_vector_blocks;
+};
+
+/**
+ * @brief Multiplies two polynomials modulo the Castagnoli polynomial, in reflected bit order.
+ */
+uint32_t MultiplyModP(uint32_t a, uint32_t b)
+{
+    uint32_t product = 0;
+    for (uint32_t m = 1u << 31; m != 0; m >>= 1)
+    {
+        if (a & m)
+            product ^= b;
+        b = (b >> 1) ^ (kCrc32cPolynomial & (0u - (b & 1)));
+    }
+    return product;
+}
+
+/**
+ * @brief Computes x^(8 * n) modulo the Castagnoli polynomial, the factor appending n zero bytes
+ * advances a checksum by.
+ */
+uint32_t ZeroBytesFactor(size_t n)
+{
+    // x^(2^k) for k = 0..63, by repeated squaring of x
+    static const std::array<uint32_t, 64> powers = [](){
+        std::array<uint32_t, 64> powers;
+        uint32_t power = 1u << 30;
+        for (auto& p : powers)
+        {
+            p = power;
+            power = MultiplyModP(power, power);
+        }
+        return powers;
+    }();
+
+    uint32_t factor = 1u << 31;
+    for (size_t k = 3; n != 0; n >>= 1, k++)
+    {
+        if (n & 1)
+            factor = MultiplyModP(powers[k], factor);
+    }
+    return factor;
+}
+
+const size_t kSectionHeaderSize = 4 + 4 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+
+const uint32_t kChecksumAlgorithmCrc32c = 1;
+const uint32_t kFlagVectorBlockChecksums = 1;
+
+}
+
+uint32_t Crc32c(const uint8_t *data, size_t size, uint32_t crc)
+{
+#if defined(OVF_CRC32C_SSE42) || defined(OVF_CRC32C_ARMV8)
+    static const bool has_hardware_crc32c = HasHardwareCrc32c();
+    if (has_hardware_crc32c)
+        return ~Crc32cHardware(data, size, ~crc);
+#endif
+
+    return ~Crc32cSoftware(data, size, ~crc);
+}
+
+uint32_t Crc32cCombine(const uint32_t first_crc, const uint32_t second_crc, const size_t second_size)
+{
+    return MultiplyModP(ZeroBytesFactor(second_size), first_crc) ^ second_crc;
+}
+
+std::string ChecksumSection::Serialize(const uint64_t section_position) const
+{
+    const size_t num_values = work_plane_checksums.size() + num_vector_blocks.size() + vector_block_checksums.size();
+    std::string buffer(kSectionHeaderSize + num_values * sizeof(uint32_t) + kTrailerSize, '\0');
+    uint8_t *out = reinterpret_cast<uint8_t*>(buffer.data());
+
+    std::copy(kChecksumMagicBytes.begin(), kChecksumMagicBytes.end(), out);
+    out += kChecksumMagicBytes.size();
+    out = util::WriteAsLittleEndian(kChecksumSectionVersion, out);
+    out = util::WriteAsLittleEndian(kChecksumAlgorithmCrc32c, out);
+    out = util::WriteAsLittleEndian(has_vector_block_checksums ? kFlagVectorBlockChecksums : 0u, out);
+    out = util::WriteAsLittleEndian(job_checksum, out);
+    out = util::WriteAsLittleEndian((uint64_t)work_plane_checksums.size(), out);
+    out = util::WriteAsLittleEndian((uint64_t)vector_block_checksums.size(), out);
+
+    for (const uint32_t checksum : work_plane_checksums)
+        out = util::WriteAsLittleEndian(checksum, out);
+    for (const uint32_t count : num_vector_blocks)
+        out = util::WriteAsLittleEndian(count, out);
+    for (const uint32_t checksum : vector_block_checksums)
+        out = util::WriteAsLittleEndian(checksum, out);
+
+    const uint32_t section_checksum = Crc32c(reinterpret_cast<const uint8_t*>(buffer.data()), buffer.size() - kTrailerSize);
+    out = util::WriteAsLittleEndian(section_position, out);
+    out = util::WriteAsLittleEndian(section_checksum, out);
+    std::copy(kChecksumMagicBytes.begin(), kChecksumMagicBytes.end(), out);
+
+    return buffer;
+}
+
+std::optional<ChecksumSection> ChecksumSection::Read(const FileSource& source, const uint64_t min_position)
+{
+    const uint64_t file_size = source.file_size();
+    if (file_size < min_position + kTrailerSize)
+        return {};
+
+    const uint64_t trailer_position = file_size - kTrailerSize;
+    FileView trailer = source.CreateView(trailer_position, kTrailerSize);
+    uint8_t *in = const_cast<uint8_t*>(trailer.data());
+    if (!std::equal(kChecksumMagicBytes.begin(), kChecksumMagicBytes.end(), in + 12))
+        return {};
+
+    uint64_t section_position;
+    uint32_t section_checksum;
+    util::ReadFromLittleEndian(section_position, in);
+    util::ReadFromLittleEndian(section_checksum, in + 8);
+
+    if (section_position < min_position || section_position > trailer_position ||
+        trailer_position - section_position < kSectionHeaderSize)
+    {
+        throw std::runtime_error("Invalid checksum section position, file might be corrupted");
+    }
+
+    const size_t section_size = (size_t)(trailer_position - section_position);
+    FileView section = source.CreateView(section_position, section_size);
+    in = const_cast<uint8_t*>(section.data());
+    if (Crc32c(in, section_size) != section_checksum ||
+        !std::equal(kChecksumMagicBytes.begin(), kChecksumMagicBytes.end(), in))
+    {
+        throw std::runtime_error("Checksum section is corrupted");
+    }
+    in += kChecksumMagicBytes.size();
+
+    ChecksumSectionHeader header;
+    util::ReadFromLittleEndian(header.version, in);
+    util::ReadFromLittleEndian(header.algorithm, in + 4);
+    util::ReadFromLittleEndian(header.flags, in + 8);
+    util::ReadFromLittleEndian(header.job_checksum, in + 12);
+    util::ReadFromLittleEndian(header.num_work_planes, in + 16);
+    util::ReadFromLittleEndian(header.num_vector_blocks, in + 24);
+    in += kSectionHeaderSize - kChecksumMagicBytes.size();
+
+    if (header.version != kChecksumSectionVersion)
+        throw std::runtime_error("Unsupported checksum section version");
+    if (header.algorithm != kChecksumAlgorithmCrc32c)
+        throw std::runtime_error("Unsupported checksum algorithm");
+
+    const bool has_vector_block_checksums = (header.flags & kFlagVectorBlockChecksums) != 0;
+    const uint64_t num_values = has_vector_block_checksums
+        ? 2 * header.num_work_planes + header.num_vector_blocks
+        : header.num_work_planes;
+    if (header.num_work_planes > section_size || header.num_vector_blocks > section_size ||
+        (!has_vector_block_checksums && header.num_vector_blocks != 0) ||
+        kSectionHeaderSize + num_values * sizeof(uint32_t) != section_size)
+    {
+        throw std::runtime_error("Invalid checksum section size, file might be corrupted");
+    }
+
+    ChecksumSection checksums;
+    checksums.position = section_position;
+    checksums.job_checksum = header.job_checksum;
+    checksums.has_vector_block_checksums = has_vector_block_checksums;
+    checksums.work_plane_checksums.resize(header.num_work_planes);
+    if (has_vector_block_checksums)
+        checksums.num_vector_blocks.resize(header.num_work_planes);
+    checksums.vector_block_checksums.resize(header.num_vector_blocks);
+
+    for (auto *values : {&checksums.work_plane_checksums, &checksums.num_vector_blocks, &checksums.vector_block_checksums})
+    {
+        for (auto& value : *values)
+        {
+            util::ReadFromLittleEndian(value, in);
+            in += sizeof(uint32_t);
+        }
+    }
+
+    uint64_t total_vector_blocks = 0;
+    for (const uint32_t count : checksums.num_vector_blocks)
+        total_vector_blocks += count;
+    if (total_vector_blocks != header.num_vector_blocks)
+        throw std::runtime_error("Invalid number of vector block checksums, file might be corrupted");
+
+    return std::optional<ChecksumSection>{std::move(checksums)};
+}
+
+}
\ No newline at end of file
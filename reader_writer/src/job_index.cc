@@ -0,0 +1,214 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <limits>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+#include "job_index.h"
+#include "consts.h"
+#include "util.h"
+
+namespace open_vector_format::reader_writer {
+
+namespace {
+
+/**
+ * @brief Header of an index file.
+ * 
+ * Followed by the arrays of the index, see JobIndex. All values are stored in the byte
+ * order of the machine writing the file, index files written on a machine of another
+ * byte order are rejected by the byte order mark.
+ */
+struct IndexFileHeader
+{
+    uint8_t magic[4];
+    uint32_t version;
+    uint32_t byte_order_mark;
+    uint32_t reserved;
+    uint64_t job_file_size;
+    int64_t job_file_time;
+    uint64_t job_lut_position;
+    uint64_t num_work_planes;
+    uint64_t num_vector_blocks;
+};
+
+static_assert(sizeof(IndexFileHeader) % sizeof(uint64_t) == 0, "Index arrays must be aligned");
+
+const uint32_t kByteOrderMark = 0x01020304;
+
+}
+
+std::optional<JobIndex> JobIndex::Load(const std::string& job_path, const uint64_t job_lut_position)
+{
+    const std::string index_path = job_path + kIndexFileExtension;
+
+    std::error_code ec;
+    if (!std::filesystem::exists(index_path, ec))
+        return {};
+
+    uint64_t job_file_size;
+    int64_t job_file_time;
+    if (!util::GetFileStamp(job_path, job_file_size, job_file_time))
+        return {};
+
+    try
+    {
+        // index files are small compared to their jobs, map them as a whole
+        MappingOptions options{};
+        options.address_space_budget = 0;
+        auto mapping = std::make_shared<MemoryMapping>(index_path, options);
+
+        if (mapping->file_size() < sizeof(IndexFileHeader))
+            return {};
+
+        auto view = mapping->CreateView(0, mapping->file_size());
+
+        IndexFileHeader header;
+        std::memcpy(&header, view.data(), sizeof(header));
+
+        if (!std::equal(kIndexMagicBytes.begin(), kIndexMagicBytes.end(), header.magic) ||
+            header.version != kIndexFileVersion ||
+            header.byte_order_mark != kByteOrderMark ||
+            header.job_file_size != job_file_size ||
+            header.job_file_time != job_file_time ||
+            header.job_lut_position != job_lut_position ||
+            header.num_work_planes > (uint64_t)std::numeric_limits<int>::max())
+        {
+            return {};
+        }
+
+        const int num_wps = (int)header.num_work_planes;
+        const size_t table_size = 3 * (size_t)num_wps + 2;
+        if (header.num_vector_blocks > (mapping->file_size() - sizeof(IndexFileHeader)) / sizeof(uint64_t) ||
+            mapping->file_size() != sizeof(IndexFileHeader) + (table_size + header.num_vector_blocks) * sizeof(uint64_t))
+        {
+            return {};
+        }
+
+        const uint64_t *table = reinterpret_cast<const uint64_t*>(view.data() + sizeof(IndexFileHeader));
+
+        JobIndex index{};
+        index.SetTables(table, num_wps);
+        index.vector_block_positions_ = Span<const uint64_t>{table + table_size, (size_t)header.num_vector_blocks};
+
+        // lookups rely on the vector block ranges
+        for (int i = 0; i < num_wps; i++)
+        {
+            if (index.first_vector_blocks_[i] > index.first_vector_blocks_[i + 1])
+                return {};
+        }
+        if (index.first_vector_blocks_[0] != 0 || index.first_vector_blocks_[num_wps] != header.num_vector_blocks)
+            return {};
+
+        // reads use the positions as offsets into views of their work plane, so vector blocks and
+        // shells have to lie within their work plane, after its lut offset and in file order, and
+        // the job shell before the job lut. Otherwise, the luts of the job are read instead.
+        if (index.job_shell_position() >= job_lut_position || job_lut_position >= job_file_size)
+            return {};
+        for (int i = 0; i < num_wps; i++)
+        {
+            const uint64_t wp_position = index.work_plane_positions_[i];
+            const uint64_t wp_end = index.work_plane_positions_[i + 1];
+            if (wp_end < wp_position || wp_end - wp_position < sizeof(int64_t))
+                return {};
+
+            const uint64_t shell_position = index.shell_positions_[i];
+            if (shell_position < wp_position + sizeof(int64_t) || shell_position >= wp_end)
+                return {};
+
+            uint64_t min_position = wp_position + sizeof(int64_t);
+            for (uint64_t i_vb = index.first_vector_blocks_[i]; i_vb < index.first_vector_blocks_[i + 1]; i_vb++)
+            {
+                const uint64_t vb_position = index.vector_block_positions_[i_vb];
+                if (vb_position < min_position || vb_position >= shell_position)
+                    return {};
+                min_position = vb_position;
+            }
+        }
+
+        index.is_fully_indexed_ = true;
+        index.index_file_ = std::move(mapping);
+        index.index_file_view_.emplace(std::move(view));
+
+        return std::optional<JobIndex>{std::move(index)};
+    }
+    catch (const std::runtime_error&)
+    {
+        return {};
+    }
+}
+
+void JobIndex::Save(const std::string& job_path, const uint64_t job_lut_position) const
+{
+    if (!is_fully_indexed_)
+        throw std::runtime_error("Saving an index requires all work planes to be indexed");
+
+    IndexFileHeader header{};
+    std::copy(kIndexMagicBytes.begin(), kIndexMagicBytes.end(), header.magic);
+    header.version = kIndexFileVersion;
+    header.byte_order_mark = kByteOrderMark;
+    header.job_lut_position = job_lut_position;
+    header.num_work_planes = (uint64_t)num_work_planes();
+    header.num_vector_blocks = (uint64_t)vector_block_positions_.size();
+
+    if (!util::GetFileStamp(job_path, header.job_file_size, header.job_file_time))
+        throw std::runtime_error("Querying size and modification time of file \"" + job_path + "\" failed");
+
+    const std::string index_path = job_path + kIndexFileExtension;
+    const std::string temp_path = index_path + ".tmp";
+    {
+        std::ofstream ofs{temp_path, std::ios::binary | std::ios::trunc};
+
+        // the work plane, first vector block and shell position arrays are contiguous
+        ofs.write((const char*)&header, sizeof(header));
+        ofs.write((const char*)work_plane_positions_.data(), (3 * (size_t)num_work_planes() + 2) * sizeof(uint64_t));
+        ofs.write((const char*)vector_block_positions_.data(), vector_block_positions_.size() * sizeof(uint64_t));
+        ofs.close();
+
+        if (!ofs)
+        {
+            std::error_code ec;
+            std::filesystem::remove(temp_path, ec);
+            throw std::runtime_error("Writing index file \"" + index_path + "\" failed");
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, index_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        throw std::runtime_error("Writing index file \"" + index_path + "\" failed");
+    }
+}
+
+}
\ No newline at end of file
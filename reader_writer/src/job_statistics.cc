@@ -0,0 +1,495 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define OVF_HAS_SSE2
+#endif
+
+#include "job_statistics.h"
+
+namespace open_vector_format::reader_writer {
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+/**
+ * @brief Scalar kernel of PolylineLength(), also used for the remainder of the SIMD kernel.
+ */
+double PolylineLengthScalar(const float *points, const size_t num_points, const int dimensions)
+{
+    double length = 0.0;
+    for (size_t i = 1; i < num_points; i++)
+    {
+        const float *a = points + (i - 1) * dimensions;
+        const float *b = a + dimensions;
+        double squared = 0.0;
+        for (int d = 0; d < dimensions; d++)
+            squared += (double)(b[d] - a[d]) * (b[d] - a[d]);
+        length += std::sqrt(squared);
+    }
+    return length;
+}
+
+/**
+ * @brief Scalar kernel of HatchLength(), also used for the remainder of the SIMD kernel.
+ */
+double HatchLengthScalar(const float *points, const size_t num_hatches, const int dimensions)
+{
+    double length = 0.0;
+    for (size_t i = 0; i < num_hatches; i++)
+        length += PolylineLengthScalar(points + 2 * i * dimensions, 2, dimensions);
+    return length;
+}
+
+#ifdef OVF_HAS_SSE2
+
+/**
+ * @brief Adds the lengths of 4 vectors, given as the 2D differences of their end points, to an accumulator.
+ * 
+ * The lengths are computed in single precision, but accumulated in double precision, so that
+ * long polylines don't lose precision.
+ */
+inline void AccumulateLengths2D(const __m128 d0, const __m128 d1, __m128d& sum)
+{
+    const __m128 squared0 = _mm_mul_ps(d0, d0);  // dx0² dy0² dx1² dy1²
+    const __m128 squared1 = _mm_mul_ps(d1, d1);  // dx2² dy2² dx3² dy3²
+    const __m128 lengths = _mm_sqrt_ps(_mm_add_ps(
+        _mm_shuffle_ps(squared0, squared1, _MM_SHUFFLE(2, 0, 2, 0)),
+        _mm_shuffle_ps(squared0, squared1, _MM_SHUFFLE(3, 1, 3, 1))
+    ));
+    sum = _mm_add_pd(sum, _mm_add_pd(_mm_cvtps_pd(lengths), _mm_cvtps_pd(_mm_movehl_ps(lengths, lengths))));
+}
+
+inline double HorizontalSum(const __m128d sum)
+{
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, sum);
+    return lanes[0] + lanes[1];
+}
+
+/**
+ * @brief SIMD kernel for the length of a 2D polyline, processing 4 segments per iteration.
+ * 
+ * @return size_t The number of segments processed.
+ */
+size_t PolylineLength2D(const float *points, const size_t num_points, double& length)
+{
+    __m128d sum = _mm_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 5 <= num_points; i += 4)
+    {
+        const float *p = points + 2 * i;
+        const __m128 d0 = _mm_sub_ps(_mm_loadu_ps(p + 2), _mm_loadu_ps(p));  // segments i, i + 1
+        const __m128 d1 = _mm_sub_ps(_mm_loadu_ps(p + 6), _mm_loadu_ps(p + 4));  // segments i + 2, i + 3
+        AccumulateLengths2D(d0, d1, sum);
+    }
+
+    length = HorizontalSum(sum);
+    return i;
+}
+
+/**
+ * @brief SIMD kernel for the length of 2D hatches, processing 4 hatches per iteration.
+ * 
+ * @return size_t The number of hatches processed.
+ */
+size_t HatchLength2D(const float *points, const size_t num_hatches, double& length)
+{
+    __m128d sum = _mm_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 4 <= num_hatches; i += 4)
+    {
+        const float *p = points + 4 * i;
+        const __m128 a = _mm_loadu_ps(p);       // start and end of hatch i
+        const __m128 b = _mm_loadu_ps(p + 4);   // start and end of hatch i + 1
+        const __m128 c = _mm_loadu_ps(p + 8);
+        const __m128 e = _mm_loadu_ps(p + 12);
+        const __m128 d0 = _mm_sub_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 2, 3, 2)), _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 1, 0)));
+        const __m128 d1 = _mm_sub_ps(_mm_shuffle_ps(c, e, _MM_SHUFFLE(3, 2, 3, 2)), _mm_shuffle_ps(c, e, _MM_SHUFFLE(1, 0, 1, 0)));
+        AccumulateLengths2D(d0, d1, sum);
+    }
+
+    length = HorizontalSum(sum);
+    return i;
+}
+
+#endif
+
+/**
+ * @brief Total length of the segments between consecutive points.
+ */
+double PolylineLength(Span<const float> points, const int dimensions)
+{
+    const size_t num_points = points.size() / dimensions;
+    double length = 0.0;
+    size_t processed = 0;
+
+#ifdef OVF_HAS_SSE2
+    if (dimensions == 2)
+        processed = PolylineLength2D(points.data(), num_points, length);
+#endif
+
+    // the remaining segments start at the last point processed
+    return length + PolylineLengthScalar(points.data() + processed * dimensions, num_points - processed, dimensions);
+}
+
+/**
+ * @brief Total length of the lines between pairs of points, i.e. of hatches.
+ */
+double HatchLength(const float *points, const size_t num_hatches, const int dimensions)
+{
+    double length = 0.0;
+    size_t processed = 0;
+
+#ifdef OVF_HAS_SSE2
+    if (dimensions == 2)
+        processed = HatchLength2D(points, num_hatches, length);
+#endif
+
+    return length + HatchLengthScalar(points + 2 * processed * dimensions, num_hatches - processed, dimensions);
+}
+
+/**
+ * @brief Reports whether the vector data consists of points, like VectorBlockView::has_points().
+ */
+bool HasPoints(const VectorBlock::VectorDataCase vector_data_case)
+{
+    switch (vector_data_case)
+    {
+        case VectorBlock::kLineSequence:
+        case VectorBlock::kHatches:
+        case VectorBlock::kPointSequence:
+        case VectorBlock::kLineSequence3D:
+        case VectorBlock::kHatches3D:
+        case VectorBlock::kPointSequence3D:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief The coordinates of the points of a vector block message, empty for vector data without points.
+ */
+Span<const float> GetPoints(const VectorBlock& vb, int& dimensions)
+{
+    const google::protobuf::RepeatedField<float> *points = nullptr;
+    dimensions = 2;
+    switch (vb.vector_data_case())
+    {
+        case VectorBlock::kLineSequence: points = &vb.line_sequence().points(); break;
+        case VectorBlock::kHatches: points = &vb._hatches().points(); break;
+        case VectorBlock::kPointSequence: points = &vb.point_sequence().points(); break;
+        case VectorBlock::kLineSequence3D: points = &vb.line_sequence_3d().points(); dimensions = 3; break;
+        case VectorBlock::kHatches3D: points = &vb._hatches3d().points(); dimensions = 3; break;
+        case VectorBlock::kPointSequence3D: points = &vb.point_sequence_3d().points(); dimensions = 3; break;
+        default: return {};
+    }
+    return Span<const float>{points->data(), (size_t)points->size()};
+}
+
+}
+
+void GeometryStatistics::Merge(const GeometryStatistics& other)
+{
+    num_vector_blocks += other.num_vector_blocks;
+    num_points += other.num_points;
+    num_vectors += other.num_vectors;
+    mark_length_in_mm += other.mark_length_in_mm;
+    jump_length_in_mm += other.jump_length_in_mm;
+    mark_time_in_s += other.mark_time_in_s;
+    jump_time_in_s += other.jump_time_in_s;
+    pause_time_in_s += other.pause_time_in_s;
+    unestimated_length_in_mm += other.unestimated_length_in_mm;
+    bounds.Extend(other.bounds);
+}
+
+double WorkPlaneStatistics::estimated_time_in_s() const
+{
+    double time = 0.0;
+    for (const auto& laser : lasers)
+        time = std::max(time, laser.total_time_in_s());
+    return time;
+}
+
+double JobStatistics::load_balance() const
+{
+    double max_time = 0.0, sum_time = 0.0;
+    for (const auto& laser : lasers)
+    {
+        max_time = std::max(max_time, laser.total_time_in_s());
+        sum_time += laser.total_time_in_s();
+    }
+
+    return max_time > 0.0 ? sum_time / lasers.size() / max_time : 1.0;
+}
+
+WorkPlaneStatisticsBuilder::WorkPlaneStatisticsBuilder(const google::protobuf::Map<int32_t, MarkingParams>& marking_params_map,
+    const int work_plane_repeats)
+    : marking_params_map_{marking_params_map},
+      passes_{1.0 + std::max(0, work_plane_repeats)}
+{
+}
+
+void WorkPlaneStatisticsBuilder::Add(const VectorBlockView& vb)
+{
+    if (!vb.has_points())
+    {
+        // arcs, ellipses and exposure pauses are rare, parsing them does not pay off to avoid
+        VectorBlock parsed{};
+        vb.Parse(parsed);
+        Add(parsed);
+        return;
+    }
+
+    AddPoints(vb.vector_data_case(), vb.points(), vb.point_dimensions(), vb.marking_params_key(), vb.laser_index(), vb.repeats());
+}
+
+void WorkPlaneStatisticsBuilder::Add(const VectorBlock& vb)
+{
+    if (HasPoints(vb.vector_data_case()))
+    {
+        int dimensions;
+        auto points = GetPoints(vb, dimensions);
+        AddPoints(vb.vector_data_case(), points, dimensions, vb.marking_params_key(), vb.laser_index(), vb.repeats());
+        return;
+    }
+
+    auto& laser = GetLaser(vb.laser_index());
+    auto& statistics = laser.statistics;
+    statistics.num_vector_blocks++;
+
+    const double passes = passes_ * (1.0 + (double)vb.repeats());
+    switch (vb.vector_data_case())
+    {
+        case VectorBlock::kArcs:
+        {
+            const auto& arcs = vb._arcs();
+            const size_t num_arcs = (size_t)arcs.centers_size() / 2;
+            statistics.num_points += num_arcs;
+            statistics.num_vectors += num_arcs;
+            if (num_arcs == 0)
+                break;
+
+            Span<const float> centers{arcs.centers().data(), 2 * num_arcs};
+            statistics.bounds.Extend(ComputePointBounds(centers, 2));
+
+            // all arcs share the angle and the offset of their start from their center
+            const double angle = arcs.angle() * kPi / 180.0;
+            const double radius = std::hypot((double)arcs.start_dx(), (double)arcs.start_dy());
+            const double end_dx = arcs.start_dx() * std::cos(angle) - arcs.start_dy() * std::sin(angle);
+            const double end_dy = arcs.start_dx() * std::sin(angle) + arcs.start_dy() * std::cos(angle);
+
+            // jumps from the end of each arc to the start of the next one, repeated with the vector block
+            double jump_length = 0.0;
+            for (size_t i = 1; i < num_arcs; i++)
+            {
+                jump_length += std::hypot(
+                    (double)centers[2 * i] + arcs.start_dx() - (centers[2 * i - 2] + end_dx),
+                    (double)centers[2 * i + 1] + arcs.start_dy() - (centers[2 * i - 1] + end_dy));
+            }
+
+            jump_length *= passes;
+            jump_length += JumpFromLastPoint(laser,
+                (float)(centers[0] + arcs.start_dx()), (float)(centers[1] + arcs.start_dy()),
+                (float)(centers[2 * num_arcs - 2] + end_dx), (float)(centers[2 * num_arcs - 1] + end_dy));
+
+            AddGeometry(laser, vb.marking_params_key(), passes * radius * std::abs(angle) * num_arcs, jump_length);
+            break;
+        }
+        case VectorBlock::kArcs3D:
+        case VectorBlock::kEllipses:
+        {
+            // counted, but neither measured nor taken into account for jumps
+            const int dimensions = vb.vector_data_case() == VectorBlock::kArcs3D ? 3 : 2;
+            const auto& centers = vb.vector_data_case() == VectorBlock::kArcs3D ? vb.arcs_3d().centers() : vb.ellipses().centers();
+            const size_t num_centers = (size_t)centers.size() / dimensions;
+            statistics.num_points += num_centers;
+            statistics.num_vectors += num_centers;
+            statistics.bounds.Extend(ComputePointBounds(Span<const float>{centers.data(), num_centers * dimensions}, dimensions));
+            break;
+        }
+        case VectorBlock::kExposurePause:
+            statistics.pause_time_in_s += passes * (double)vb.exposure_pause().pause_in_us() * 1e-6;
+            break;
+        default:
+            break;
+    }
+}
+
+WorkPlaneStatistics WorkPlaneStatisticsBuilder::Finish() const
+{
+    WorkPlaneStatistics result{};
+    result.lasers.reserve(lasers_.size());
+    for (const auto& laser : lasers_)
+    {
+        result.lasers.push_back(laser.statistics);
+        result.total.Merge(laser.statistics);
+    }
+    return result;
+}
+
+WorkPlaneStatisticsBuilder::LaserState& WorkPlaneStatisticsBuilder::GetLaser(const int32_t laser_index)
+{
+    // few lasers, kept sorted for the report
+    auto it = std::lower_bound(lasers_.begin(), lasers_.end(), laser_index,
+        [](const LaserState& laser, int32_t index){ return laser.statistics.laser_index < index; });
+
+    if (it == lasers_.end() || it->statistics.laser_index != laser_index)
+    {
+        it = lasers_.insert(it, LaserState{});
+        it->statistics.laser_index = laser_index;
+    }
+    return *it;
+}
+
+void WorkPlaneStatisticsBuilder::AddPoints(const VectorBlock::VectorDataCase vector_data_case, Span<const float> points,
+    const int dimensions, const int32_t marking_params_key, const int32_t laser_index, const uint64_t repeats)
+{
+    auto& laser = GetLaser(laser_index);
+    auto& statistics = laser.statistics;
+    statistics.num_vector_blocks++;
+
+    const size_t num_points = points.size() / dimensions;
+    statistics.num_points += num_points;
+    if (num_points == 0)
+        return;
+
+    statistics.bounds.Extend(ComputePointBounds(Span<const float>{points.data(), num_points * dimensions}, dimensions));
+
+    double mark_length = 0.0, jump_length = 0.0;
+    switch (vector_data_case)
+    {
+        case VectorBlock::kLineSequence:
+        case VectorBlock::kLineSequence3D:
+            statistics.num_vectors += num_points - 1;
+            mark_length = PolylineLength(points, dimensions);
+            break;
+        case VectorBlock::kHatches:
+        case VectorBlock::kHatches3D:
+        {
+            // jumps from the end of each hatch to the start of the next one, which are hatches offset by a point
+            const size_t num_hatches = num_points / 2;
+            statistics.num_vectors += num_hatches;
+            mark_length = HatchLength(points.data(), num_hatches, dimensions);
+            jump_length = num_hatches > 1 ? HatchLength(points.data() + dimensions, num_hatches - 1, dimensions) : 0.0;
+            break;
+        }
+        default:
+            // points are exposed one by one, jumping in between
+            jump_length = PolylineLength(points, dimensions);
+            break;
+    }
+
+    const double passes = passes_ * (1.0 + (double)repeats);
+    const float *last_point = points.data() + (num_points - 1) * dimensions;
+    jump_length = passes * jump_length + JumpFromLastPoint(laser, points[0], points[1], last_point[0], last_point[1]);
+
+    AddGeometry(laser, marking_params_key, passes * mark_length, jump_length);
+}
+
+double WorkPlaneStatisticsBuilder::JumpFromLastPoint(LaserState& laser, const float first_x, const float first_y,
+    const float last_x, const float last_y) const
+{
+    // once per pass of the work plane, jumps back to the start of repeated vector blocks are not taken into account
+    const double jump_length = laser.has_last_point
+        ? passes_ * std::hypot((double)first_x - laser.last_x, (double)first_y - laser.last_y)
+        : 0.0;
+
+    laser.last_x = last_x;
+    laser.last_y = last_y;
+    laser.has_last_point = true;
+    return jump_length;
+}
+
+void WorkPlaneStatisticsBuilder::AddGeometry(LaserState& laser, const int32_t marking_params_key,
+    const double mark_length, const double jump_length)
+{
+    auto& statistics = laser.statistics;
+    statistics.mark_length_in_mm += mark_length;
+    statistics.jump_length_in_mm += jump_length;
+
+    auto params = marking_params_map_.find(marking_params_key);
+    const float mark_speed = params != marking_params_map_.end() ? params->second.laser_speed_in_mm_per_s() : 0.0f;
+    const float jump_speed = params != marking_params_map_.end() ? params->second.jump_speed_in_mm_s() : 0.0f;
+
+    if (mark_speed > 0.0f)
+        statistics.mark_time_in_s += mark_length / mark_speed;
+    else
+        statistics.unestimated_length_in_mm += mark_length;
+
+    if (jump_speed > 0.0f)
+        statistics.jump_time_in_s += jump_length / jump_speed;
+    else
+        statistics.unestimated_length_in_mm += jump_length;
+}
+
+WorkPlaneStatistics ComputeWorkPlaneStatistics(const WorkPlane& wp, const google::protobuf::Map<int32_t, MarkingParams>& marking_params_map)
+{
+    WorkPlaneStatisticsBuilder builder{marking_params_map, wp.repeats()};
+    for (const auto& vb : wp.vector_blocks())
+        builder.Add(vb);
+
+    return builder.Finish();
+}
+
+JobStatistics CombineWorkPlaneStatistics(std::vector<WorkPlaneStatistics> work_planes)
+{
+    JobStatistics result{};
+    for (const auto& wp : work_planes)
+    {
+        result.total.Merge(wp.total);
+        result.estimated_time_in_s += wp.estimated_time_in_s();
+
+        for (const auto& laser : wp.lasers)
+        {
+            auto it = std::lower_bound(result.lasers.begin(), result.lasers.end(), laser.laser_index,
+                [](const LaserStatistics& existing, int32_t index){ return existing.laser_index < index; });
+
+            if (it == result.lasers.end() || it->laser_index != laser.laser_index)
+            {
+                it = result.lasers.insert(it, LaserStatistics{});
+                it->laser_index = laser.laser_index;
+            }
+            it->Merge(laser);
+        }
+    }
+
+    result.work_planes = std::move(work_planes);
+    return result;
+}
+
+}
\ No newline at end of file
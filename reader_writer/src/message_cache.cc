@@ -0,0 +1,123 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include "message_cache.h"
+
+namespace open_vector_format::reader_writer {
+
+MessageCache::MessageCache(size_t byte_budget)
+    : byte_budget_{byte_budget}
+{
+}
+
+std::shared_ptr<const google::protobuf::Message> MessageCache::Get(const int i_work_plane, const int i_vector_block)
+{
+    std::lock_guard lock{mutex_};
+
+    auto message = Find(MakeKey(i_work_plane, i_vector_block));
+    if (message != nullptr)
+        statistics_.hits++;
+    else
+        statistics_.misses++;
+
+    return message;
+}
+
+std::shared_ptr<const google::protobuf::Message> MessageCache::Peek(const int i_work_plane, const int i_vector_block)
+{
+    std::lock_guard lock{mutex_};
+
+    auto message = Find(MakeKey(i_work_plane, i_vector_block));
+    if (message != nullptr)
+        statistics_.hits++;
+
+    return message;
+}
+
+void MessageCache::Put(const int i_work_plane, const int i_vector_block, std::shared_ptr<const google::protobuf::Message> message)
+{
+    // measured outside of the lock, this walks the whole message
+    const size_t size_bytes = (size_t)message->SpaceUsedLong();
+    if (size_bytes > byte_budget_)
+        return;
+
+    std::lock_guard lock{mutex_};
+
+    const uint64_t key = MakeKey(i_work_plane, i_vector_block);
+    auto existing = index_.find(key);
+    if (existing != index_.end())
+    {
+        // decoded concurrently by another reader, keep the cached one
+        entries_.splice(entries_.begin(), entries_, existing->second);
+        return;
+    }
+
+    entries_.push_front(Entry{key, std::move(message), size_bytes});
+    index_.emplace(key, entries_.begin());
+    statistics_.size_bytes += size_bytes;
+
+    while (statistics_.size_bytes > byte_budget_)
+    {
+        auto& lru = entries_.back();
+        statistics_.size_bytes -= lru.size_bytes;
+        statistics_.evictions++;
+        index_.erase(lru.key);
+        entries_.pop_back();
+    }
+
+    statistics_.num_entries = entries_.size();
+}
+
+void MessageCache::Clear()
+{
+    std::lock_guard lock{mutex_};
+
+    entries_.clear();
+    index_.clear();
+    statistics_.num_entries = 0;
+    statistics_.size_bytes = 0;
+}
+
+CacheStatistics MessageCache::GetStatistics() const
+{
+    std::lock_guard lock{mutex_};
+    return statistics_;
+}
+
+std::shared_ptr<const google::protobuf::Message> MessageCache::Find(const uint64_t key)
+{
+    auto it = index_.find(key);
+    if (it == index_.end())
+        return nullptr;
+
+    // move to the front, i.e. most recently used
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->message;
+}
+
+}
\ No newline at end of file
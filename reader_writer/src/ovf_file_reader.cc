@@ -31,51 +31,322 @@ SOFTWARE.
 #include <fstream>
 #include <algorithm>
 #include <mutex>
-#include <shared_mutex>
+#include <limits>
+#include <numeric>
+#include <vector>
 
 #include "google/protobuf/util/delimited_message_util.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
 
 #include "ovf_file_reader.h"
 #include "open_vector_format.pb.h"
 #include "consts.h"
 #include "util.h"
 
-#if (defined WIN32 || defined _WIN32)
-#  include "memory_mapping_win32.h"
-#else
-#  error POSIX
-#endif
+#include "memory_mapping.h"
+#include "buffered_file.h"
 
 namespace open_vector_format::reader_writer {
 
+namespace {
+
+// verification states of the work planes, see OpenedFile::work_plane_verification
+const uint8_t kNotVerified = 0;
+const uint8_t kIntact = 1;
+const uint8_t kCorrupted = 2;
+
+/**
+ * @brief Parses a length delimited message from a memory region.
+ * 
+ * The region may be longer than the message itself. As the message is delimited,
+ * it is cut to the range protobuf streams can address.
+ * 
+ * @throws std::runtime_error The message could not be parsed.
+ */
+void ParseDelimitedFromArray(google::protobuf::MessageLite& message, const uint8_t *data, size_t size)
+{
+    google::protobuf::io::ArrayInputStream zcs{
+        data,
+        (int)std::min<size_t>(size, std::numeric_limits<int>::max())
+    };
+    if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(&message, &zcs, nullptr))
+        throw std::runtime_error("Parsing " + message.GetTypeName() + " failed, file might be corrupted");
+}
+
+/**
+ * @brief Parses a length delimited vector block from a memory region, except for its vector data.
+ * 
+ * The vector data is skipped on the wire, only its type is kept as an empty message. All
+ * other fields are parsed as usual, so fields added to the format are kept as well.
+ * 
+ * @throws std::runtime_error The vector block could not be parsed.
+ */
+void ParseVectorBlockHeaderFromArray(VectorBlock& vb, const uint8_t *data, size_t size)
+{
+    using google::protobuf::internal::WireFormatLite;
+
+    google::protobuf::io::CodedInputStream input{
+        data,
+        (int)std::min<size_t>(size, std::numeric_limits<int>::max())
+    };
+
+    uint32_t length;
+    if (!input.ReadVarint32(&length) || (int)length > input.BytesUntilLimit())
+        throw std::runtime_error("Parsing VectorBlock failed, file might be corrupted");
+    input.PushLimit((int)length);
+
+    // merges the fields in [start, end) of data, skipping over the vector data in between
+    auto merge_fields = [&](int start, int end){
+        if (start == end)
+            return;
+
+        google::protobuf::io::CodedInputStream fields{data + start, end - start};
+        if (!vb.MergePartialFromCodedStream(&fields) || !fields.ConsumedEntireMessage())
+            throw std::runtime_error("Parsing VectorBlock failed, file might be corrupted");
+    };
+
+    int fields_start = input.CurrentPosition();
+    while (true)
+    {
+        const int field_start = input.CurrentPosition();
+        const uint32_t tag = input.ReadTag();
+        if (tag == 0)
+            break;
+
+        const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+        bool ok;
+        if (WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED && util::IsVectorDataField(field_number))
+        {
+            merge_fields(fields_start, field_start);
+
+            uint32_t data_length;
+            ok = input.ReadVarint32(&data_length) && input.Skip((int)data_length);
+            fields_start = input.CurrentPosition();
+
+            // keeps the type of vector data, oneof case values equal the field numbers
+            vb.GetReflection()->MutableMessage(&vb, VectorBlock::descriptor()->FindFieldByNumber(field_number))->Clear();
+        }
+        else
+        {
+            ok = WireFormatLite::SkipField(&input, tag);
+        }
+
+        if (!ok)
+            throw std::runtime_error("Parsing VectorBlock failed, file might be corrupted");
+    }
+
+    if (!input.ConsumedEntireMessage())
+        throw std::runtime_error("Parsing VectorBlock failed, file might be corrupted");
+
+    merge_fields(fields_start, input.CurrentPosition());
+}
+
+/**
+ * @brief Scans the laser index, part key and vector data type of a length delimited vector block.
+ * 
+ * Only these fields are decoded on the wire, all others, including the vector data, are
+ * skipped. As when parsing, the last occurrence of a field wins.
+ * 
+ * @throws std::runtime_error The vector block could not be scanned.
+ */
+void ScanVectorBlockAttributesFromArray(VectorBlockAttributes& attributes, const uint8_t *data, size_t size)
+{
+    using google::protobuf::internal::WireFormatLite;
+
+    google::protobuf::io::CodedInputStream input{
+        data,
+        (int)std::min<size_t>(size, std::numeric_limits<int>::max())
+    };
+
+    uint32_t length;
+    if (!input.ReadVarint32(&length) || (int)length > input.BytesUntilLimit())
+        throw std::runtime_error("Scanning VectorBlock failed, file might be corrupted");
+    input.PushLimit((int)length);
+
+    attributes = VectorBlockAttributes{};
+    while (uint32_t tag = input.ReadTag())
+    {
+        const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+        const auto wire_type = WireFormatLite::GetTagWireType(tag);
+        bool ok;
+
+        if (wire_type == WireFormatLite::WIRETYPE_VARINT && field_number == VectorBlock::kLaserIndexFieldNumber)
+        {
+            uint64_t value;
+            ok = input.ReadVarint64(&value);
+            attributes.laser_index = (int32_t)value;
+        }
+        else if (wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED && field_number == VectorBlock::kMetaDataFieldNumber)
+        {
+            // repeated occurrences of the meta data are merged, so only a part key present overrides the previous one
+            uint32_t meta_data_length;
+            ok = input.ReadVarint32(&meta_data_length) && (int)meta_data_length <= input.BytesUntilLimit();
+            if (ok)
+            {
+                auto limit = input.PushLimit((int)meta_data_length);
+                while (ok)
+                {
+                    const uint32_t meta_data_tag = input.ReadTag();
+                    if (meta_data_tag == 0)
+                        break;
+
+                    if (meta_data_tag == WireFormatLite::MakeTag(VectorBlock::VectorBlockMetaData::kPartKeyFieldNumber, WireFormatLite::WIRETYPE_VARINT))
+                    {
+                        uint64_t value;
+                        ok = input.ReadVarint64(&value);
+                        attributes.part_key = (int32_t)value;
+                    }
+                    else
+                    {
+                        ok = WireFormatLite::SkipField(&input, meta_data_tag);
+                    }
+                }
+                ok = ok && input.ConsumedEntireMessage();
+                input.PopLimit(limit);
+            }
+        }
+        else
+        {
+            // oneof case values equal the field numbers
+            if (wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED && util::IsVectorDataField(field_number))
+                attributes.vector_data_case = field_number;
+
+            ok = WireFormatLite::SkipField(&input, tag);
+        }
+
+        if (!ok)
+            throw std::runtime_error("Scanning VectorBlock failed, file might be corrupted");
+    }
+
+    if (!input.ConsumedEntireMessage())
+        throw std::runtime_error("Scanning VectorBlock failed, file might be corrupted");
+}
+
+/**
+ * @brief Merges a vector block into another one, except for its vector data, see ParseVectorBlockHeaderFromArray().
+ */
+void MergeVectorBlockHeader(const VectorBlock& source, VectorBlock& target)
+{
+    util::MergeExcluding(
+        source,
+        target,
+        [](const google::protobuf::FieldDescriptor& fd){return util::IsVectorDataField(fd.number());}
+    );
+
+    if (source.vector_data_case() != VectorBlock::VECTOR_DATA_NOT_SET)
+        target.GetReflection()->MutableMessage(&target, VectorBlock::descriptor()->FindFieldByNumber(source.vector_data_case()));
+}
+
+/**
+ * @brief Opens a file with the I/O backend selected in the options.
+ */
+std::unique_ptr<FileSource> OpenFileSource(const std::string& path, const MappingOptions& mapping_options)
+{
+    if (mapping_options.io_backend == IoBackend::kBufferedRead)
+        return std::make_unique<BufferedFile>(path, mapping_options);
+
+    return std::make_unique<MemoryMapping>(path, mapping_options);
+}
+
+/**
+ * @brief Merges a work plane into another one, except for its vector blocks.
+ */
+void MergeWorkPlaneShell(const WorkPlane& source, WorkPlane& target)
+{
+    util::MergeExcluding(
+        source,
+        target,
+        [](const google::protobuf::FieldDescriptor& fd){return fd.number() == WorkPlane::kVectorBlocksFieldNumber;}
+    );
+}
+
+}
+
 
-OvfFileReader::OvfFileReader(size_t auto_cache_threshold)
-    : auto_cache_threshold_{auto_cache_threshold}
+OvfFileReader::OvfFileReader(size_t auto_cache_threshold, int num_cache_threads)
+    : auto_cache_threshold_{auto_cache_threshold},
+      num_cache_threads_{num_cache_threads > 0 ? num_cache_threads : std::max(1, (int)std::thread::hardware_concurrency())}
 {
 }
 
-void OvfFileReader::OpenFile(const std::string path, Job& job)
+OvfFileReader::~OvfFileReader()
 {
     CloseFile();
+}
+
+void OvfFileReader::OpenFile(const std::string path, Job& job, const MappingOptions& mapping_options, const LutLoading lut_loading)
+{
+    CloseFile();
+
+    OpenSourceImpl(path, OpenFileSource(path, mapping_options), job, lut_loading);
+}
+
+void OvfFileReader::OpenBuffer(Span<const uint8_t> buffer, Job& job, const LutLoading lut_loading)
+{
+    OpenSource(std::make_unique<MemoryBuffer>(buffer), job, lut_loading);
+}
+
+void OvfFileReader::OpenBuffer(std::vector<uint8_t>&& buffer, Job& job, const LutLoading lut_loading)
+{
+    OpenSource(std::make_unique<MemoryBuffer>(std::move(buffer)), job, lut_loading);
+}
+
+void OvfFileReader::OpenSource(std::unique_ptr<FileSource> source, Job& job, const LutLoading lut_loading)
+{
+    if (source == nullptr)
+        throw std::runtime_error("Can't open a file without a source");
+
+    CloseFile();
+
+    OpenSourceImpl(std::string{}, std::move(source), job, lut_loading);
+}
+
+void OvfFileReader::OpenSourceImpl(const std::string& path, std::unique_ptr<FileSource> source, Job& job, const LutLoading lut_loading)
+{
+    size_t file_size;
+    {
+        // another file might have been opened since closing the previous one
+        std::lock_guard threads_lock{threads_mutex_};
+        StopLoadingLUTs();
+
+        std::lock_guard lock{state_mutex_};
+
+        std::shared_ptr<const OpenedFile> file = OpenFileImpl(path, std::move(source), job, lut_loading);
+        file_size = file->source->file_size();
 
-    std::unique_lock lock{rwlock_};
+        if (lut_loading == LutLoading::kBackground)
+        {
+            is_lut_loader_stopped_ = false;
+            lut_loader_ = std::thread{&OvfFileReader::LoadWorkPlaneLUTs, this, file};
+        }
+
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->file = std::move(file);
+        snapshot_.Publish(std::move(snapshot));
+    }
+
+    if (file_size <= auto_cache_threshold_)
+    {
+        CacheFullJob();
+    }
+}
 
-    path_ = path;
-    mapping_.emplace(path);
+std::shared_ptr<OvfFileReader::OpenedFile> OvfFileReader::OpenFileImpl(const std::string& path, std::unique_ptr<FileSource> source, Job& job, const LutLoading lut_loading) const
+{
+    auto file = std::make_shared<OpenedFile>(path, std::move(source));
 
-    if (mapping_->file_size() < 12)
+    if (file->source->file_size() < 12)
     {
-        CloseFile();
-        throw std::runtime_error("File \"" + path + "\" is empty");
+        throw std::runtime_error(path.empty() ? "Buffer is empty" : "File \"" + path + "\" is empty");
     }
 
     int64_t job_lut_offset_raw;
     {
-        auto header_view = mapping_->CreateView(0, kMagicBytes.size() + 8);
+        auto header_view = file->source->CreateView(0, kMagicBytes.size() + 8);
         if (!std::equal(kMagicBytes.begin(), kMagicBytes.end(), header_view.data()))
         {
-            CloseFile();
             throw std::runtime_error("File does not appear to be an ovf file");
         }
 
@@ -90,296 +361,1127 @@ void OvfFileReader::OpenFile(const std::string path, Job& job)
 
     size_t job_lut_offset = (size_t)job_lut_offset_raw;
 
-    // read job lut
-    job_lut_ = JobLUT{};
+    // index files are kept next to job files, there is none for buffers
+    const bool use_index_file = lut_loading == LutLoading::kIndexFile && !path.empty();
+
+    if (use_index_file)
     {
-        auto job_lut_view = mapping_->CreateView(job_lut_offset, 0); // offset up until EOF
-        google::protobuf::io::ArrayInputStream zcs{job_lut_view.data(), (int)job_lut_view.size()};
-        google::protobuf::util::ParseDelimitedFromZeroCopyStream(
-            &*job_lut_,
-            &zcs,
-            nullptr
-        );
+        file->index = JobIndex::Load(path, job_lut_offset);
     }
 
-    // read work plane luts
-    wp_luts_.emplace(job_lut_->workplanepositions_size());
-    for (int i = 0; i < job_lut_->workplanepositions_size(); i++)
-    {
-        size_t wp_offset_abs;
-        auto wp_view = GetWorkPlaneFileView(i, &wp_offset_abs);
-        
-        int64_t wp_lut_offset_raw;
-        util::ReadFromLittleEndian(wp_lut_offset_raw, wp_view.data());
-        size_t wp_lut_offset_abs = (size_t)wp_lut_offset_raw;
-        size_t wp_lut_offset_local = wp_lut_offset_abs - wp_offset_abs;
-
-        google::protobuf::io::ArrayInputStream zcs{
-            wp_view.data() + wp_lut_offset_local,
-            (int)(wp_view.size() - wp_lut_offset_local)
-        };
-        google::protobuf::util::ParseDelimitedFromZeroCopyStream(
-            &wp_luts_.value()[i],
-            &zcs,
-            nullptr
-        );
+    // read job lut, work plane luts are indexed below or on first access
+    if (!file->index.has_value())
+    {
+        JobLUT job_lut{};
+        auto job_lut_view = file->source->CreateView(job_lut_offset, 0); // offset up until EOF
+        ParseDelimitedFromArray(job_lut, job_lut_view.data(), job_lut_view.size());
+        file->index.emplace(job_lut);
     }
 
     // read job shell
     job.Clear();
     {
-        auto job_shell_view = mapping_->CreateView((uint64_t)job_lut_->jobshellposition(), 0);
-        google::protobuf::io::ArrayInputStream zcs{job_shell_view.data(), (int)job_shell_view.size()};
-        google::protobuf::util::ParseDelimitedFromZeroCopyStream(
-            &job,
-            &zcs,
-            nullptr
-        );
+        auto job_shell_view = file->source->CreateView(file->index->job_shell_position(), 0);
+        ParseDelimitedFromArray(job, job_shell_view.data(), job_shell_view.size());
     }
+    file->job_shell = job;
 
-    job_shell_.emplace(job);
-    are_vector_blocks_cached_ = false;
+    if ((lut_loading == LutLoading::kEager || lut_loading == LutLoading::kIndexFile) && !file->index->is_fully_indexed())
+    {
+        file->index->IndexAll([&file](int i, WorkPlaneLUT& wpl){ LoadWorkPlaneLUT(*file, i, wpl); });
 
-    lock.unlock();
+        if (use_index_file)
+        {
+            try
+            {
+                file->index->Save(path, job_lut_offset);
+            }
+            catch (const std::runtime_error&)
+            {
+                // the index file only speeds up opening, e.g. the directory might be read-only
+            }
+        }
+    }
 
-    if (mapping_->file_size() > auto_cache_threshold_)
+    // bounding boxes and attributes are indexed on demand
+    file->spatial_index.emplace(file->index->num_work_planes());
+    file->job_lut_position = (uint64_t)job_lut_offset;
+    file->use_index_files = use_index_file;
+
+    file->checksums = ChecksumSection::Read(*file->source, job_lut_offset);
+    if (file->checksums.has_value())
     {
-        CacheFullJob();
+        if (file->checksums->work_plane_checksums.size() != (size_t)file->index->num_work_planes() ||
+            file->checksums->position < file->index->job_shell_position())
+        {
+            throw std::runtime_error("Checksum section does not match the job, file might be corrupted");
+        }
+
+        if (verify_on_first_read_)
+        {
+            file->work_plane_verification = std::make_unique<std::atomic<uint8_t>[]>(file->index->num_work_planes());
+            for (int i = 0; i < file->index->num_work_planes(); i++)
+                file->work_plane_verification[i] = kNotVerified;
+        }
     }
+
+    return file;
 }
 
-void OvfFileReader::CloseFile()
+void OvfFileReader::ShareFile(const OvfFileReader& other, Job& job)
 {
-    std::unique_lock lock{rwlock_};
+    auto snapshot = other.snapshot_.Get();
+    if (snapshot == nullptr)
+        throw std::runtime_error("Can't share a file without opening it first");
 
-    path_.reset();
-    mapping_.reset();
-    
-    job_shell_.reset();
-    job_lut_.reset();
-    wp_luts_.reset();
-    
-    cache_.reset();
-    are_vector_blocks_cached_.reset();
+    CloseFile();
+
+    job.CopyFrom(snapshot->file->job_shell);
+
+    // the recently used cache changes with every read, so each reader gets its own
+    if (snapshot->recently_used_cache != nullptr)
+    {
+        auto shared = std::make_shared<Snapshot>(*snapshot);
+        shared->recently_used_cache = std::make_shared<MessageCache>(snapshot->recently_used_cache->byte_budget());
+        snapshot = std::move(shared);
+    }
+
+    std::lock_guard lock{state_mutex_};
+    snapshot_.Publish(std::move(snapshot));
+}
+
+void OvfFileReader::CloseFile()
+{
+    std::lock_guard threads_lock{threads_mutex_};
+    StopCacheWarming();
+    StopSpatialIndexing();
+    StopLoadingLUTs();
+
+    // waits for reads in progress, the file is unmapped once no reader shares it anymore
+    std::lock_guard lock{state_mutex_};
+    snapshot_.Publish(nullptr);
 }
 
 bool OvfFileReader::IsFileOpen() const
 {
-    return mapping_.has_value();
+    return snapshot_.Read().get() != nullptr;
+}
+
+int OvfFileReader::GetNumWorkPlanes() const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    return snapshot->file->index->num_work_planes();
 }
 
 
 
 void OvfFileReader::GetWorkPlane(const int i_work_plane, WorkPlane& wp) const
 {
-    std::shared_lock lock{rwlock_};
-    CheckIsFileOpened();
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
 
-    GetWorkPlaneImpl(i_work_plane, wp, true);
+    GetWorkPlaneImpl(*snapshot, i_work_plane, wp, true);
 }
 
 void OvfFileReader::GetWorkPlaneShell(const int i_work_plane, WorkPlane& wp) const
 {
-    std::shared_lock lock{rwlock_};
-    CheckIsFileOpened();
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
     
-    GetWorkPlaneImpl(i_work_plane, wp, false);
+    GetWorkPlaneImpl(*snapshot, i_work_plane, wp, false);
 }
 
 void OvfFileReader::GetVectorBlock(const int i_work_plane, const int i_vector_block, VectorBlock& vb) const
 {
-    std::shared_lock lock{rwlock_};
-    CheckIsFileOpened();
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    GetVectorBlockImpl(*snapshot, i_work_plane, i_vector_block, vb);
+}
+
+void OvfFileReader::GetVectorBlocks(const int i_work_plane, Span<const int> i_vector_blocks, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    GetVectorBlocksImpl(*snapshot, i_work_plane, i_vector_blocks, vbs);
+}
+
+void OvfFileReader::GetVectorBlocks(const int i_work_plane, const int i_first_vector_block, const int count, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const
+{
+    if (count < 0 || (int64_t)i_first_vector_block + count > std::numeric_limits<int>::max())
+        throw std::runtime_error("Invalid vector block range");
+
+    std::vector<int> i_vector_blocks(count);
+    std::iota(i_vector_blocks.begin(), i_vector_blocks.end(), i_first_vector_block);
+
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    GetVectorBlocksImpl(*snapshot, i_work_plane, i_vector_blocks, vbs);
+}
+
+void OvfFileReader::GetVectorBlockHeaders(const int i_work_plane, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    GetVectorBlockHeadersImpl(*snapshot, i_work_plane, vbs);
+}
+
+WorkPlane* OvfFileReader::GetWorkPlane(const int i_work_plane, google::protobuf::Arena& arena) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    auto wp = util::CreateOnArena<WorkPlane>(arena);
+    GetWorkPlaneImpl(*snapshot, i_work_plane, *wp, true);
+    return wp;
+}
+
+WorkPlane* OvfFileReader::GetWorkPlaneShell(const int i_work_plane, google::protobuf::Arena& arena) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    auto wp = util::CreateOnArena<WorkPlane>(arena);
+    GetWorkPlaneImpl(*snapshot, i_work_plane, *wp, false);
+    return wp;
+}
+
+VectorBlock* OvfFileReader::GetVectorBlock(const int i_work_plane, const int i_vector_block, google::protobuf::Arena& arena) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    auto vb = util::CreateOnArena<VectorBlock>(arena);
+    GetVectorBlockImpl(*snapshot, i_work_plane, i_vector_block, *vb);
+    return vb;
+}
+
+VectorBlockView OvfFileReader::GetVectorBlockView(const int i_work_plane, const int i_vector_block) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
 
-    GetVectorBlockImpl(i_work_plane, i_vector_block, vb);
+    return VectorBlockView{GetVectorBlockFileView(*snapshot->file, i_work_plane, i_vector_block)};
 }
 
 
 
 void OvfFileReader::CacheWorkPlaneShells()
 {
-    std::unique_lock lock{rwlock_};
+    std::lock_guard threads_lock{threads_mutex_};
+    StopCacheWarming();
+
+    std::lock_guard lock{state_mutex_};
+    auto current = snapshot_.Get();
+    CheckIsFileOpened(current.get());
+
+    if (current->cache != nullptr && !current->are_vector_blocks_cached)
+        return;
+
+    // decode one work plane per task, or copy the shells of a cached full job
+    auto cache = std::make_shared<Job>(CreateEmptyCache(*current->file));
+    Snapshot uncached;
+    uncached.file = current->file;
+    util::ParallelFor(cache->work_planes_size(), num_cache_threads_, [&](int i){
+        if (current->cache != nullptr)
+            MergeWorkPlaneShell(current->cache->work_planes(i), *cache->mutable_work_planes(i));
+        else
+            GetWorkPlaneImpl(uncached, i, *cache->mutable_work_planes(i), false, false);
+    });
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->file = current->file;
+    snapshot->cache = std::move(cache);
+    snapshot->are_vector_blocks_cached = false;
+    snapshot_.Publish(std::move(snapshot));
+}
+
+void OvfFileReader::FindVectorBlocks(const int i_work_plane, const BoundingBox& region, std::vector<int>& i_vector_blocks) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    GetSpatialIndex(*snapshot->file, i_work_plane).Query(region, i_vector_blocks);
+}
+
+BoundingBox OvfFileReader::GetVectorBlockBounds(const int i_work_plane, const int i_vector_block) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    const auto& boxes = GetSpatialIndex(*snapshot->file, i_work_plane).boxes();
+    if (i_vector_block < 0 || i_vector_block > (int)boxes.size() - 1)
+        throw std::runtime_error("Invalid vector block index");
+
+    return boxes[i_vector_block];
+}
+
+void OvfFileReader::BuildSpatialIndex()
+{
+    auto snapshot = snapshot_.Get();
+    CheckIsFileOpened(snapshot.get());
+
+    const OpenedFile& file = *snapshot->file;
+    util::ParallelFor(file.index->num_work_planes(), num_cache_threads_, [&file](int i){ GetSpatialIndex(file, i); });
+}
+
+void OvfFileReader::BuildSpatialIndexAsync()
+{
+    std::lock_guard threads_lock{threads_mutex_};
+    StopSpatialIndexing();
+
+    std::lock_guard lock{state_mutex_};
+    auto current = snapshot_.Get();
+    CheckIsFileOpened(current.get());
+
+    is_spatial_indexer_stopped_ = false;
+    spatial_indexer_ = std::thread{&OvfFileReader::BuildSpatialIndexInBackground, this, current->file};
+}
 
-    if (cache_.has_value() && *are_vector_blocks_cached_)
+void OvfFileReader::FindVectorBlocks(const VectorBlockFilter& filter, std::vector<VectorBlockLocation>& locations,
+    const int first_work_plane, const int num_work_planes) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    GetAttributeIndex(*snapshot->file).Find(filter, locations, first_work_plane, num_work_planes);
+}
+
+void OvfFileReader::GetVectorBlocks(const int i_work_plane, const VectorBlockFilter& filter,
+    google::protobuf::RepeatedPtrField<VectorBlock>& vbs, std::vector<int> *i_vector_blocks) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    std::vector<int> selected;
+    GetAttributeIndex(*snapshot->file).Find(filter, i_work_plane, selected);
+    GetVectorBlocksImpl(*snapshot, i_work_plane, Span<const int>{selected.data(), selected.size()}, vbs);
+
+    if (i_vector_blocks != nullptr)
+        *i_vector_blocks = std::move(selected);
+}
+
+std::vector<int32_t> OvfFileReader::GetLaserIndices() const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    return GetAttributeIndex(*snapshot->file).laser_indices();
+}
+
+std::vector<int32_t> OvfFileReader::GetPartKeys() const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    return GetAttributeIndex(*snapshot->file).part_keys();
+}
+
+JobStatistics OvfFileReader::ComputeStatistics() const
+{
+    auto snapshot = snapshot_.Get();
+    CheckIsFileOpened(snapshot.get());
+
+    const OpenedFile& file = *snapshot->file;
+    std::vector<WorkPlaneStatistics> work_planes(file.index->num_work_planes());
+    util::ParallelFor((int)work_planes.size(), num_cache_threads_, [&](int i){
+        WorkPlane wp_shell{};
+        GetWorkPlaneImpl(*snapshot, i, wp_shell, false);
+
+        WorkPlaneStatisticsBuilder builder{file.job_shell.marking_params_map(), wp_shell.repeats()};
+        ForEachVectorBlockView(file, i, [&builder](int, const VectorBlockView& vb){ builder.Add(vb); });
+        work_planes[i] = builder.Finish();
+    });
+
+    return CombineWorkPlaneStatistics(std::move(work_planes));
+}
+
+void OvfFileReader::BuildAttributeIndex()
+{
+    auto snapshot = snapshot_.Get();
+    CheckIsFileOpened(snapshot.get());
+
+    GetAttributeIndex(*snapshot->file);
+}
+
+VerificationResult OvfFileReader::Verify() const
+{
+    auto snapshot = snapshot_.Get();
+    CheckIsFileOpened(snapshot.get());
+
+    const OpenedFile& file = *snapshot->file;
+    VerificationResult result;
+    if (!file.checksums.has_value())
+        return result;
+
+    const ChecksumSection& checksums = *file.checksums;
+    result.has_checksums = true;
+
+    // the job checksum covers the header and everything from the job shell up to the checksum section
     {
-        // remove vector blocks from cache
-        for (int i = 0; i < cache_->work_planes_size(); i++)
-        {
-            cache_->mutable_work_planes(i)->clear_vector_blocks();
-        }
+        auto header_view = file.source->CreateView(0, ChecksumSection::kFileHeaderSize);
+        uint32_t crc = Crc32c(header_view.data(), ChecksumSection::kFileHeaderSize);
+
+        const uint64_t job_shell_position = file.index->job_shell_position();
+        const size_t job_size = (size_t)(checksums.position - job_shell_position);
+        auto job_view = file.source->CreateView(job_shell_position, job_size);
+        crc = Crc32c(job_view.data(), job_size, crc);
+
+        result.is_job_intact = crc == checksums.job_checksum;
     }
-    else if (!cache_.has_value())
+
+    const int num_wps = file.index->num_work_planes();
+    std::vector<uint8_t> is_corrupted(num_wps);
+    util::ParallelFor(num_wps, num_cache_threads_, [&](int i){ is_corrupted[i] = !IsWorkPlaneIntact(file, i); });
+
+    uint32_t first_vector_block = 0;
+    for (int i = 0; i < num_wps; i++)
     {
-        // create new cache
-        cache_.emplace(*job_shell_);
-        for (int i = 0; i < job_shell_->num_work_planes(); i++)
+        if (is_corrupted[i])
         {
-            auto wp = cache_->add_work_planes();
-            GetWorkPlaneImpl(i, *wp, false, false);
+            result.corrupted_work_planes.push_back(i);
+            if (file.work_plane_verification != nullptr)
+                file.work_plane_verification[i].store(kCorrupted, std::memory_order_release);
         }
+
+        if (is_corrupted[i] && checksums.has_vector_block_checksums)
+        {
+            // the lut of the work plane might be corrupted as well, then only the work plane is reported
+            try
+            {
+                const auto wp_index = GetUnverifiedWorkPlaneIndex(file, i);
+                if (wp_index.num_vector_blocks() == (int)checksums.num_vector_blocks[i])
+                {
+                    for (int i_vb = 0; i_vb < wp_index.num_vector_blocks(); i_vb++)
+                    {
+                        size_t lower_offset = (size_t)wp_index.vector_block_positions[i_vb];
+                        size_t upper_offset = i_vb + 1 < wp_index.num_vector_blocks()
+                            ? (size_t)wp_index.vector_block_positions[i_vb + 1]
+                            : (size_t)wp_index.shell_position;
+                        if (upper_offset < lower_offset)
+                            throw std::runtime_error("Invalid vector block position, file might be corrupted");
+
+                        auto view = file.source->CreateView(lower_offset, upper_offset - lower_offset);
+                        if (Crc32c(view.data(), upper_offset - lower_offset) != checksums.vector_block_checksums[first_vector_block + i_vb])
+                            result.corrupted_vector_blocks.push_back(VectorBlockLocation{i, i_vb});
+                    }
+                }
+            }
+            catch (const std::runtime_error&)
+            {
+                // the work plane is reported as corrupted already
+            }
+        }
+
+        if (checksums.has_vector_block_checksums)
+            first_vector_block += checksums.num_vector_blocks[i];
     }
 
-    are_vector_blocks_cached_ = false;
+    return result;
+}
+
+void OvfFileReader::VerifyOnFirstRead(bool enable)
+{
+    std::lock_guard lock{state_mutex_};
+    verify_on_first_read_ = enable;
+}
+
+bool OvfFileReader::LockWorkPlanes(const int first_work_plane, const int num_work_planes) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    auto range = GetWorkPlanesByteRange(*snapshot->file, first_work_plane, num_work_planes);
+    return snapshot->file->source->Lock(range.offset, range.size);
+}
+
+void OvfFileReader::UnlockWorkPlanes(const int first_work_plane, const int num_work_planes) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    auto range = GetWorkPlanesByteRange(*snapshot->file, first_work_plane, num_work_planes);
+    snapshot->file->source->Unlock(range.offset, range.size);
+}
+
+void OvfFileReader::ReleaseWorkPlanes(const int first_work_plane, const int num_work_planes) const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    auto range = GetWorkPlanesByteRange(*snapshot->file, first_work_plane, num_work_planes);
+    snapshot->file->source->Release(range.offset, range.size);
+}
+
+ResidentMemory OvfFileReader::GetResidentMemory() const
+{
+    auto snapshot = snapshot_.Read();
+    CheckIsFileOpened(snapshot.get());
+
+    return snapshot->file->source->GetResidentMemory();
 }
 
 void OvfFileReader::CacheFullJob()
 {
-    std::unique_lock lock{rwlock_};
+    std::lock_guard threads_lock{threads_mutex_};
+    StopCacheWarming();
 
-    if (cache_.has_value() && !*are_vector_blocks_cached_)
-    {
-        // add vector blocks to cache
-        for (int i = 0; i < cache_->work_planes_size(); i++)
-        {
-            size_t wp_offset_abs;
-            auto work_plane_view = GetWorkPlaneFileView(i, &wp_offset_abs);
+    std::lock_guard lock{state_mutex_};
+    auto current = snapshot_.Get();
+    CheckIsFileOpened(current.get());
 
-            GetVectorBlocksImpl(i, *cache_->mutable_work_planes(i), work_plane_view, wp_offset_abs);
-        }
-    }
-    else if (!cache_.has_value())
-    {
-        // create new cache
-        cache_.emplace(*job_shell_);
-        for (int i = 0; i < job_shell_->num_work_planes(); i++)
-        {
-            auto wp = cache_->add_work_planes();
-            GetWorkPlaneImpl(i, *wp, true, false);
-        }
-    }
+    if (current->cache != nullptr && current->are_vector_blocks_cached)
+        return;
+
+    // decode one work plane per task
+    auto cache = std::make_shared<Job>(CreateEmptyCache(*current->file));
+    Snapshot uncached;
+    uncached.file = current->file;
+    util::ParallelFor(cache->work_planes_size(), num_cache_threads_, [&](int i){
+        GetWorkPlaneImpl(uncached, i, *cache->mutable_work_planes(i), true, false);
+    });
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->file = current->file;
+    snapshot->cache = std::move(cache);
+    snapshot->are_vector_blocks_cached = true;
+    snapshot_.Publish(std::move(snapshot));
+}
+
+void OvfFileReader::CacheFullJobAsync()
+{
+    std::lock_guard threads_lock{threads_mutex_};
+    StopCacheWarming();
+
+    std::lock_guard lock{state_mutex_};
+    auto current = snapshot_.Get();
+    CheckIsFileOpened(current.get());
+
+    if (current->cache != nullptr && current->are_vector_blocks_cached)
+        return;
+
+    auto warming_cache = std::make_shared<WarmingCache>();
+    warming_cache->job = CreateEmptyCache(*current->file);
+    warming_cache->is_ready = std::make_unique<std::atomic<bool>[]>(warming_cache->job.work_planes_size());
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->file = current->file;
+    snapshot->warming_cache = warming_cache;
+    snapshot_.Publish(std::move(snapshot));
+
+    is_cache_warmer_stopped_ = false;
+    cache_warmer_ = std::thread{&OvfFileReader::WarmCache, this, current->file, std::move(warming_cache)};
+}
+
+void OvfFileReader::CacheRecentlyUsed(size_t byte_budget, bool include_vector_blocks)
+{
+    std::lock_guard threads_lock{threads_mutex_};
+    StopCacheWarming();
+
+    std::lock_guard lock{state_mutex_};
+    auto current = snapshot_.Get();
+    if (current == nullptr)
+        return;
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->file = current->file;
+    snapshot->recently_used_cache = std::make_shared<MessageCache>(byte_budget);
+    snapshot->are_single_vector_blocks_cached = include_vector_blocks;
+    snapshot_.Publish(std::move(snapshot));
+}
+
+CacheStatistics OvfFileReader::GetCacheStatistics() const
+{
+    auto snapshot = snapshot_.Read();
+
+    if (snapshot.get() == nullptr || snapshot->recently_used_cache == nullptr)
+        return CacheStatistics{};
 
-    are_vector_blocks_cached_ = true;
+    return snapshot->recently_used_cache->GetStatistics();
 }
 
 void OvfFileReader::ClearCache()
 {
-    std::unique_lock lock{rwlock_};
+    std::lock_guard threads_lock{threads_mutex_};
+    StopCacheWarming();
 
-    cache_.reset();
-    are_vector_blocks_cached_ = false;
+    std::lock_guard lock{state_mutex_};
+    auto current = snapshot_.Get();
+    if (current == nullptr)
+        return;
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->file = current->file;
+    snapshot_.Publish(std::move(snapshot));
 }
 
 bool OvfFileReader::IsWorkPlaneShellsCached() const
 {
-    return cache_.has_value();
+    auto snapshot = snapshot_.Read();
+    return snapshot.get() != nullptr && snapshot->cache != nullptr;
 }
 
 bool OvfFileReader::IsFullJobCached() const
 {
-    return cache_.has_value() && *are_vector_blocks_cached_;
+    auto snapshot = snapshot_.Read();
+    return snapshot.get() != nullptr && snapshot->cache != nullptr && snapshot->are_vector_blocks_cached;
 }
 
+Job OvfFileReader::CreateEmptyCache(const OpenedFile& file) const
+{
+    Job cache{file.job_shell};
+    cache.clear_work_planes();
+
+    const int count_work_planes = file.index->num_work_planes();
+    cache.mutable_work_planes()->Reserve(count_work_planes);
+    for (int i = 0; i < count_work_planes; i++)
+    {
+        cache.add_work_planes();
+    }
 
+    return cache;
+}
 
-void OvfFileReader::GetVectorBlockImpl(const int i_work_plane, const int i_vector_block, VectorBlock& vb, bool try_cache) const
+void OvfFileReader::WarmCache(std::shared_ptr<const OpenedFile> file, std::shared_ptr<WarmingCache> warming_cache)
 {
-    if (try_cache && cache_.has_value() && *are_vector_blocks_cached_)
+    Snapshot uncached;
+    uncached.file = file;
+    try
     {
-        vb.MergeFrom(cache_->work_planes(i_work_plane).vector_blocks(i_vector_block));
+        util::ParallelFor(warming_cache->job.work_planes_size(), num_cache_threads_, [&](int i){
+            if (is_cache_warmer_stopped_)
+                return;
+
+            GetWorkPlaneImpl(uncached, i, *warming_cache->job.mutable_work_planes(i), true, false);
+            warming_cache->is_ready[i].store(true, std::memory_order_release);
+        });
+    }
+    catch (const std::exception&)
+    {
+        // work planes that were not decoded keep being read from the file,
+        // which reports the error to the caller
         return;
     }
 
-    size_t start_offset;
-    auto work_plane_view = GetWorkPlaneFileView(i_work_plane, &start_offset);
-    
-    const auto wpl = wp_luts_.value()[i_work_plane];
+    std::lock_guard lock{state_mutex_};
 
-    auto vb_pos = (size_t)wpl.vectorblockspositions(i_vector_block);
-    auto vb_offset = vb_pos - start_offset;
+    auto current = snapshot_.Get();
+    if (is_cache_warmer_stopped_ || current == nullptr || current->warming_cache != warming_cache)
+        return;
 
-    // this array stream is longer than the vector block alone.
-    // as the protobuf streams are all buffered, and the messages
-    // are delimited, that should be fine.
-    google::protobuf::io::ArrayInputStream zcs{
-        work_plane_view.data() + vb_offset,
-        (int)(work_plane_view.size() - vb_offset)
-    };
-    google::protobuf::util::ParseDelimitedFromZeroCopyStream(
-        &vb,
-        &zcs,
-        nullptr
-    );
+    // the warmed job becomes the cache in place, readers of the current snapshot might still use it
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->file = std::move(file);
+    snapshot->cache = std::shared_ptr<const Job>{warming_cache, &warming_cache->job};
+    snapshot->are_vector_blocks_cached = true;
+    snapshot_.Publish(std::move(snapshot));
 }
 
-void OvfFileReader::GetWorkPlaneImpl(const int i_work_plane, WorkPlane& wp, bool include_vector_blocks, bool try_cache) const
+void OvfFileReader::StopCacheWarming()
 {
+    is_cache_warmer_stopped_ = true;
+    if (cache_warmer_.joinable())
+        cache_warmer_.join();
+}
+
+
+
+void OvfFileReader::BuildSpatialIndexInBackground(std::shared_ptr<const OpenedFile> file)
+{
+    for (int i = 0; i < file->index->num_work_planes() && !is_spatial_indexer_stopped_; i++)
+    {
+        try
+        {
+            GetSpatialIndex(*file, i);
+        }
+        catch (const std::exception&)
+        {
+            // reported again once the work plane is queried
+        }
+    }
+}
+
+void OvfFileReader::StopSpatialIndexing()
+{
+    is_spatial_indexer_stopped_ = true;
+    if (spatial_indexer_.joinable())
+        spatial_indexer_.join();
+}
+
+void OvfFileReader::GetVectorBlockImpl(const Snapshot& snapshot, const int i_work_plane, const int i_vector_block, VectorBlock& vb, bool try_cache) const
+{
+    // validate indices before any cache access
+    size_t lower_offset, upper_offset;
+    GetWorkPlaneIndex(*snapshot.file, i_work_plane).GetVectorBlockRange(i_vector_block, lower_offset, upper_offset);
+
+    if (try_cache && snapshot.cache != nullptr && snapshot.are_vector_blocks_cached)
+    {
+        vb.MergeFrom(snapshot.cache->work_planes(i_work_plane).vector_blocks(i_vector_block));
+        return;
+    }
+
+    if (auto warmed_wp = try_cache ? GetWarmedWorkPlane(snapshot, i_work_plane) : nullptr)
+    {
+        vb.MergeFrom(warmed_wp->vector_blocks(i_vector_block));
+        return;
+    }
+
+    if (try_cache && snapshot.recently_used_cache != nullptr)
+    {
+        auto& recently_used_cache = *snapshot.recently_used_cache;
+
+        if (auto cached_wp = recently_used_cache.Peek(i_work_plane))
+        {
+            vb.MergeFrom(static_cast<const WorkPlane&>(*cached_wp).vector_blocks(i_vector_block));
+            return;
+        }
+
+        if (snapshot.are_single_vector_blocks_cached)
+        {
+            if (auto cached_vb = recently_used_cache.Get(i_work_plane, i_vector_block))
+            {
+                vb.MergeFrom(*cached_vb);
+                return;
+            }
+
+            auto decoded_vb = std::make_shared<VectorBlock>();
+            GetVectorBlockImpl(snapshot, i_work_plane, i_vector_block, *decoded_vb, false);
+            vb.MergeFrom(*decoded_vb);
+            recently_used_cache.Put(i_work_plane, i_vector_block, std::move(decoded_vb));
+            return;
+        }
+    }
+
+    // only map the vector block itself, not the whole work plane
+    auto vector_block_view = snapshot.file->source->CreateView(lower_offset, upper_offset - lower_offset);
+    ParseDelimitedFromArray(vb, vector_block_view.data(), vector_block_view.size());
+}
+
+void OvfFileReader::GetWorkPlaneImpl(const Snapshot& snapshot, const int i_work_plane, WorkPlane& wp, bool include_vector_blocks, bool try_cache) const
+{
+    const auto& file = *snapshot.file;
+    const auto wp_index = GetWorkPlaneIndex(file, i_work_plane);
+
     wp.Clear();
 
-    if (try_cache && cache_.has_value() && include_vector_blocks && *are_vector_blocks_cached_)
+    if (try_cache && snapshot.cache != nullptr && include_vector_blocks && snapshot.are_vector_blocks_cached)
     {
-        wp.MergeFrom(cache_->work_planes(i_work_plane));
+        wp.MergeFrom(snapshot.cache->work_planes(i_work_plane));
         return;
     }
 
-    if (try_cache && cache_.has_value() && !include_vector_blocks)
+    if (try_cache && snapshot.cache != nullptr && !include_vector_blocks)
     {
-        util::MergeExcluding(
-            cache_->work_planes(i_work_plane),
-            wp,
-            [](const google::protobuf::FieldDescriptor& fd){return fd.name() == "work_planes";}
-        );
+        MergeWorkPlaneShell(snapshot.cache->work_planes(i_work_plane), wp);
+        return;
+    }
+
+    if (auto warmed_wp = try_cache ? GetWarmedWorkPlane(snapshot, i_work_plane) : nullptr)
+    {
+        if (include_vector_blocks)
+            wp.MergeFrom(*warmed_wp);
+        else
+            MergeWorkPlaneShell(*warmed_wp, wp);
         return;
     }
+
+    if (try_cache && snapshot.recently_used_cache != nullptr && include_vector_blocks)
+    {
+        if (auto cached_wp = snapshot.recently_used_cache->Get(i_work_plane))
+        {
+            wp.MergeFrom(*cached_wp);
+            return;
+        }
+
+        auto decoded_wp = std::make_shared<WorkPlane>();
+        GetWorkPlaneImpl(snapshot, i_work_plane, *decoded_wp, true, false);
+        wp.MergeFrom(*decoded_wp);
+        snapshot.recently_used_cache->Put(i_work_plane, MessageCache::kWholeWorkPlane, std::move(decoded_wp));
+        return;
+    }
+
+    if (try_cache && snapshot.recently_used_cache != nullptr && !include_vector_blocks)
+    {
+        if (auto cached_wp = snapshot.recently_used_cache->Peek(i_work_plane))
+        {
+            MergeWorkPlaneShell(static_cast<const WorkPlane&>(*cached_wp), wp);
+            return;
+        }
+    }
     
     // we either need to read the shell, the blocks, or both from the file
+    if (!include_vector_blocks)
+    {
+        // only view the shell and the lut following it
+        size_t wp_offset_abs, wp_end_abs;
+        file.index->GetWorkPlaneRange(i_work_plane, wp_offset_abs, wp_end_abs);
+        if (wp_index.shell_position < wp_offset_abs || wp_index.shell_position >= wp_end_abs)
+            throw std::runtime_error("Invalid work plane shell position, file might be corrupted");
+
+        auto shell_view = file.source->CreateView(wp_index.shell_position, wp_end_abs - wp_index.shell_position);
+        ParseDelimitedFromArray(wp, shell_view.data(), shell_view.size());
+        return;
+    }
+
     // prepare file access
     size_t wp_offset_abs;
-    auto work_plane_view = GetWorkPlaneFileView(i_work_plane, &wp_offset_abs);
-    const auto wpl = wp_luts_.value()[i_work_plane];
+    auto work_plane_view = GetWorkPlaneFileView(file, i_work_plane, &wp_offset_abs);
 
     // offset from start of work plane
-    size_t shell_position = (size_t)wpl.workplaneshellposition() - wp_offset_abs;
+    size_t shell_position = (size_t)wp_index.shell_position - wp_offset_abs;
 
     // write work plane shell into output
-    if (try_cache && cache_.has_value())
+    if (try_cache && snapshot.cache != nullptr)
     {
-        wp.MergeFrom(cache_->work_planes(i_work_plane));
+        wp.MergeFrom(snapshot.cache->work_planes(i_work_plane));
     }
     else
     {
-        google::protobuf::io::ArrayInputStream zcs{
+        ParseDelimitedFromArray(
+            wp,
             work_plane_view.data() + shell_position,
-            (int)(work_plane_view.size() - shell_position)
-        };
-        google::protobuf::util::ParseDelimitedFromZeroCopyStream(
-            &wp,
-            &zcs,
-            nullptr
+            work_plane_view.size() - shell_position
         );
     }
 
     // write vector blocks into output
-    if (include_vector_blocks)
-    {
-        GetVectorBlocksImpl(i_work_plane, wp, work_plane_view, wp_offset_abs);
-    }
+    GetVectorBlocksImpl(file, i_work_plane, wp, work_plane_view, wp_offset_abs);
 }
 
-void OvfFileReader::GetVectorBlocksImpl(const int i_work_plane, WorkPlane& wp, MemoryMapping::FileView& work_plane_view, size_t wp_offset_abs) const
+void OvfFileReader::GetVectorBlocksImpl(const OpenedFile& file, const int i_work_plane, WorkPlane& wp, FileView& work_plane_view, size_t wp_offset_abs) const
 {
-    const auto wpl = wp_luts_.value()[i_work_plane];
+    const auto wp_index = GetWorkPlaneIndex(file, i_work_plane);
 
     // populate work plane with vector blocks
-    for (int i = 0; i < wpl.vectorblockspositions_size(); i++)
+    wp.mutable_vector_blocks()->Reserve(wp_index.num_vector_blocks());
+    for (int i = 0; i < wp_index.num_vector_blocks(); i++)
     {
-        auto vb_pos = (size_t)wpl.vectorblockspositions(i);
+        auto vb_pos = (size_t)wp_index.vector_block_positions[i];
         auto vb_offset = vb_pos - wp_offset_abs;
 
         VectorBlock *vb = wp.add_vector_blocks();
 
-        // this array stream is longer than the vector block alone.
-        // as the protobuf streams are all buffered, and the messages
-        // are delimited, that should be fine.
-        google::protobuf::io::ArrayInputStream zcs{
+        // this array is longer than the vector block alone.
+        // as the messages are delimited, that should be fine.
+        ParseDelimitedFromArray(
+            *vb,
             work_plane_view.data() + vb_offset,
-            (int)(work_plane_view.size() - vb_offset)
-        };
-        google::protobuf::util::ParseDelimitedFromZeroCopyStream(
-            vb,
-            &zcs,
-            nullptr
+            work_plane_view.size() - vb_offset
+        );
+    }
+}
+
+void OvfFileReader::GetVectorBlocksImpl(const Snapshot& snapshot, const int i_work_plane, Span<const int> i_vector_blocks, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const
+{
+    const auto wp_index = GetWorkPlaneIndex(*snapshot.file, i_work_plane);
+
+    struct BlockRange
+    {
+        size_t start_offset;
+        size_t end_offset;
+        int i_output;
+    };
+
+    // resolve and validate all offsets before touching the output
+    std::vector<BlockRange> ranges(i_vector_blocks.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        wp_index.GetVectorBlockRange(i_vector_blocks[i], ranges[i].start_offset, ranges[i].end_offset);
+        ranges[i].i_output = (int)i;
+    }
+
+    vbs.Clear();
+    vbs.Reserve((int)ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        vbs.Add();
+    }
+
+    if (ranges.empty())
+        return;
+
+    const WorkPlane *cached_wp = nullptr;
+    std::shared_ptr<const google::protobuf::Message> recently_used_wp;
+    if (snapshot.cache != nullptr && snapshot.are_vector_blocks_cached)
+    {
+        cached_wp = &snapshot.cache->work_planes(i_work_plane);
+    }
+    else if (auto warmed_wp = GetWarmedWorkPlane(snapshot, i_work_plane))
+    {
+        cached_wp = warmed_wp;
+    }
+    else if (snapshot.recently_used_cache != nullptr && (recently_used_wp = snapshot.recently_used_cache->Peek(i_work_plane)))
+    {
+        cached_wp = static_cast<const WorkPlane*>(recently_used_wp.get());
+    }
+
+    if (cached_wp != nullptr)
+    {
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+            vbs.Mutable((int)i)->MergeFrom(cached_wp->vector_blocks(i_vector_blocks[i]));
+        }
+        return;
+    }
+
+    // decode in file order, so that the file is read front to back
+    auto by_offset = [](const BlockRange& a, const BlockRange& b){return a.start_offset < b.start_offset;};
+    if (!std::is_sorted(ranges.begin(), ranges.end(), by_offset))
+    {
+        std::sort(ranges.begin(), ranges.end(), by_offset);
+    }
+
+    // views are cheap for mapped files, so a single view covers all requested vector blocks.
+    // when the data is copied, only adjacent vector blocks are read at once, and all reads
+    // are submitted together
+    const FileSource& source = *snapshot.file->source;
+    std::vector<ByteRange> reads;
+    std::vector<size_t> i_reads(ranges.size());
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        const auto& range = ranges[i];
+        if (!reads.empty() && (!source.copies_data() || range.start_offset <= reads.back().offset + reads.back().size))
+        {
+            auto& read = reads.back();
+            read.size = std::max(read.size, range.end_offset - read.offset);
+        }
+        else
+        {
+            reads.push_back(ByteRange{range.start_offset, range.end_offset - range.start_offset});
+        }
+        i_reads[i] = reads.size() - 1;
+    }
+
+    auto views = source.CreateViews(reads);
+
+    for (size_t i = 0; i < ranges.size(); i++)
+    {
+        const auto& view = views[i_reads[i]];
+        size_t vb_offset = ranges[i].start_offset - reads[i_reads[i]].offset;
+        ParseDelimitedFromArray(
+            *vbs.Mutable(ranges[i].i_output),
+            view.data() + vb_offset,
+            view.size() - vb_offset
         );
     }
 }
 
+void OvfFileReader::GetVectorBlockHeadersImpl(const Snapshot& snapshot, const int i_work_plane, google::protobuf::RepeatedPtrField<VectorBlock>& vbs) const
+{
+    const auto wp_index = GetWorkPlaneIndex(*snapshot.file, i_work_plane);
+
+    vbs.Clear();
+    vbs.Reserve(wp_index.num_vector_blocks());
+
+    const WorkPlane *cached_wp = nullptr;
+    std::shared_ptr<const google::protobuf::Message> recently_used_wp;
+    if (snapshot.cache != nullptr && snapshot.are_vector_blocks_cached)
+    {
+        cached_wp = &snapshot.cache->work_planes(i_work_plane);
+    }
+    else if (auto warmed_wp = GetWarmedWorkPlane(snapshot, i_work_plane))
+    {
+        cached_wp = warmed_wp;
+    }
+    else if (snapshot.recently_used_cache != nullptr && (recently_used_wp = snapshot.recently_used_cache->Peek(i_work_plane)))
+    {
+        cached_wp = static_cast<const WorkPlane*>(recently_used_wp.get());
+    }
+
+    if (cached_wp != nullptr)
+    {
+        for (const auto& vb : cached_wp->vector_blocks())
+        {
+            MergeVectorBlockHeader(vb, *vbs.Add());
+        }
+        return;
+    }
+
+    if (wp_index.num_vector_blocks() == 0)
+        return;
+
+    // a single view from the first vector block up to the work plane shell
+    size_t lower_offset = (size_t)wp_index.vector_block_positions[0];
+    size_t upper_offset = (size_t)wp_index.shell_position;
+    if (upper_offset < lower_offset)
+        throw std::runtime_error("Invalid work plane shell position, file might be corrupted");
+
+    auto view = snapshot.file->source->CreateView(lower_offset, upper_offset - lower_offset);
+
+    for (int i = 0; i < wp_index.num_vector_blocks(); i++)
+    {
+        size_t vb_offset = (size_t)wp_index.vector_block_positions[i] - lower_offset;
+        if (vb_offset >= view.size())
+            throw std::runtime_error("Invalid vector block position, file might be corrupted");
+
+        ParseVectorBlockHeaderFromArray(*vbs.Add(), view.data() + vb_offset, view.size() - vb_offset);
+    }
+}
+
+void OvfFileReader::LoadWorkPlaneLUT(const OpenedFile& file, const int i_work_plane, WorkPlaneLUT& wpl)
+{
+    size_t wp_offset_abs, wp_end_abs;
+    file.index->GetWorkPlaneRange(i_work_plane, wp_offset_abs, wp_end_abs);
+
+    if (wp_end_abs < wp_offset_abs || wp_end_abs - wp_offset_abs < sizeof(int64_t))
+        throw std::runtime_error("Invalid work plane position, file might be corrupted");
+
+    // only view the header and the lut, the vector blocks in between are not needed
+    int64_t wp_lut_offset_raw;
+    {
+        auto header_view = file.source->CreateView(wp_offset_abs, sizeof(int64_t));
+        util::ReadFromLittleEndian(wp_lut_offset_raw, header_view.data());
+    }
+    size_t wp_lut_offset_abs = (size_t)wp_lut_offset_raw;
+
+    if (wp_lut_offset_raw < 0 || wp_lut_offset_abs < wp_offset_abs || wp_lut_offset_abs >= wp_end_abs)
+        throw std::runtime_error("Invalid work plane lut offset, file might be corrupted");
+
+    auto lut_view = file.source->CreateView(wp_lut_offset_abs, wp_end_abs - wp_lut_offset_abs);
+    ParseDelimitedFromArray(wpl, lut_view.data(), lut_view.size());
+}
+
+std::vector<BoundingBox> OvfFileReader::ComputeVectorBlockBounds(const OpenedFile& file, const int i_work_plane)
+{
+    std::vector<BoundingBox> boxes(GetWorkPlaneIndex(file, i_work_plane).num_vector_blocks());
+
+    ForEachVectorBlockView(file, i_work_plane, [&boxes](int i, const VectorBlockView& vb){
+        if (vb.has_points())
+        {
+            boxes[i] = ComputePointBounds(vb.points(), vb.point_dimensions());
+        }
+        else if (vb.vector_data_case() != VectorBlock::VECTOR_DATA_NOT_SET &&
+                 vb.vector_data_case() != VectorBlock::kExposurePause)
+        {
+            // the extent of arcs and ellipses is not computed, so they match every query
+            boxes[i] = BoundingBox::Unbounded();
+        }
+    });
+
+    return boxes;
+}
+
+std::vector<VectorBlockAttributes> OvfFileReader::ReadVectorBlockAttributes(const OpenedFile& file, const int i_work_plane)
+{
+    const auto wp_index = GetWorkPlaneIndex(file, i_work_plane);
+    std::vector<VectorBlockAttributes> attributes(wp_index.num_vector_blocks());
+    if (attributes.empty())
+        return attributes;
+
+    // a single view from the first vector block up to the work plane shell
+    size_t lower_offset = (size_t)wp_index.vector_block_positions[0];
+    size_t upper_offset = (size_t)wp_index.shell_position;
+    if (upper_offset < lower_offset)
+        throw std::runtime_error("Invalid work plane shell position, file might be corrupted");
+
+    auto view = file.source->CreateView(lower_offset, upper_offset - lower_offset);
+
+    for (int i = 0; i < wp_index.num_vector_blocks(); i++)
+    {
+        size_t vb_offset = (size_t)wp_index.vector_block_positions[i] - lower_offset;
+        if (vb_offset >= view.size())
+            throw std::runtime_error("Invalid vector block position, file might be corrupted");
+
+        ScanVectorBlockAttributesFromArray(attributes[i], view.data() + vb_offset, view.size() - vb_offset);
+    }
+
+    return attributes;
+}
+
+const AttributeIndex& OvfFileReader::GetAttributeIndex(const OpenedFile& file) const
+{
+    // on failure, the exception is propagated and the next access retries
+    std::call_once(file.attribute_index->is_building, [&](){
+        const int num_wps = file.index->num_work_planes();
+
+        if (file.use_index_files)
+        {
+            auto loaded = AttributeIndex::Load(file.path, file.job_lut_position);
+
+            // the job index is up to date as well, so the vector block counts have to match
+            bool is_consistent = loaded.has_value() && loaded->num_work_planes() == num_wps;
+            for (int i = 0; is_consistent && i < num_wps; i++)
+                is_consistent = loaded->num_vector_blocks(i) == GetUnverifiedWorkPlaneIndex(file, i).num_vector_blocks();
+
+            if (is_consistent)
+            {
+                file.attribute_index->index = std::move(loaded);
+                return;
+            }
+        }
+
+        std::vector<std::vector<VectorBlockAttributes>> attributes(num_wps);
+        util::ParallelFor(num_wps, num_cache_threads_, [&](int i){ attributes[i] = ReadVectorBlockAttributes(file, i); });
+        file.attribute_index->index.emplace(attributes);
+
+        if (file.use_index_files)
+        {
+            try
+            {
+                file.attribute_index->index->Save(file.path, file.job_lut_position);
+            }
+            catch (const std::runtime_error&)
+            {
+                // the attribute index file only speeds up the next access, e.g. the directory might be read-only
+            }
+        }
+    });
+
+    return *file.attribute_index->index;
+}
+
+bool OvfFileReader::IsWorkPlaneIntact(const OpenedFile& file, const int i_work_plane)
+{
+    // views might extend beyond the requested range
+    size_t start_offset, end_offset;
+    auto view = GetWorkPlaneFileView(file, i_work_plane, &start_offset, &end_offset);
+    return Crc32c(view.data(), end_offset - start_offset) == file.checksums->work_plane_checksums[i_work_plane];
+}
+
+void OvfFileReader::VerifyWorkPlaneOnFirstRead(const OpenedFile& file, const int i_work_plane)
+{
+    // invalid indices are reported by the job index
+    if (i_work_plane < 0 || i_work_plane > file.index->num_work_planes() - 1)
+        return;
+
+    // concurrent first reads might both verify the work plane, with the same outcome
+    auto& state = file.work_plane_verification[i_work_plane];
+    uint8_t verification = state.load(std::memory_order_acquire);
+    if (verification == kNotVerified)
+    {
+        verification = IsWorkPlaneIntact(file, i_work_plane) ? kIntact : kCorrupted;
+        state.store(verification, std::memory_order_release);
+    }
+
+    if (verification == kCorrupted)
+        throw std::runtime_error("Checksum mismatch in work plane " + std::to_string(i_work_plane) + ", file is corrupted");
+}
+
+void OvfFileReader::LoadWorkPlaneLUTs(std::shared_ptr<const OpenedFile> file)
+{
+    for (int i = 0; i < file->index->num_work_planes() && !is_lut_loader_stopped_; i++)
+    {
+        try
+        {
+            GetUnverifiedWorkPlaneIndex(*file, i);
+        }
+        catch (const std::exception&)
+        {
+            // reported again once the work plane is accessed
+        }
+    }
+}
+
+void OvfFileReader::StopLoadingLUTs()
+{
+    is_lut_loader_stopped_ = true;
+    if (lut_loader_.joinable())
+        lut_loader_.join();
+}
+
 }
\ No newline at end of file
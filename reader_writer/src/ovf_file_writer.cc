@@ -26,20 +26,143 @@ SOFTWARE.
 ---- Copyright End ----
 */
 
+#include <memory>
 #include <optional>
-#include <fstream>
+#include <limits>
+#include <thread>
+#include <algorithm>
 
-#include "google/protobuf/util/delimited_message_util.h"
+#include "google/protobuf/io/coded_stream.h"
 
 #include "ovf_file_writer.h"
+#include "job_index.h"
 #include "util.h"
 #include "consts.h"
 
 namespace open_vector_format::reader_writer {
 
-OvfFileWriter::OvfFileWriter()
-    : operation_{FileOperationState::kNone}
+namespace {
+
+/**
+ * @brief Computes the size of a message prefixed by its size like SerializeDelimitedToOstream,
+ * and caches the sizes for SerializeDelimited.
+ */
+size_t DelimitedSize(const google::protobuf::MessageLite& message)
+{
+    const size_t size = message.ByteSizeLong();
+    if (size > (size_t)std::numeric_limits<int>::max())
+        throw std::runtime_error("Message exceeds the maximum size of 2 GB");
+
+    return google::protobuf::io::CodedOutputStream::VarintSize32((uint32_t)size) + size;
+}
+
+/**
+ * @brief Serializes a message prefixed by its size, after its sizes were cached by DelimitedSize.
+ */
+void SerializeDelimited(const google::protobuf::MessageLite& message, uint8_t *out)
+{
+    out = google::protobuf::io::CodedOutputStream::WriteVarint32ToArray((uint32_t)message.GetCachedSize(), out);
+    message.SerializeWithCachedSizesToArray(out);
+}
+
+/**
+ * @brief Appends a message to a buffer, prefixed by its size like SerializeDelimitedToOstream.
+ */
+void AppendDelimited(const google::protobuf::MessageLite& message, std::string& buffer)
+{
+    const size_t offset = buffer.size();
+    buffer.resize(offset + DelimitedSize(message));
+    SerializeDelimited(message, (uint8_t*)&buffer[offset]);
+}
+
+/** Maximum number of vector blocks serialized by one task of the serialization pipeline. */
+const size_t kMaxBatchSize = 64;
+
+/** Maximum number of tasks in the serialization pipeline, the memory of queued vector blocks
+ *  is bounded by the queue budget. */
+const size_t kMaxPendingTasks = 1024;
+
+/** Number of batches of owned vector blocks the queue budget is split into. */
+const size_t kBatchesPerQueueBudget = 16;
+
+}
+
+struct OvfFileWriter::VectorBlockBatch
+{
+    /** The vector blocks to serialize, borrowed or owned by owned_vector_blocks. */
+    std::vector<const VectorBlock*> vector_blocks;
+    std::vector<std::unique_ptr<VectorBlock>> owned_vector_blocks;
+    /** Memory of the owned vector blocks, charged to the queue budget until they are serialized. */
+    size_t owned_size = 0;
+
+    /** The serialized vector blocks, each prefixed by its size. */
+    std::string serialized;
+    /** Size of each serialized vector block. Already computed for owned vector blocks, when
+     *  they are added to the batch. */
+    std::vector<size_t> sizes;
+    /** Checksum of all serialized vector blocks, and of each of them. */
+    uint32_t checksum = 0;
+    std::vector<uint32_t> checksums;
+
+    /**
+     * @brief Serializes the vector blocks and releases the owned ones, run by a worker thread.
+     * 
+     * @return size_t The size of the serialized vector blocks.
+     */
+    size_t Serialize(const ChecksumMode checksum_mode)
+    {
+        // sizes are cached for all vector blocks first, so they are serialized into one buffer
+        if (sizes.size() != vector_blocks.size())
+        {
+            sizes.clear();
+            sizes.reserve(vector_blocks.size());
+            for (const VectorBlock* vb : vector_blocks)
+                sizes.push_back(DelimitedSize(*vb));
+        }
+        size_t total_size = 0;
+        for (const size_t size : sizes)
+            total_size += size;
+
+        serialized.resize(total_size);
+        uint8_t *out = (uint8_t*)serialized.data();
+        for (size_t i = 0; i < vector_blocks.size(); i++)
+        {
+            SerializeDelimited(*vector_blocks[i], out);
+            if (checksum_mode == ChecksumMode::kVectorBlocks)
+                checksums.push_back(Crc32c(out, sizes[i]));
+            out += sizes[i];
+        }
+
+        if (checksum_mode != ChecksumMode::kNone)
+            checksum = Crc32c((const uint8_t*)serialized.data(), serialized.size());
+
+        vector_blocks.clear();
+        owned_vector_blocks.clear();
+        return serialized.size();
+    }
+};
+
+OvfFileWriter::OvfFileWriter(const WriterOptions& options)
+    : operation_{FileOperationState::kNone},
+      write_buffer_size_{options.write_buffer_size},
+      sync_on_finish_{options.sync_on_finish},
+      write_index_file_{options.write_index_file},
+      checksum_mode_{options.checksum_mode}
 {
+    int num_threads = options.num_threads;
+    size_t queue_budget = options.queue_budget;
+    if (num_threads == 0)
+        num_threads = std::max(1, (int)std::thread::hardware_concurrency());
+
+    // with a single thread, handing over vector blocks is only worth it to not wait for the file system
+    if (queue_budget == 0 && num_threads > 1)
+        queue_budget = kDefaultQueueBudget;
+
+    if (queue_budget > 0)
+    {
+        pipeline_ = std::make_unique<SerializationPipeline>(num_threads, kMaxPendingTasks, queue_budget);
+        max_batch_bytes_ = std::max(queue_budget / kBatchesPerQueueBudget, (size_t)1);
+    }
 }
 
 
@@ -50,11 +173,18 @@ void OvfFileWriter::StartWritePartial(const Job& job_shell, const std::string pa
     
     operation_ = FileOperationState::kPartialWrite;
 
-    ofs_ = std::ofstream{path};
-
-    WriteHeader(job_shell);
+    try
+    {
+        output_file_.emplace(path, write_buffer_size_);
+        path_ = path;
 
-    current_wp_ = {};
+        WriteHeader(job_shell);
+    }
+    catch (...)
+    {
+        AbortWrite();
+        throw;
+    }
 }
 
 void OvfFileWriter::AppendWorkPlane(const WorkPlane& wp)
@@ -62,26 +192,85 @@ void OvfFileWriter::AppendWorkPlane(const WorkPlane& wp)
     if (operation_ != FileOperationState::kPartialWrite)
         throw std::runtime_error("Trying to append work plane without partial write operation in progress");
 
-    // actually write current_wp_ to stream
-    if (current_wp_.has_value())
+    try
+    {
+        // finishes the previous work plane and writes the vector blocks of wp right away
+        BeginWorkPlane(wp);
+        for (const auto& vb : wp.vector_blocks())
+            AddVectorBlock(vb, false);
+    }
+    catch (...)
     {
-        WriteFullWorkPlane(*current_wp_);
-        current_wp_ = {};
+        // the file misses the output of the failed append, so it can't be finished
+        AbortWrite();
+        throw;
     }
+}
+
+void OvfFileWriter::AppendWorkPlane(WorkPlane&& wp)
+{
+    if (operation_ != FileOperationState::kPartialWrite)
+        throw std::runtime_error("Trying to append work plane without partial write operation in progress");
 
-    // use wp as new workplane
-    current_wp_ = WorkPlane{wp};
+    try
+    {
+        BeginWorkPlane(wp);
+        for (auto& vb : *wp.mutable_vector_blocks())
+            AddVectorBlock(std::move(vb));
+    }
+    catch (...)
+    {
+        AbortWrite();
+        throw;
+    }
 }
 
 void OvfFileWriter::AppendVectorBlock(const VectorBlock& vb)
 {
-    if (operation_ != FileOperationState::kPartialWrite)
-        throw std::runtime_error{"Trying to append vector block without partial write operation in progress"};
+    CheckCanAppendVectorBlock();
 
-    if (!current_wp_.has_value())
-        throw std::runtime_error("Trying to append vector block before writing first work plane");
+    try
+    {
+        AddVectorBlock(vb, false);
+    }
+    catch (...)
+    {
+        AbortWrite();
+        throw;
+    }
+}
 
-    current_wp_->add_vector_blocks()->MergeFrom(vb);
+void OvfFileWriter::AppendVectorBlock(VectorBlock&& vb)
+{
+    CheckCanAppendVectorBlock();
+
+    try
+    {
+        AddVectorBlock(std::move(vb));
+    }
+    catch (...)
+    {
+        AbortWrite();
+        throw;
+    }
+}
+
+void OvfFileWriter::AppendVectorBlock(std::unique_ptr<VectorBlock> vb)
+{
+    CheckCanAppendVectorBlock();
+
+    if (vb == nullptr)
+        throw std::runtime_error("Trying to append vector block that is null");
+
+    try
+    {
+        AddVectorBlock(std::move(vb));
+    }
+    catch (...)
+    {
+        AbortWrite();
+        throw;
+    }
 }
 
 void OvfFileWriter::FinishWrite()
@@ -89,9 +278,15 @@ void OvfFileWriter::FinishWrite()
     if (operation_ != FileOperationState::kPartialWrite)
         throw std::runtime_error("Trying to finish partial write without partial write operation in progress");
     
-    WriteFooter();
-
-    ofs_ = {};
+    try
+    {
+        WriteFooter();
+    }
+    catch (...)
+    {
+        AbortWrite();
+        throw;
+    }
 
     operation_ = FileOperationState::kNone;
 }
@@ -103,16 +298,24 @@ void OvfFileWriter::WriteFullJob(const Job& job, const std::string path)
     
     operation_ = FileOperationState::kCompleteWrite;
 
-    ofs_ = std::ofstream{path};
-
-    WriteHeader(job);
+    try
+    {
+        output_file_.emplace(path, write_buffer_size_);
+        path_ = path;
 
-    for (int i = 0; i < job.num_work_planes(); i++)
-        WriteFullWorkPlane(job.work_planes(i));
+        WriteHeader(job);
 
-    WriteFooter();
+        for (int i = 0; i < job.num_work_planes(); i++)
+            WriteFullWorkPlane(job.work_planes(i));
 
-    ofs_ = {};
+        WriteFooter();
+    }
+    catch (...)
+    {
+        // also waits for the pipeline, which borrows the vector blocks of the job
+        AbortWrite();
+        throw;
+    }
 
     operation_ = FileOperationState::kNone;
 }
@@ -129,6 +332,15 @@ Job& OvfFileWriter::job_shell()
 }
 
 
+QueueStatistics OvfFileWriter::GetQueueStatistics() const
+{
+    if (pipeline_ == nullptr)
+        return {};
+
+    return pipeline_->GetStatistics();
+}
+
+
 void OvfFileWriter::WriteHeader(const Job& job)
 {
     CheckIsWriting();
@@ -142,110 +354,346 @@ void OvfFileWriter::WriteHeader(const Job& job)
     );
     job_shell_->set_num_work_planes(0);
 
-    ofs_->write((char*)kMagicBytes.data(), kMagicBytes.size());
+    output_file_->Write(kMagicBytes.data(), kMagicBytes.size());
     
-    job_lut_offset_offset_ = ofs_->tellp();
-    uint8_t dummy_offset[8];
-    ofs_->write((char*)dummy_offset, 8);
+    job_lut_offset_offset_ = output_file_->offset();
+    const uint8_t dummy_offset[8] = {};
+    output_file_->Write(dummy_offset, sizeof(dummy_offset));
 
     job_lut_ = JobLUT{};
 }
 
 
 void OvfFileWriter::WriteFullWorkPlane(const WorkPlane& wp)
+{
+    BeginWorkPlane(wp);
+    for (const auto& vb : wp.vector_blocks())
+        AddVectorBlock(vb, true);
+    FinishWorkPlane();
+}
+
+void OvfFileWriter::BeginWorkPlane(const WorkPlane& wp)
 {
     CheckIsWriting();
     CheckFsHealth();
 
-    ofs_->seekp(0, std::ios::end);
-
-    // add start offset of this workplane to job lut
-    uint64_t workplane_offset = ofs_->tellp();
-    job_lut_->add_workplanepositions(workplane_offset);
-
-    // write placeholder for position of workplane lut
-    uint8_t dummy_offset[8];
-    ofs_->write((char*)dummy_offset, 8);
-
-    WorkPlaneLUT wp_lut{};
-    for (int i = 0; i < wp.vector_blocks_size(); i++)
-    {
-        uint64_t vb_position = ofs_->tellp();
-        wp_lut.add_vectorblockspositions(vb_position);
-        google::protobuf::util::SerializeDelimitedToOstream(
-            wp.vector_blocks(i),
-            &*ofs_
-        );
-    }
+    FinishWorkPlane();
 
     // copy everything excluding vector blocks to shell object
-    WorkPlane shell_to_write{};
+    WorkPlane shell;
     util::MergeExcluding(
         wp,
-        shell_to_write,
+        shell,
         [](const google::protobuf::FieldDescriptor& fd){return fd.name() == "vector_blocks";}
     );
-    
-    // write next work plane number to shell
-    auto next_work_plane_num = job_shell_->num_work_planes();
-    shell_to_write.set_work_plane_number(next_work_plane_num);
-
-    uint64_t workplane_shell_offset = ofs_->tellp();
-    wp_lut.set_workplaneshellposition(workplane_shell_offset);
-    google::protobuf::util::SerializeDelimitedToOstream(
-        shell_to_write,
-        &*ofs_
-    );
+    shell.set_work_plane_number(job_shell_->num_work_planes());
+    is_work_plane_open_ = true;
 
-    uint64_t workplane_lut_offset = ofs_->tellp();
-    google::protobuf::util::SerializeDelimitedToOstream(
-        wp_lut,
-        &*ofs_
-    );
+    if (pipeline_ == nullptr)
+    {
+        WriteWorkPlaneStart(std::move(shell));
+        return;
+    }
+    pipeline_->Submit(nullptr, [this, shell = std::move(shell)]() mutable { WriteWorkPlaneStart(std::move(shell)); });
+}
 
-    ofs_->seekp(workplane_offset);
-    util::WriteAsLittleEndian(workplane_lut_offset, *ofs_);
-    ofs_->seekp(0, std::ios::end);
+void OvfFileWriter::AddVectorBlock(const VectorBlock& vb, const bool is_borrowed)
+{
+    if (pipeline_ == nullptr)
+    {
+        WriteVectorBlock(vb);
+        return;
+    }
+    if (!is_borrowed)
+    {
+        AddVectorBlock(std::make_unique<VectorBlock>(vb));
+        return;
+    }
+
+    // errors of queued vector blocks are reported by the next append, which aborts the write
+    pipeline_->ThrowIfFailed();
+    if (pending_batch_ == nullptr)
+        pending_batch_ = std::make_shared<VectorBlockBatch>();
+    pending_batch_->vector_blocks.push_back(&vb);
+
+    if (pending_batch_->vector_blocks.size() == kMaxBatchSize)
+        SubmitBatch();
+}
+
+void OvfFileWriter::AddVectorBlock(VectorBlock&& vb)
+{
+    if (pipeline_ == nullptr)
+        WriteVectorBlock(vb);
+    else
+        AddVectorBlock(std::make_unique<VectorBlock>(std::move(vb)));
+}
+
+void OvfFileWriter::AddVectorBlock(std::unique_ptr<VectorBlock> vb)
+{
+    if (pipeline_ == nullptr)
+    {
+        WriteVectorBlock(*vb);
+        return;
+    }
+
+    pipeline_->ThrowIfFailed();
+    if (pending_batch_ == nullptr)
+        pending_batch_ = std::make_shared<VectorBlockBatch>();
+    // the serialized size stands in for the memory of the vector block, and is cached for serializing it
+    const size_t size = DelimitedSize(*vb);
+    pending_batch_->sizes.push_back(size);
+    pending_batch_->owned_size += size;
+    pending_batch_->vector_blocks.push_back(vb.get());
+    pending_batch_->owned_vector_blocks.push_back(std::move(vb));
+
+    if (pending_batch_->vector_blocks.size() == kMaxBatchSize || pending_batch_->owned_size >= max_batch_bytes_)
+        SubmitBatch();
+}
+
+void OvfFileWriter::FinishWorkPlane()
+{
+    if (!is_work_plane_open_)
+        return;
+
+    if (pipeline_ == nullptr)
+    {
+        WriteWorkPlaneEnd();
+    }
+    else
+    {
+        SubmitBatch();
+        pipeline_->Submit(nullptr, [this]{ WriteWorkPlaneEnd(); });
+    }
 
     job_shell_->set_num_work_planes(job_shell_->num_work_planes() + 1);
+    is_work_plane_open_ = false;
 }
 
-void OvfFileWriter::WriteFooter()
+void OvfFileWriter::SubmitBatch()
 {
-    CheckIsWriting();
-    CheckFsHealth();
+    if (pending_batch_ == nullptr)
+        return;
+
+    // the batch is released by the pipeline once it is written
+    std::shared_ptr<VectorBlockBatch> batch = std::move(pending_batch_);
+    pending_batch_ = nullptr;
+    const size_t size = batch->owned_size;
+    pipeline_->Submit(
+        [this, batch]{ return batch->Serialize(checksum_mode_); },
+        [this, batch]{ WriteVectorBlocks(*batch); },
+        size
+    );
+}
+
+void OvfFileWriter::WriteWorkPlaneStart(WorkPlane&& shell)
+{
+    uint64_t workplane_offset = output_file_->offset();
+
+    // the work plane lut offset is only known once the work plane is finished
+    const uint8_t dummy_offset[8] = {};
+    output_file_->Write(dummy_offset, sizeof(dummy_offset));
+
+    // add start offset of this workplane to job lut, once it is written
+    job_lut_->add_workplanepositions(workplane_offset);
+
+    current_wp_.emplace();
+    current_wp_->position = workplane_offset;
+    current_wp_->shell = std::move(shell);
+}
+
+void OvfFileWriter::WriteVectorBlock(const VectorBlock& vb)
+{
+    const uint64_t position = output_file_->offset();
+
+    // serialized in place into the output buffer, unless the vector block is larger
+    const size_t size = DelimitedSize(vb);
+    uint8_t *data = output_file_->WriteInPlace(size);
+    const bool is_in_place = data != nullptr;
+    if (!is_in_place)
+    {
+        serialize_buffer_.resize(size);
+        data = (uint8_t*)serialize_buffer_.data();
+    }
+    SerializeDelimited(vb, data);
+    if (!is_in_place)
+        output_file_->Write(data, size);
+
+    // the position is only added once the vector block is written, so a failed write leaves no trace
+    current_wp_->lut.add_vectorblockspositions(position);
+
+    if (checksum_mode_ != ChecksumMode::kNone)
+        current_wp_->checksum = Crc32c(data, size, current_wp_->checksum);
+
+    // each vector block extends up to the next one or the work plane shell
+    if (checksum_mode_ == ChecksumMode::kVectorBlocks)
+        vector_block_checksums_.push_back(Crc32c(data, size));
+}
 
-    if (current_wp_.has_value())
+void OvfFileWriter::WriteVectorBlocks(const VectorBlockBatch& batch)
+{
+    // the final offsets are only known once all previous vector blocks are written
+    uint64_t position = output_file_->offset();
+    output_file_->Write(batch.serialized.data(), batch.serialized.size());
+
+    for (const size_t size : batch.sizes)
     {
-        WriteFullWorkPlane(*current_wp_);
-        current_wp_ = {};
+        current_wp_->lut.add_vectorblockspositions(position);
+        position += size;
     }
 
-    ofs_->seekp(0, std::ios::end);
+    if (checksum_mode_ != ChecksumMode::kNone)
+        current_wp_->checksum = Crc32cCombine(current_wp_->checksum, batch.checksum, batch.serialized.size());
+
+    if (checksum_mode_ == ChecksumMode::kVectorBlocks)
+        vector_block_checksums_.insert(vector_block_checksums_.end(), batch.checksums.begin(), batch.checksums.end());
+}
+
+void OvfFileWriter::WriteWorkPlaneEnd()
+{
+    WorkPlaneInProgress& wp = *current_wp_;
 
-    uint64_t job_shell_offset = ofs_->tellp();
+    uint64_t workplane_shell_offset = output_file_->offset();
+    wp.lut.set_workplaneshellposition(workplane_shell_offset);
+
+    std::string& buffer = serialize_buffer_;
+    buffer.clear();
+    AppendDelimited(wp.shell, buffer);
+
+    uint64_t workplane_lut_offset = workplane_shell_offset + buffer.size();
+    AppendDelimited(wp.lut, buffer);
+    output_file_->Write(buffer.data(), buffer.size());
+
+    // the placeholder is still buffered for small work planes, otherwise it is written back into the file
+    uint8_t lut_offset_bytes[8];
+    util::WriteAsLittleEndian(workplane_lut_offset, lut_offset_bytes);
+    output_file_->WriteAt(wp.position, lut_offset_bytes, sizeof(lut_offset_bytes));
+
+    if (checksum_mode_ != ChecksumMode::kNone)
+    {
+        // the lut offset precedes all other bytes of the work plane, but is checksummed last
+        const uint32_t checksum = Crc32c((const uint8_t*)buffer.data(), buffer.size(), wp.checksum);
+        const size_t size = (size_t)(output_file_->offset() - wp.position) - sizeof(lut_offset_bytes);
+        work_plane_checksums_.push_back(Crc32cCombine(Crc32c(lut_offset_bytes, sizeof(lut_offset_bytes)), checksum, size));
+    }
+
+    if (checksum_mode_ == ChecksumMode::kVectorBlocks)
+        num_vector_blocks_.push_back((uint32_t)wp.lut.vectorblockspositions_size());
+
+    if (write_index_file_)
+        work_plane_luts_.push_back(std::move(wp.lut));
+
+    current_wp_ = {};
+}
+
+void OvfFileWriter::CheckCanAppendVectorBlock()
+{
+    if (operation_ != FileOperationState::kPartialWrite)
+        throw std::runtime_error{"Trying to append vector block without partial write operation in progress"};
+
+    if (!is_work_plane_open_)
+        throw std::runtime_error("Trying to append vector block before writing first work plane");
+}
+
+void OvfFileWriter::AbortWrite()
+{
+    // no task may refer to the state of the write afterwards
+    if (pipeline_ != nullptr)
+        pipeline_->Wait();
+    pending_batch_ = nullptr;
+    current_wp_ = {};
+    is_work_plane_open_ = false;
+
+    job_shell_ = {};
+    job_lut_ = {};
+    job_lut_offset_offset_ = {};
+    work_plane_luts_.clear();
+    work_plane_checksums_.clear();
+    num_vector_blocks_.clear();
+    vector_block_checksums_.clear();
+
+    // the incomplete file is left behind
+    output_file_.reset();
+    path_ = {};
+
+    operation_ = FileOperationState::kNone;
+}
+
+void OvfFileWriter::WriteFooter()
+{
+    CheckIsWriting();
+    CheckFsHealth();
+
+    FinishWorkPlane();
+    if (pipeline_ != nullptr)
+        pipeline_->Drain();
+
+    uint64_t job_shell_offset = output_file_->offset();
     job_lut_->set_jobshellposition(job_shell_offset);
-    google::protobuf::util::SerializeDelimitedToOstream(
-        *job_shell_,
-        &*ofs_
-    );
+    std::string buffer;
+    AppendDelimited(*job_shell_, buffer);
     job_shell_ = {};
 
-    uint64_t job_lut_offset = ofs_->tellp();
-    ofs_->seekp(*job_lut_offset_offset_);
-    util::WriteAsLittleEndian(job_lut_offset, *ofs_);
+    uint64_t job_lut_offset = job_shell_offset + buffer.size();
+    AppendDelimited(*job_lut_, buffer);
+    output_file_->Write(buffer.data(), buffer.size());
+
+    if (checksum_mode_ != ChecksumMode::kNone)
+    {
+        // the job checksum covers the file header as well, with the final job lut offset
+        uint8_t header[ChecksumSection::kFileHeaderSize];
+        std::copy(kMagicBytes.begin(), kMagicBytes.end(), header);
+        util::WriteAsLittleEndian(job_lut_offset, header + kMagicBytes.size());
+
+        ChecksumSection checksums;
+        checksums.job_checksum = Crc32c((const uint8_t*)buffer.data(), buffer.size(), Crc32c(header, sizeof(header)));
+        checksums.work_plane_checksums = std::move(work_plane_checksums_);
+        checksums.num_vector_blocks = std::move(num_vector_blocks_);
+        checksums.vector_block_checksums = std::move(vector_block_checksums_);
+        checksums.has_vector_block_checksums = checksum_mode_ == ChecksumMode::kVectorBlocks;
+
+        const std::string section = checksums.Serialize(job_shell_offset + buffer.size());
+        output_file_->Write(section.data(), section.size());
+    }
+    work_plane_checksums_.clear();
+    num_vector_blocks_.clear();
+    vector_block_checksums_.clear();
+    std::string{}.swap(serialize_buffer_);
+
+    // small files are still buffered, otherwise the offset is written back into the file
+    uint8_t job_lut_offset_bytes[8];
+    util::WriteAsLittleEndian(job_lut_offset, job_lut_offset_bytes);
+    output_file_->WriteAt(*job_lut_offset_offset_, job_lut_offset_bytes, sizeof(job_lut_offset_bytes));
     job_lut_offset_offset_ = {};
 
-    ofs_->seekp(0, std::ios::end);
-    google::protobuf::util::SerializeDelimitedToOstream(
-        *job_lut_,
-        &*ofs_
-    );
+    if (sync_on_finish_)
+        output_file_->Sync();
+    output_file_->Close();
+    output_file_.reset();
+
+    std::optional<JobIndex> index;
+    if (write_index_file_)
+    {
+        index.emplace(*job_lut_);
+        index->IndexAll([this](int i, WorkPlaneLUT& wpl){ wpl.Swap(&work_plane_luts_[i]); });
+    }
     job_lut_ = {};
+    work_plane_luts_.clear();
 
-    ofs_->flush();
-    ofs_->close();
-    ofs_ = {};
+    // the index file stores size and modification time of the file, so it is written last
+    std::string path = std::move(*path_);
+    path_ = {};
+    if (index.has_value())
+    {
+        try
+        {
+            index->Save(path, job_lut_offset);
+        }
+        catch (const std::runtime_error&)
+        {
+            // the index file only speeds up opening, the written file is complete without it,
+            // and readers read its luts instead of an outdated index file
+        }
+    }
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,220 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <chrono>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "serialization_pipeline.h"
+
+namespace open_vector_format::reader_writer {
+
+SerializationPipeline::SerializationPipeline(const int num_threads, const size_t max_pending_tasks, const size_t max_pending_bytes)
+    : max_pending_tasks_{max_pending_tasks},
+      max_pending_bytes_{max_pending_bytes}
+{
+    if (num_threads < 1 || max_pending_tasks < 1)
+        throw std::runtime_error("Serialization pipeline needs a thread count and task limit of at least one");
+
+    workers_.reserve(num_threads);
+    for (int i = 0; i < num_threads; i++)
+    {
+        workers_.emplace_back(&SerializationPipeline::SerializeTasks, this);
+    }
+    committer_ = std::thread{&SerializationPipeline::CommitTasks, this};
+}
+
+SerializationPipeline::~SerializationPipeline()
+{
+    {
+        std::lock_guard lock{mutex_};
+        is_stopped_ = true;
+    }
+    submitted_.notify_all();
+    serialized_.notify_all();
+
+    for (auto& worker : workers_)
+        worker.join();
+    committer_.join();
+}
+
+void SerializationPipeline::Submit(std::function<size_t()> serialize, std::function<void()> commit, const size_t size)
+{
+    std::unique_lock lock{mutex_};
+    auto can_submit = [&]{
+        return error_ != nullptr || (tasks_.size() < max_pending_tasks_ &&
+            (pending_bytes_ + size <= max_pending_bytes_ || tasks_.empty()));
+    };
+    if (!can_submit())
+    {
+        const auto stall_start = std::chrono::steady_clock::now();
+        committed_.wait(lock, can_submit);
+        statistics_.num_stalls++;
+        statistics_.stall_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - stall_start).count();
+    }
+
+    if (error_ != nullptr)
+        ThrowError(lock);
+
+    tasks_.push_back(Task{std::move(serialize), std::move(commit), size});
+    pending_bytes_ += size;
+    statistics_.peak_queued_bytes = std::max(statistics_.peak_queued_bytes, pending_bytes_);
+    lock.unlock();
+    submitted_.notify_all();
+}
+
+void SerializationPipeline::Drain()
+{
+    std::unique_lock lock{mutex_};
+    committed_.wait(lock, [this]{ return tasks_.empty(); });
+
+    if (error_ != nullptr)
+        ThrowError(lock);
+}
+
+void SerializationPipeline::ThrowIfFailed()
+{
+    if (!has_failed_.load(std::memory_order_relaxed))
+        return;
+
+    std::unique_lock lock{mutex_};
+    if (error_ != nullptr)
+        ThrowError(lock);
+}
+
+void SerializationPipeline::Wait()
+{
+    std::unique_lock lock{mutex_};
+    committed_.wait(lock, [this]{ return tasks_.empty(); });
+    error_ = nullptr;
+    has_failed_ = false;
+}
+
+QueueStatistics SerializationPipeline::GetStatistics() const
+{
+    std::lock_guard lock{mutex_};
+    QueueStatistics statistics = statistics_;
+    statistics.num_queued_tasks = tasks_.size();
+    statistics.queued_bytes = pending_bytes_;
+    return statistics;
+}
+
+void SerializationPipeline::SerializeTasks()
+{
+    std::unique_lock lock{mutex_};
+    while (true)
+    {
+        submitted_.wait(lock, [this]{ return is_stopped_ || next_to_serialize_ < first_task_ + tasks_.size(); });
+        if (is_stopped_)
+            return;
+
+        Task& task = tasks_[next_to_serialize_ - first_task_];
+        next_to_serialize_++;
+
+        if (task.serialize && error_ == nullptr)
+        {
+            lock.unlock();
+            std::exception_ptr error;
+            size_t size = task.size;
+            try
+            {
+                size = task.serialize();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            lock.lock();
+
+            pending_bytes_ = pending_bytes_ - task.size + size;
+            task.size = size;
+            statistics_.peak_queued_bytes = std::max(statistics_.peak_queued_bytes, pending_bytes_);
+            if (error != nullptr)
+                SetError(error);
+        }
+
+        task.is_serialized = true;
+        serialized_.notify_all();
+    }
+}
+
+void SerializationPipeline::CommitTasks()
+{
+    std::unique_lock lock{mutex_};
+    while (true)
+    {
+        serialized_.wait(lock, [this]{ return is_stopped_ || (!tasks_.empty() && tasks_.front().is_serialized); });
+        if (is_stopped_)
+            return;
+
+        Task& task = tasks_.front();
+        if (task.commit && error_ == nullptr)
+        {
+            lock.unlock();
+            std::exception_ptr error;
+            try
+            {
+                task.commit();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+            lock.lock();
+
+            if (error != nullptr)
+                SetError(error);
+        }
+
+        pending_bytes_ -= task.size;
+        tasks_.pop_front();
+        first_task_++;
+        committed_.notify_all();
+    }
+}
+
+void SerializationPipeline::SetError(std::exception_ptr error)
+{
+    if (error_ != nullptr)
+        return;
+
+    error_ = error;
+    has_failed_ = true;
+    // submitters blocked on a full queue rethrow the error
+    committed_.notify_all();
+}
+
+void SerializationPipeline::ThrowError(std::unique_lock<std::mutex>& lock)
+{
+    // pending tasks are skipped, they must not outlive the data of the caller
+    committed_.wait(lock, [this]{ return tasks_.empty(); });
+    std::rethrow_exception(error_);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,334 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <limits>
+#include <algorithm>
+#include <initializer_list>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define OVF_HAS_SSE2
+#endif
+
+#include "spatial_index.h"
+
+namespace open_vector_format::reader_writer {
+
+namespace {
+
+/**
+ * @brief Scalar kernel of ComputePointBounds(), also used for the remainder of the SIMD kernels.
+ */
+void ExtendByPoints(BoundingBox& box, const float *points, const size_t count, const int dimensions)
+{
+    for (size_t i = 0; i + dimensions <= count; i += dimensions)
+    {
+        const float x = points[i];
+        const float y = points[i + 1];
+
+        // comparisons with NaN are false, so NaN coordinates are skipped
+        if (x < box.x_min) box.x_min = x;
+        if (x > box.x_max) box.x_max = x;
+        if (y < box.y_min) box.y_min = y;
+        if (y > box.y_max) box.y_max = y;
+    }
+}
+
+#ifdef OVF_HAS_SSE2
+
+/** Smallest and largest of the given lanes of the accumulators. */
+inline float MinOfLanes(const float *lanes, std::initializer_list<int> indices)
+{
+    float result = std::numeric_limits<float>::infinity();
+    for (int i : indices)
+        result = std::min(result, lanes[i]);
+    return result;
+}
+
+inline float MaxOfLanes(const float *lanes, std::initializer_list<int> indices)
+{
+    float result = -std::numeric_limits<float>::infinity();
+    for (int i : indices)
+        result = std::max(result, lanes[i]);
+    return result;
+}
+
+/**
+ * @brief SIMD kernel for 2D points, processing 4 points per iteration.
+ * 
+ * Lanes alternate between x and y, so both are reduced at once.
+ * 
+ * @return size_t The number of coordinates processed.
+ */
+size_t ExtendByPoints2D(BoundingBox& box, const float *points, const size_t count)
+{
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128 neg_inf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    __m128 min0 = inf, min1 = inf;
+    __m128 max0 = neg_inf, max1 = neg_inf;
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128 a = _mm_loadu_ps(points + i);
+        const __m128 b = _mm_loadu_ps(points + i + 4);
+
+        // minps and maxps return the second operand if either is NaN, which skips NaN coordinates
+        min0 = _mm_min_ps(a, min0);
+        min1 = _mm_min_ps(b, min1);
+        max0 = _mm_max_ps(a, max0);
+        max1 = _mm_max_ps(b, max1);
+    }
+
+    alignas(16) float mins[4], maxs[4];
+    _mm_store_ps(mins, _mm_min_ps(min0, min1));
+    _mm_store_ps(maxs, _mm_max_ps(max0, max1));
+
+    box.Extend(BoundingBox{
+        MinOfLanes(mins, {0, 2}), MinOfLanes(mins, {1, 3}),
+        MaxOfLanes(maxs, {0, 2}), MaxOfLanes(maxs, {1, 3})
+    });
+    return i;
+}
+
+/**
+ * @brief SIMD kernel for 3D points, processing 4 points per iteration.
+ * 
+ * The 12 coordinates of 4 points fill 3 registers, in which x, y and z rotate through
+ * the lanes. Each register is reduced separately, and the lanes are sorted out in the end.
+ * 
+ * @return size_t The number of coordinates processed.
+ */
+size_t ExtendByPoints3D(BoundingBox& box, const float *points, const size_t count)
+{
+    const __m128 inf = _mm_set1_ps(std::numeric_limits<float>::infinity());
+    const __m128 neg_inf = _mm_set1_ps(-std::numeric_limits<float>::infinity());
+    __m128 min0 = inf, min1 = inf, min2 = inf;
+    __m128 max0 = neg_inf, max1 = neg_inf, max2 = neg_inf;
+
+    size_t i = 0;
+    for (; i + 12 <= count; i += 12)
+    {
+        const __m128 a = _mm_loadu_ps(points + i);      // x0 y0 z0 x1
+        const __m128 b = _mm_loadu_ps(points + i + 4);  // y1 z1 x2 y2
+        const __m128 c = _mm_loadu_ps(points + i + 8);  // z2 x3 y3 z3
+
+        min0 = _mm_min_ps(a, min0);
+        min1 = _mm_min_ps(b, min1);
+        min2 = _mm_min_ps(c, min2);
+        max0 = _mm_max_ps(a, max0);
+        max1 = _mm_max_ps(b, max1);
+        max2 = _mm_max_ps(c, max2);
+    }
+
+    // lanes of all three registers, in the order of the coordinates above
+    alignas(16) float mins[12], maxs[12];
+    _mm_store_ps(mins, min0);
+    _mm_store_ps(mins + 4, min1);
+    _mm_store_ps(mins + 8, min2);
+    _mm_store_ps(maxs, max0);
+    _mm_store_ps(maxs + 4, max1);
+    _mm_store_ps(maxs + 8, max2);
+
+    box.Extend(BoundingBox{
+        MinOfLanes(mins, {0, 3, 6, 9}), MinOfLanes(mins, {1, 4, 7, 10}),
+        MaxOfLanes(maxs, {0, 3, 6, 9}), MaxOfLanes(maxs, {1, 4, 7, 10})
+    });
+    return i;
+}
+
+#endif
+
+/**
+ * @brief Position of a point along a Hilbert curve through a 2^16 x 2^16 grid.
+ */
+uint32_t HilbertIndex(uint32_t x, uint32_t y)
+{
+    const uint32_t n = 1u << 16;
+    uint32_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2)
+    {
+        const uint32_t rx = (x & s) > 0 ? 1 : 0;
+        const uint32_t ry = (y & s) > 0 ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+
+        // rotate the quadrant, so that the curve stays continuous, without branches,
+        // as they are mispredicted for scattered boxes: mirror if rx == 1 and ry == 0,
+        // i.e. x = n - 1 - x, then swap x and y if ry == 0
+        const uint32_t mirror = (0u - (rx & (ry ^ 1))) & (n - 1);
+        x ^= mirror;
+        y ^= mirror;
+        const uint32_t swap = (x ^ y) & (0u - (ry ^ 1));
+        x ^= swap;
+        y ^= swap;
+    }
+    return d;
+}
+
+}
+
+BoundingBox ComputePointBounds(Span<const float> points, const int dimensions)
+{
+    if (dimensions != 2 && dimensions != 3)
+        throw std::runtime_error("Points need 2 or 3 dimensions");
+
+    BoundingBox box{};
+    size_t processed = 0;
+
+#ifdef OVF_HAS_SSE2
+    if (dimensions == 2)
+        processed = ExtendByPoints2D(box, points.data(), points.size());
+    else
+        processed = ExtendByPoints3D(box, points.data(), points.size());
+#endif
+
+    ExtendByPoints(box, points.data() + processed, points.size() - processed, dimensions);
+    return box;
+}
+
+BoundingBoxTree::BoundingBoxTree(std::vector<BoundingBox> boxes)
+    : boxes_{std::move(boxes)}
+{
+    std::vector<int> bounded;
+    BoundingBox extent{};
+    for (int i = 0; i < (int)boxes_.size(); i++)
+    {
+        if (boxes_[i].is_empty())
+            continue;
+
+        if (boxes_[i].is_unbounded())
+        {
+            unbounded_.push_back(i);
+            continue;
+        }
+
+        bounded.push_back(i);
+        extent.Extend(boxes_[i]);
+    }
+
+    if (bounded.empty())
+        return;
+
+    // sort along the Hilbert curve, so that nearby boxes end up in the same nodes
+    const float scale_x = extent.x_max > extent.x_min ? 65535.0f / (extent.x_max - extent.x_min) : 0.0f;
+    const float scale_y = extent.y_max > extent.y_min ? 65535.0f / (extent.y_max - extent.y_min) : 0.0f;
+
+    // the Hilbert index in the upper and the box index in the lower half, so that plain integers are sorted
+    std::vector<uint64_t> keys;
+    keys.reserve(bounded.size());
+    for (int i : bounded)
+    {
+        const auto& box = boxes_[i];
+        const float center_x = 0.5f * (box.x_min + box.x_max) - extent.x_min;
+        const float center_y = 0.5f * (box.y_min + box.y_max) - extent.y_min;
+        const uint32_t hilbert_index = HilbertIndex(
+            (uint32_t)std::clamp(center_x * scale_x, 0.0f, 65535.0f),
+            (uint32_t)std::clamp(center_y * scale_y, 0.0f, 65535.0f)
+        );
+        keys.push_back(((uint64_t)hilbert_index << 32) | (uint32_t)i);
+    }
+    std::sort(keys.begin(), keys.end());
+    for (size_t i = 0; i < keys.size(); i++)
+        bounded[i] = (int)(uint32_t)keys[i];
+
+    // leaves, followed by the levels of inner nodes up to the root
+    size_t num_nodes = bounded.size();
+    for (size_t level_size = bounded.size(); level_size > 1; )
+    {
+        level_size = (level_size + kNodeSize - 1) / kNodeSize;
+        num_nodes += level_size;
+    }
+    nodes_.reserve(num_nodes);
+    node_children_.reserve(num_nodes);
+
+    for (int i : bounded)
+    {
+        nodes_.push_back(boxes_[i]);
+        node_children_.push_back(i);
+    }
+    level_ends_.push_back(nodes_.size());
+
+    size_t level_start = 0;
+    while (nodes_.size() - level_start > 1)
+    {
+        const size_t level_end = nodes_.size();
+        for (size_t first_child = level_start; first_child < level_end; first_child += kNodeSize)
+        {
+            BoundingBox node{};
+            const size_t last_child = std::min(first_child + kNodeSize, level_end);
+            for (size_t child = first_child; child < last_child; child++)
+                node.Extend(nodes_[child]);
+
+            nodes_.push_back(node);
+            node_children_.push_back((int)first_child);
+        }
+
+        level_start = level_end;
+        level_ends_.push_back(nodes_.size());
+    }
+}
+
+void BoundingBoxTree::Query(const BoundingBox& region, std::vector<int>& i_vector_blocks) const
+{
+    i_vector_blocks.clear();
+    if (region.is_empty())
+        return;
+
+    i_vector_blocks.insert(i_vector_blocks.end(), unbounded_.begin(), unbounded_.end());
+
+    if (!nodes_.empty())
+    {
+        // positions of the nodes to visit, along with their level
+        std::vector<std::pair<size_t, size_t>> stack;
+        stack.emplace_back(nodes_.size() - 1, level_ends_.size() - 1);
+
+        while (!stack.empty())
+        {
+            const auto [node, level] = stack.back();
+            stack.pop_back();
+
+            if (!nodes_[node].Intersects(region))
+                continue;
+
+            if (level == 0)
+            {
+                i_vector_blocks.push_back(node_children_[node]);
+                continue;
+            }
+
+            const size_t first_child = (size_t)node_children_[node];
+            const size_t last_child = std::min(first_child + kNodeSize, level_ends_[level - 1]);
+            for (size_t child = first_child; child < last_child; child++)
+                stack.emplace_back(child, level - 1);
+        }
+    }
+
+    std::sort(i_vector_blocks.begin(), i_vector_blocks.end());
+}
+
+}
\ No newline at end of file
@@ -26,8 +26,13 @@ SOFTWARE.
 ---- Copyright End ----
 */
 
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+
 #include "util.h"
 #include "google/protobuf/message.h"
+#include "open_vector_format.pb.h"
 
 namespace open_vector_format::util {
 
@@ -44,7 +49,7 @@ namespace open_vector_format::util {
                 target.GetReflection()->Set##___function_suffix___( \
                     &(___target___), \
                     (___target___).GetDescriptor()->FindFieldByNumber((___field___)->number()), \
-                    (___source___).GetReflection()->Get##___function_suffix___((___target___), (___field___)) \
+                    (___source___).GetReflection()->Get##___function_suffix___((___source___), (___field___)) \
                 ); \
                 break; \
             }
@@ -104,7 +109,7 @@ void CopyField(const google::protobuf::Message& source,
                     target_refl__->Add##___function_suffix___( \
                         &(___target___), \
                         target_desc__->FindFieldByNumber((___field___)->number()), \
-                        source_refl__->GetRepeated##___function_suffix___((___target___), (___field___), i__) \
+                        source_refl__->GetRepeated##___function_suffix___((___source___), (___field___), i__) \
                     ); \
                 } \
                 break; \
@@ -151,4 +156,37 @@ void CopyRepeatedField(const google::protobuf::Message& source,
 
 #undef CASE_ADD_TO_REPEATED_FIELD
 
+bool IsVectorDataField(const int field_number)
+{
+    static const std::vector<bool> is_vector_data = [](){
+        std::vector<bool> result;
+        auto oneof = VectorBlock::descriptor()->FindOneofByName("vector_data");
+        for (int i = 0; oneof != nullptr && i < oneof->field_count(); i++)
+        {
+            auto number = (size_t)oneof->field(i)->number();
+            if (result.size() <= number)
+                result.resize(number + 1, false);
+            result[number] = true;
+        }
+        return result;
+    }();
+
+    return field_number >= 0 && (size_t)field_number < is_vector_data.size() && is_vector_data[field_number];
+}
+
+bool GetFileStamp(const std::string& path, uint64_t& file_size, int64_t& file_time)
+{
+    std::error_code ec;
+    file_size = (uint64_t)std::filesystem::file_size(path, ec);
+    if (ec)
+        return false;
+
+    auto write_time = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return false;
+
+    file_time = std::chrono::duration_cast<std::chrono::nanoseconds>(write_time.time_since_epoch()).count();
+    return true;
+}
+
 }
\ No newline at end of file
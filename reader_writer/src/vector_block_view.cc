@@ -0,0 +1,243 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/wire_format_lite.h"
+
+#include "vector_block_view.h"
+#include "util.h"
+
+namespace open_vector_format::reader_writer {
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace {
+
+/**
+ * @brief Appends little endian encoded floats to a buffer.
+ */
+void AppendLittleEndianFloats(std::vector<float>& buffer, Span<const uint8_t> bytes)
+{
+    const size_t count = bytes.size() / sizeof(float);
+    const size_t offset = buffer.size();
+    buffer.resize(offset + count);
+    if (!util::IsSystemBigEndian())
+    {
+        std::memcpy(buffer.data() + offset, bytes.data(), count * sizeof(float));
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t value;
+        util::ReadFromLittleEndian(value, const_cast<uint8_t*>(bytes.data()) + i * sizeof(float));
+        std::memcpy(&buffer[offset + i], &value, sizeof(float));
+    }
+}
+
+}
+
+VectorBlockView::VectorBlockView(FileView view)
+    : view_{std::move(view)}
+{
+    CodedInputStream input{
+        view_.data(),
+        (int)std::min<size_t>(view_.size(), std::numeric_limits<int>::max())
+    };
+
+    uint32_t length;
+    if (!input.ReadVarint32(&length) || length > view_.size() - input.CurrentPosition())
+        throw std::runtime_error("Vector block exceeds the file view, file might be corrupted");
+
+    const uint8_t *message_start = view_.data() + input.CurrentPosition();
+    message_ = Span<const uint8_t>{message_start, length};
+    input.PushLimit((int)length);
+
+    while (uint32_t tag = input.ReadTag())
+    {
+        const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+        const auto wire_type = WireFormatLite::GetTagWireType(tag);
+        bool ok = true;
+
+        if (wire_type == WireFormatLite::WIRETYPE_VARINT &&
+            (field_number == VectorBlock::kMarkingParamsKeyFieldNumber ||
+             field_number == VectorBlock::kLaserIndexFieldNumber ||
+             field_number == VectorBlock::kRepeatsFieldNumber))
+        {
+            uint64_t value;
+            ok = input.ReadVarint64(&value);
+            if (field_number == VectorBlock::kMarkingParamsKeyFieldNumber)
+                marking_params_key_ = (int32_t)value;
+            else if (field_number == VectorBlock::kLaserIndexFieldNumber)
+                laser_index_ = (int32_t)value;
+            else
+                repeats_ = value;
+        }
+        else if (wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED && util::IsVectorDataField(field_number))
+        {
+            // one of the vector data types, oneof case values equal the field numbers
+            vector_data_case_ = static_cast<VectorBlock::VectorDataCase>(field_number);
+            point_dimensions_ = 0;
+            raw_points_ = {};
+            points_ = {};
+            points_buffer_.clear();
+
+            uint32_t data_length;
+            ok = input.ReadVarint32(&data_length) && (int)data_length <= input.BytesUntilLimit();
+            if (!ok)
+                throw std::runtime_error("Scanning vector block failed, file might be corrupted");
+
+            const uint8_t *data_start = view_.data() + input.CurrentPosition();
+
+            switch (field_number)
+            {
+                case VectorBlock::kLineSequenceFieldNumber:
+                case VectorBlock::kHatchesFieldNumber:
+                case VectorBlock::kPointSequenceFieldNumber:
+                    ScanVectorData(data_start, (int)data_length, 2);
+                    break;
+                case VectorBlock::kLineSequence3DFieldNumber:
+                case VectorBlock::kHatches3DFieldNumber:
+                case VectorBlock::kPointSequence3DFieldNumber:
+                    ScanVectorData(data_start, (int)data_length, 3);
+                    break;
+                default:
+                    break;
+            }
+
+            ok = input.Skip((int)data_length);
+        }
+        else
+        {
+            ok = WireFormatLite::SkipField(&input, tag);
+        }
+
+        if (!ok)
+            throw std::runtime_error("Scanning vector block failed, file might be corrupted");
+    }
+
+    if (!input.ConsumedEntireMessage())
+        throw std::runtime_error("Scanning vector block failed, file might be corrupted");
+}
+
+void VectorBlockView::ScanVectorData(const uint8_t *data, int size, int dimensions)
+{
+    // all supported vector data types store their coordinates in field 1
+    static_assert(VectorBlock::LineSequence::kPointsFieldNumber == 1);
+    static_assert(VectorBlock::Hatches::kPointsFieldNumber == 1);
+    static_assert(VectorBlock::PointSequence::kPointsFieldNumber == 1);
+
+    point_dimensions_ = dimensions;
+
+    // coordinates are copied if they are split into multiple chunks or not packed
+    bool is_buffered = false;
+
+    CodedInputStream input{data, size};
+    while (uint32_t tag = input.ReadTag())
+    {
+        const int field_number = WireFormatLite::GetTagFieldNumber(tag);
+        const auto wire_type = WireFormatLite::GetTagWireType(tag);
+        bool ok = true;
+
+        if (field_number == 1 && wire_type == WireFormatLite::WIRETYPE_LENGTH_DELIMITED)
+        {
+            // packed encoding, the regular case
+            uint32_t length;
+            ok = input.ReadVarint32(&length) && length % sizeof(float) == 0 && length <= (uint32_t)(size - input.CurrentPosition());
+            if (ok)
+            {
+                Span<const uint8_t> chunk{data + input.CurrentPosition(), length};
+                if (!is_buffered && raw_points_.empty())
+                {
+                    raw_points_ = chunk;
+                }
+                else
+                {
+                    if (!is_buffered)
+                        AppendLittleEndianFloats(points_buffer_, raw_points_);
+                    AppendLittleEndianFloats(points_buffer_, chunk);
+                    is_buffered = true;
+                }
+                ok = input.Skip((int)length);
+            }
+        }
+        else if (field_number == 1 && wire_type == WireFormatLite::WIRETYPE_FIXED32)
+        {
+            // unpacked encoding, valid but unusual
+            if (!is_buffered)
+                AppendLittleEndianFloats(points_buffer_, raw_points_);
+            is_buffered = true;
+
+            uint32_t value;
+            ok = input.ReadLittleEndian32(&value);
+            float f;
+            std::memcpy(&f, &value, sizeof(f));
+            points_buffer_.push_back(f);
+        }
+        else
+        {
+            ok = WireFormatLite::SkipField(&input, tag);
+        }
+
+        if (!ok)
+            throw std::runtime_error("Scanning vector data failed, file might be corrupted");
+    }
+
+    if (is_buffered)
+    {
+        raw_points_ = {};
+        points_ = Span<const float>{points_buffer_};
+        return;
+    }
+
+    const bool aligned = reinterpret_cast<uintptr_t>(raw_points_.data()) % alignof(float) == 0;
+
+    if (aligned && !util::IsSystemBigEndian())
+    {
+        points_ = Span<const float>{reinterpret_cast<const float*>(raw_points_.data()), raw_points_.size() / sizeof(float)};
+    }
+    else
+    {
+        AppendLittleEndianFloats(points_buffer_, raw_points_);
+        points_ = Span<const float>{points_buffer_};
+    }
+}
+
+void VectorBlockView::Parse(VectorBlock& vb) const
+{
+    if (!vb.ParseFromArray(message_.data(), (int)message_.size()))
+        throw std::runtime_error("Parsing VectorBlock failed, file might be corrupted");
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#include <stdexcept>
+
+#include "work_plane_stream.h"
+
+namespace open_vector_format::reader_writer {
+
+WorkPlaneStream::WorkPlaneStream(const OvfFileReader& reader, const WorkPlaneStreamOptions& options)
+    : reader_{reader},
+      end_{options.num_work_planes < 0
+          ? reader.GetNumWorkPlanes()
+          : options.first_work_plane + options.num_work_planes},
+      look_ahead_{options.look_ahead},
+      release_decoded_{options.release_decoded},
+      next_to_consume_{options.first_work_plane},
+      next_to_decode_{options.first_work_plane}
+{
+    if (options.look_ahead < 1 || options.num_threads < 1)
+        throw std::runtime_error("Work plane stream needs a look ahead and thread count of at least one");
+
+    if (options.first_work_plane < 0 || end_ > reader.GetNumWorkPlanes() || end_ < options.first_work_plane)
+        throw std::runtime_error("Invalid work plane range");
+
+    slots_ = std::vector<Slot>(look_ahead_);
+
+    threads_.reserve(options.num_threads);
+    for (int i = 0; i < options.num_threads; i++)
+    {
+        threads_.emplace_back(&WorkPlaneStream::DecodeWorkPlanes, this);
+    }
+}
+
+WorkPlaneStream::~WorkPlaneStream()
+{
+    {
+        std::lock_guard lock{mutex_};
+        is_stopped_ = true;
+    }
+    consumed_.notify_all();
+
+    for (auto& thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+bool WorkPlaneStream::Next(WorkPlane& wp)
+{
+    std::unique_lock lock{mutex_};
+
+    if (next_to_consume_ >= end_)
+        return false;
+
+    auto& slot = slots_[next_to_consume_ % look_ahead_];
+    decoded_.wait(lock, [&](){return slot.is_ready;});
+
+    // hand over the decoded work plane, the slot recycles the previous one
+    std::exception_ptr error = slot.error;
+    if (error == nullptr)
+        wp.Swap(&slot.wp);
+
+    slot.error = nullptr;
+    slot.is_ready = false;
+    next_to_consume_++;
+
+    lock.unlock();
+    consumed_.notify_all();
+
+    if (error != nullptr)
+        std::rethrow_exception(error);
+
+    return true;
+}
+
+int WorkPlaneStream::next_work_plane() const
+{
+    std::lock_guard lock{mutex_};
+    return next_to_consume_;
+}
+
+void WorkPlaneStream::DecodeWorkPlanes()
+{
+    std::unique_lock lock{mutex_};
+
+    while (true)
+    {
+        // wait until a slot is free, i.e. the consumer is less than look_ahead_ work planes behind
+        consumed_.wait(lock, [&](){
+            return is_stopped_ || next_to_decode_ >= end_ || next_to_decode_ < next_to_consume_ + look_ahead_;
+        });
+
+        if (is_stopped_ || next_to_decode_ >= end_)
+            return;
+
+        const int i_work_plane = next_to_decode_++;
+        auto& slot = slots_[i_work_plane % look_ahead_];
+
+        // the slot is exclusively owned by this thread until it is marked ready
+        lock.unlock();
+        try
+        {
+            reader_.GetWorkPlane(i_work_plane, slot.wp);
+            if (release_decoded_)
+                reader_.ReleaseWorkPlanes(i_work_plane);
+        }
+        catch (...)
+        {
+            slot.error = std::current_exception();
+        }
+        lock.lock();
+
+        slot.is_ready = true;
+        decoded_.notify_all();
+    }
+}
+
+}
\ No newline at end of file
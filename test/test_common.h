@@ -0,0 +1,59 @@
+/*
+---- Copyright Start ----
+
+MIT License
+
+Copyright (c) 2022 Digital-Production-Aachen
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+---- Copyright End ----
+*/
+
+#pragma once
+
+#include "open_vector_format.pb.h"
+
+namespace ovf_test {
+
+namespace ovf = open_vector_format;
+
+/** Creates a small job with distinguishable coordinates in every vector block. */
+inline ovf::Job MakeTestJob(int num_work_planes = 3, int num_vector_blocks = 4)
+{
+    ovf::Job job{};
+    job.mutable_job_meta_data()->set_job_name("roundtrip");
+    job.set_num_work_planes(num_work_planes);
+    for (int i_wp = 0; i_wp < num_work_planes; i_wp++)
+    {
+        auto wp = job.add_work_planes();
+        wp->set_z_pos_in_mm(0.1f * i_wp);
+        for (int i_vb = 0; i_vb < num_vector_blocks; i_vb++)
+        {
+            auto vb = wp->add_vector_blocks();
+            vb->set_laser_index(i_vb % 2);
+            vb->set_marking_params_key(i_vb);
+            for (int i_pt = 0; i_pt < 200 * (i_vb + 1); i_pt++)
+                vb->mutable_line_sequence()->add_points((float)(i_wp * 1000 + i_vb * 100 + i_pt));
+        }
+    }
+    return job;
+}
+
+}
\ No newline at end of file
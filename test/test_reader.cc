@@ -27,12 +27,27 @@ SOFTWARE.
 */
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <chrono>
 
 #include "google/protobuf/util/message_differencer.h"
 
 #include "ovf_reader_writer_export.h"
 #include "open_vector_format.pb.h"
 #include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "work_plane_stream.h"
+#include "util.h"
+
+#include "test_common.h"
 
 namespace ovf = open_vector_format;
 
@@ -62,4 +77,1367 @@ TEST_CASE( "", "[reader]" ) {
         reader.CloseFile();
         REQUIRE( !reader.IsFileOpen() );
     }
+}
+
+TEST_CASE( "reads back jobs written by OvfFileWriter", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_roundtrip.ovf").string();
+
+    auto job = ovf_test::MakeTestJob();
+
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    auto access_pattern = GENERATE(
+        ovf::reader_writer::AccessPattern::kNormal,
+        ovf::reader_writer::AccessPattern::kSequential,
+        ovf::reader_writer::AccessPattern::kRandom
+    );
+
+    auto mapping_mode = GENERATE(
+        ovf::reader_writer::MappingMode::kPersistent,
+        ovf::reader_writer::MappingMode::kWindowed,
+        ovf::reader_writer::MappingMode::kPerView
+    );
+
+    auto io_backend = GENERATE(
+        ovf::reader_writer::IoBackend::kMemoryMapping,
+        ovf::reader_writer::IoBackend::kBufferedRead
+    );
+
+    ovf::reader_writer::MappingOptions mapping_options{};
+    mapping_options.access_pattern = access_pattern;
+    mapping_options.mode = mapping_mode;
+    mapping_options.window_size = 1; // rounded up to a single page, forces multiple windows
+    mapping_options.io_backend = io_backend;
+
+    ovf::reader_writer::OvfFileReader reader{0}; // read everything from the mapping
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell, mapping_options);
+
+    REQUIRE( reader.IsFileOpen() );
+    REQUIRE( job_shell.job_meta_data().job_name() == "roundtrip" );
+    REQUIRE( job_shell.num_work_planes() == 3 );
+
+    for (int i_wp = 0; i_wp < 3; i_wp++)
+    {
+        ovf::WorkPlane wp{};
+        reader.GetWorkPlane(i_wp, wp);
+        REQUIRE( wp.vector_blocks_size() == 4 );
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(
+            wp.vector_blocks(3), job.work_planes(i_wp).vector_blocks(3)) );
+
+        ovf::VectorBlock vb{};
+        reader.GetVectorBlock(i_wp, 2, vb);
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vb, job.work_planes(i_wp).vector_blocks(2)) );
+    }
+
+    ovf::VectorBlock vb{};
+    REQUIRE_THROWS_AS( reader.GetVectorBlock(3, 0, vb), std::runtime_error );
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE( "merges all fields of a message except excluded ones", "[util]" ) {
+    auto job = ovf_test::MakeTestJob(1, 2);
+    const ovf::WorkPlane& wp = job.work_planes(0);
+
+    // scalar fields are read from the source, the target starts out empty
+    ovf::WorkPlane shell{};
+    shell.set_repeats(3);
+    auto wp_source = wp;
+    wp_source.set_z_pos_in_mm(2.5f);
+    wp_source.set_work_plane_number(7);
+    ovf::util::MergeExcluding(
+        wp_source,
+        shell,
+        [](const google::protobuf::FieldDescriptor& fd){return fd.name() == "vector_blocks";}
+    );
+    REQUIRE( shell.z_pos_in_mm() == 2.5f );
+    REQUIRE( shell.work_plane_number() == 7 );
+    REQUIRE( shell.repeats() == 3 );
+    REQUIRE( shell.vector_blocks_size() == 0 );
+
+    // repeated fields are copied element by element
+    ovf::VectorBlock::LineSequence points{};
+    ovf::util::MergeExcluding(
+        wp.vector_blocks(1).line_sequence(),
+        points,
+        [](const google::protobuf::FieldDescriptor&){return false;}
+    );
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equals(points, wp.vector_blocks(1).line_sequence()) );
+}
+
+
+TEST_CASE( "provides zero-copy views of vector blocks", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_view.ovf").string();
+
+    auto job = ovf_test::MakeTestJob();
+    auto point_block = job.mutable_work_planes(1)->add_vector_blocks();
+    point_block->set_laser_index(3);
+    for (int i = 0; i < 9; i++)
+        point_block->mutable_point_sequence()->add_points(0.5f * i);
+    job.mutable_work_planes(1)->add_vector_blocks()->set_marking_params_key(7);
+
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::OvfFileReader reader{};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+
+    for (int i_wp = 0; i_wp < job.work_planes_size(); i_wp++)
+    {
+        const auto& wp = job.work_planes(i_wp);
+        for (int i_vb = 0; i_vb < wp.vector_blocks_size(); i_vb++)
+        {
+            const auto& expected = wp.vector_blocks(i_vb);
+            auto view = reader.GetVectorBlockView(i_wp, i_vb);
+
+            REQUIRE( view.vector_data_case() == expected.vector_data_case() );
+            REQUIRE( view.marking_params_key() == expected.marking_params_key() );
+            REQUIRE( view.laser_index() == expected.laser_index() );
+
+            const google::protobuf::RepeatedField<float>* expected_points = nullptr;
+            if (expected.has_line_sequence())
+                expected_points = &expected.line_sequence().points();
+            else if (expected.has_point_sequence())
+                expected_points = &expected.point_sequence().points();
+
+            REQUIRE( view.has_points() == (expected_points != nullptr) );
+            if (expected_points != nullptr)
+            {
+                REQUIRE( view.point_dimensions() == 2 );
+                REQUIRE( view.points().size() == (size_t)expected_points->size() );
+                REQUIRE( std::equal(view.points().begin(), view.points().end(), expected_points->begin()) );
+                REQUIRE( view.raw_points().size() == view.points().size() * sizeof(float) );
+            }
+
+            ovf::VectorBlock parsed{};
+            view.Parse(parsed);
+            REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(parsed, expected) );
+        }
+    }
+
+    REQUIRE_THROWS_AS( reader.GetVectorBlockView(1, 6), std::runtime_error );
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+TEST_CASE( "reads into arena allocated messages", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_arena.ovf").string();
+
+    auto job = ovf_test::MakeTestJob();
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::OvfFileReader reader{};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+
+    google::protobuf::Arena arena{};
+    for (int i_wp = 0; i_wp < job.work_planes_size(); i_wp++)
+    {
+        auto wp = reader.GetWorkPlane(i_wp, arena);
+        REQUIRE( wp->GetArena() == &arena );
+        ovf::WorkPlane expected{};
+        reader.GetWorkPlane(i_wp, expected);
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(*wp, expected) );
+        REQUIRE( wp->vector_blocks_size() == job.work_planes(i_wp).vector_blocks_size() );
+
+        auto wp_shell = reader.GetWorkPlaneShell(i_wp, arena);
+        REQUIRE( wp_shell->vector_blocks_size() == 0 );
+
+        auto vb = reader.GetVectorBlock(i_wp, 1, arena);
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(*vb, job.work_planes(i_wp).vector_blocks(1)) );
+    }
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "reads selections and ranges of vector blocks", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_batch.ovf").string();
+
+    auto job = ovf_test::MakeTestJob();
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::MappingOptions mapping_options{};
+    mapping_options.io_backend = GENERATE(
+        ovf::reader_writer::IoBackend::kMemoryMapping,
+        ovf::reader_writer::IoBackend::kBufferedRead
+    );
+
+    ovf::reader_writer::OvfFileReader reader{};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell, mapping_options);
+
+    bool cached = GENERATE(false, true);
+    if (cached)
+        reader.CacheFullJob();
+    else
+        reader.ClearCache();
+
+    const auto& expected = job.work_planes(1).vector_blocks();
+    google::protobuf::RepeatedPtrField<ovf::VectorBlock> vbs;
+
+    const std::vector<int> indices{3, 0, 2, 0};
+    reader.GetVectorBlocks(1, indices, vbs);
+    REQUIRE( vbs.size() == 4 );
+    for (int i = 0; i < 4; i++)
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vbs.Get(i), expected.Get(indices[i])) );
+
+    reader.GetVectorBlocks(1, 1, 3, vbs);
+    REQUIRE( vbs.size() == 3 );
+    for (int i = 0; i < 3; i++)
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vbs.Get(i), expected.Get(i + 1)) );
+
+    reader.GetVectorBlocks(1, 0, 0, vbs);
+    REQUIRE( vbs.empty() );
+
+    REQUIRE_THROWS_AS( reader.GetVectorBlocks(1, 2, 3, vbs), std::runtime_error );
+    const std::vector<int> invalid_indices{0, 4};
+    REQUIRE_THROWS_AS( reader.GetVectorBlocks(1, invalid_indices, vbs), std::runtime_error );
+    REQUIRE_THROWS_AS( reader.GetVectorBlocks(3, 0, 1, vbs), std::runtime_error );
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "reads vector block headers without vector data", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_headers.ovf").string();
+
+    auto job = ovf_test::MakeTestJob();
+    auto wp = job.mutable_work_planes(1);
+    wp->mutable_vector_blocks(0)->set_repeats(3);
+    wp->mutable_vector_blocks(1)->mutable_meta_data()->set_part_key(42);
+    wp->mutable_vector_blocks(1)->mutable_meta_data()->set_total_scan_distance_in_mm(1.5f);
+    auto hatches = wp->add_vector_blocks();
+    hatches->set_marking_params_key(9);
+    hatches->mutable__hatches()->add_points(1.0f);
+    hatches->mutable__hatches()->add_points(2.0f);
+    wp->add_vector_blocks()->mutable_exposure_pause()->set_pause_in_us(100);
+    wp->add_vector_blocks()->set_laser_index(1);
+
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::OvfFileReader reader{0};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+
+    auto cache = GENERATE(as<std::string>{}, "none", "full job", "recently used");
+    if (cache == "full job")
+        reader.CacheFullJob();
+    else if (cache == "recently used")
+    {
+        reader.CacheRecentlyUsed((size_t)1 << 20);
+        ovf::WorkPlane cached_wp{};
+        reader.GetWorkPlane(1, cached_wp);
+    }
+
+    google::protobuf::RepeatedPtrField<ovf::VectorBlock> headers;
+    reader.GetVectorBlockHeaders(1, headers);
+    REQUIRE( headers.size() == wp->vector_blocks_size() );
+    for (int i = 0; i < headers.size(); i++)
+    {
+        ovf::VectorBlock expected{wp->vector_blocks(i)};
+        switch (expected.vector_data_case())
+        {
+            case ovf::VectorBlock::kLineSequence: expected.mutable_line_sequence()->Clear(); break;
+            case ovf::VectorBlock::kHatches: expected.mutable__hatches()->Clear(); break;
+            case ovf::VectorBlock::kExposurePause: expected.mutable_exposure_pause()->Clear(); break;
+            default: break;
+        }
+        REQUIRE( headers.Get(i).vector_data_case() == wp->vector_blocks(i).vector_data_case() );
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equals(headers.Get(i), expected) );
+    }
+
+    // shells taken from the cache keep their fields as well
+    ovf::WorkPlane shell{};
+    reader.GetWorkPlaneShell(2, shell);
+    REQUIRE( shell.z_pos_in_mm() == job.work_planes(2).z_pos_in_mm() );
+
+    reader.GetVectorBlockHeaders(0, headers);
+    REQUIRE( headers.size() == 4 );
+    REQUIRE( headers.Get(3).line_sequence().points_size() == 0 );
+    REQUIRE_THROWS_AS( reader.GetVectorBlockHeaders(3, headers), std::runtime_error );
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "finds vector blocks by region with a spatial index", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_spatial.ovf").string();
+
+    // bounding boxes of points with any remainder of the SIMD kernels, and NaN coordinates
+    for (int dimensions : {2, 3})
+    {
+        for (int num_points = 0; num_points < 20; num_points++)
+        {
+            std::vector<float> points;
+            for (int i = 0; i < num_points; i++)
+            {
+                points.insert(points.end(), {(float)((i * 37) % 23) - 11.0f, (float)((i * 53) % 29) - 7.0f});
+                if (dimensions == 3)
+                    points.push_back(1000.0f * i);
+            }
+
+            const int i_nan = num_points / 2;
+            if (num_points > 0)
+                points[i_nan * dimensions] = std::numeric_limits<float>::quiet_NaN();
+
+            // NaN coordinates are ignored, not whole points
+            ovf::reader_writer::BoundingBox expected{};
+            for (int i = 0; i < num_points; i++)
+            {
+                float x = points[i * dimensions];
+                float y = points[i * dimensions + 1];
+                expected.Extend({x, y, x, y});
+            }
+
+            auto box = ovf::reader_writer::ComputePointBounds(points, dimensions);
+            REQUIRE( box.is_empty() == expected.is_empty() );
+            if (!expected.is_empty())
+            {
+                REQUIRE( box.x_min == expected.x_min );
+                REQUIRE( box.y_min == expected.y_min );
+                REQUIRE( box.x_max == expected.x_max );
+                REQUIRE( box.y_max == expected.y_max );
+            }
+        }
+    }
+
+    // a grid of small squares, enough for several levels of the tree
+    ovf::Job job{};
+    job.mutable_job_meta_data()->set_job_name("spatial");
+    job.set_num_work_planes(2);
+    auto wp = job.add_work_planes();
+    const int grid_size = 20;
+    for (int i = 0; i < grid_size * grid_size; i++)
+    {
+        float x = (float)(i % grid_size) * 10.0f;
+        float y = (float)(i / grid_size) * 10.0f;
+        auto points = wp->add_vector_blocks()->mutable_line_sequence()->mutable_points();
+        for (float p : {x, y, x + 5.0f, y + 5.0f, x + 2.0f, y + 1.0f})
+            points->Add(p);
+    }
+    auto block_3d = wp->add_vector_blocks()->mutable_line_sequence_3d()->mutable_points();
+    for (float p : {500.0f, 500.0f, -3.0f, 510.0f, 505.0f, 3.0f})
+        block_3d->Add(p);
+    wp->add_vector_blocks()->mutable_arcs_3d()->set_angle(90.0);
+    wp->add_vector_blocks()->mutable_exposure_pause()->set_pause_in_us(10);
+    job.add_work_planes()->set_z_pos_in_mm(0.1f);
+
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::OvfFileReader reader{};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+
+    auto build = GENERATE(as<std::string>{}, "on demand", "in parallel", "in background");
+    if (build == "in parallel")
+        reader.BuildSpatialIndex();
+    else if (build == "in background")
+        reader.BuildSpatialIndexAsync();
+
+    const int i_arcs = grid_size * grid_size + 1;
+    std::vector<int> found;
+    reader.FindVectorBlocks(0, {12.0f, 12.0f, 24.0f, 24.0f}, found);
+    REQUIRE( found == std::vector<int>{21, 22, 41, 42, i_arcs} );
+
+    reader.FindVectorBlocks(0, {501.0f, 502.0f, 502.0f, 503.0f}, found);
+    REQUIRE( found == std::vector<int>{grid_size * grid_size, i_arcs} );
+
+    // compare against brute force for a sweep of regions
+    for (float offset = -20.0f; offset < 220.0f; offset += 17.0f)
+    {
+        ovf::reader_writer::BoundingBox region{offset, offset / 2, offset + 33.0f, offset / 2 + 7.5f};
+        reader.FindVectorBlocks(0, region, found);
+
+        std::vector<int> expected;
+        for (int i = 0; i < wp->vector_blocks_size(); i++)
+        {
+            if (reader.GetVectorBlockBounds(0, i).Intersects(region))
+                expected.push_back(i);
+        }
+        REQUIRE( found == expected );
+    }
+
+    auto bounds = reader.GetVectorBlockBounds(0, 21);
+    REQUIRE( bounds.x_min == 10.0f );
+    REQUIRE( bounds.y_max == 15.0f );
+    REQUIRE( reader.GetVectorBlockBounds(0, i_arcs).is_unbounded() );
+    REQUIRE( reader.GetVectorBlockBounds(0, i_arcs + 1).is_empty() );
+
+    // found vector blocks feed into block fetches
+    google::protobuf::RepeatedPtrField<ovf::VectorBlock> vbs;
+    reader.FindVectorBlocks(0, {0.0f, 0.0f, 1.0f, 1.0f}, found);
+    reader.GetVectorBlocks(0, found, vbs);
+    REQUIRE( vbs.size() == 2 );
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vbs.Get(0), wp->vector_blocks(0)) );
+
+    reader.FindVectorBlocks(1, ovf::reader_writer::BoundingBox::Unbounded(), found);
+    REQUIRE( found.empty() );
+    reader.FindVectorBlocks(0, ovf::reader_writer::BoundingBox{}, found);
+    REQUIRE( found.empty() );
+    REQUIRE_THROWS_AS( reader.FindVectorBlocks(2, {}, found), std::runtime_error );
+    REQUIRE_THROWS_AS( reader.GetVectorBlockBounds(0, i_arcs + 2), std::runtime_error );
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "finds vector blocks by laser, part and vector data type", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_attributes.ovf").string();
+    auto index_path = path + ovf::reader_writer::kAttributeIndexFileExtension;
+    std::filesystem::remove(index_path);
+
+    ovf::Job job{};
+    job.mutable_job_meta_data()->set_job_name("attributes");
+    job.set_num_work_planes(6);
+    for (int i_wp = 0; i_wp < 6; i_wp++)
+    {
+        auto wp = job.add_work_planes();
+        for (int i = 0; i < 4 * i_wp; i++)
+        {
+            auto vb = wp->add_vector_blocks();
+            vb->set_laser_index(i % 3);
+            vb->mutable_meta_data()->set_part_key(10 + (i / 3 + i_wp) % 4);
+            switch (i % 5)
+            {
+                case 0: vb->mutable_exposure_pause()->set_pause_in_us(5); break;
+                case 1: vb->mutable_line_sequence()->add_points(1.0f); break;
+                case 2: vb->mutable_point_sequence_3d()->add_points(2.0f); break;
+                default: vb->mutable__hatches()->add_points((float)i); break;
+            }
+        }
+    }
+
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    auto lut_loading = GENERATE(ovf::reader_writer::LutLoading::kEager, ovf::reader_writer::LutLoading::kIndexFile);
+    auto build = GENERATE(as<std::string>{}, "on demand", "in parallel");
+
+    ovf::reader_writer::OvfFileReader reader{};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell, {}, lut_loading);
+    if (build == "in parallel")
+        reader.BuildAttributeIndex();
+
+    // compare against brute force for all combinations of attributes
+    using VectorDataCase = ovf::VectorBlock::VectorDataCase;
+    std::vector<ovf::reader_writer::VectorBlockFilter> filters{{}};
+    for (std::optional<int32_t> laser_index : {std::optional<int32_t>{}, std::optional<int32_t>{1}, std::optional<int32_t>{7}})
+    {
+        for (std::optional<int32_t> part_key : {std::optional<int32_t>{}, std::optional<int32_t>{12}})
+        {
+            for (auto vector_data_case : {std::optional<VectorDataCase>{}, std::optional<VectorDataCase>{ovf::VectorBlock::kHatches},
+                                          std::optional<VectorDataCase>{ovf::VectorBlock::kArcs}})
+            {
+                filters.push_back({laser_index, part_key, vector_data_case});
+            }
+        }
+    }
+
+    for (const auto& filter : filters)
+    {
+        for (auto [first_wp, num_wps] : {std::pair{0, -1}, std::pair{2, 3}, std::pair{5, 0}})
+        {
+            std::vector<ovf::reader_writer::VectorBlockLocation> found;
+            reader.FindVectorBlocks(filter, found, first_wp, num_wps);
+
+            std::vector<ovf::reader_writer::VectorBlockLocation> expected;
+            const int end_wp = num_wps < 0 ? job.work_planes_size() : first_wp + num_wps;
+            for (int i_wp = first_wp; i_wp < end_wp; i_wp++)
+            {
+                for (int i_vb = 0; i_vb < job.work_planes(i_wp).vector_blocks_size(); i_vb++)
+                {
+                    const auto& vb = job.work_planes(i_wp).vector_blocks(i_vb);
+                    if (filter.Matches({vb.laser_index(), vb.meta_data().part_key(), vb.vector_data_case()}))
+                        expected.push_back({i_wp, i_vb});
+                }
+            }
+            REQUIRE( found == expected );
+        }
+    }
+
+    // all hatches of part 12 on laser 1, fetched per work plane
+    ovf::reader_writer::VectorBlockFilter filter{1, 12, ovf::VectorBlock::kHatches};
+    int num_found = 0;
+    for (int i_wp = 0; i_wp < reader.GetNumWorkPlanes(); i_wp++)
+    {
+        google::protobuf::RepeatedPtrField<ovf::VectorBlock> vbs;
+        std::vector<int> i_vector_blocks;
+        reader.GetVectorBlocks(i_wp, filter, vbs, &i_vector_blocks);
+        REQUIRE( vbs.size() == (int)i_vector_blocks.size() );
+        for (int i = 0; i < vbs.size(); i++)
+        {
+            REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(
+                vbs.Get(i), job.work_planes(i_wp).vector_blocks(i_vector_blocks[i])) );
+            REQUIRE( vbs.Get(i).laser_index() == 1 );
+            REQUIRE( vbs.Get(i).meta_data().part_key() == 12 );
+            REQUIRE( vbs.Get(i).vector_data_case() == ovf::VectorBlock::kHatches );
+        }
+        num_found += vbs.size();
+    }
+    REQUIRE( num_found > 0 );
+
+    REQUIRE( reader.GetLaserIndices() == std::vector<int32_t>{0, 1, 2} );
+    REQUIRE( reader.GetPartKeys() == std::vector<int32_t>{10, 11, 12, 13} );
+
+    std::vector<ovf::reader_writer::VectorBlockLocation> found;
+    REQUIRE_THROWS_AS( reader.FindVectorBlocks({}, found, 4, 3), std::runtime_error );
+    REQUIRE_THROWS_AS( reader.FindVectorBlocks({}, found, -1), std::runtime_error );
+
+    // only written next to the job when index files are used, and loaded on the next open
+    REQUIRE( std::filesystem::exists(index_path) == (lut_loading == ovf::reader_writer::LutLoading::kIndexFile) );
+    if (lut_loading == ovf::reader_writer::LutLoading::kIndexFile)
+    {
+        auto index = ovf::reader_writer::AttributeIndex::Load(path, 0);
+        REQUIRE_FALSE( index.has_value() );
+
+        reader.CloseFile();
+        reader.OpenFile(path, job_shell, {}, lut_loading);
+        reader.FindVectorBlocks(filter, found);
+        REQUIRE( (int)found.size() == num_found );
+
+        // corrupted index files are rebuilt
+        std::filesystem::resize_file(index_path, std::filesystem::file_size(index_path) - 4);
+        reader.CloseFile();
+        reader.OpenFile(path, job_shell, {}, lut_loading);
+        reader.FindVectorBlocks(filter, found);
+        REQUIRE( (int)found.size() == num_found );
+    }
+
+    reader.CloseFile();
+    std::filesystem::remove(index_path);
+    std::filesystem::remove(path + ovf::reader_writer::kIndexFileExtension);
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "computes job statistics and estimates the exposure time", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_statistics.ovf").string();
+    using Catch::Approx;
+
+    ovf::Job job{};
+    job.mutable_job_meta_data()->set_job_name("statistics");
+    job.set_num_work_planes(2);
+    (*job.mutable_marking_params_map())[1].set_laser_speed_in_mm_per_s(100.0f);
+    (*job.mutable_marking_params_map())[1].set_jump_speed_in_mm_s(1000.0f);
+
+    auto wp = job.add_work_planes();
+    auto lines = wp->add_vector_blocks();
+    lines->set_marking_params_key(1);
+    for (float p : {0.0f, 0.0f, 3.0f, 4.0f, 3.0f, 10.0f})
+        lines->mutable_line_sequence()->add_points(p);
+
+    // 6 hatches of length 10, more than the SIMD kernel processes at once
+    auto hatches = wp->add_vector_blocks();
+    hatches->set_marking_params_key(1);
+    for (int i = 0; i < 6; i++)
+    {
+        for (float p : {(float)i, 0.0f, (float)i, 10.0f})
+            hatches->mutable__hatches()->add_points(p);
+    }
+
+    // a second laser, without marking params
+    auto points = wp->add_vector_blocks();
+    points->set_laser_index(1);
+    points->set_marking_params_key(2);
+    for (float p : {0.0f, 0.0f, 7.0f, 0.0f, 3.0f, 7.0f, 4.0f, 0.0f, 7.0f})
+        points->mutable_point_sequence_3d()->add_points(p);
+
+    auto arcs = wp->add_vector_blocks();
+    arcs->set_laser_index(1);
+    arcs->set_marking_params_key(1);
+    arcs->mutable__arcs()->set_angle(90.0);
+    arcs->mutable__arcs()->set_start_dx(1.0f);
+    for (float p : {0.0f, 0.0f, 10.0f, 0.0f})
+        arcs->mutable__arcs()->add_centers(p);
+
+    auto pause = wp->add_vector_blocks();
+    pause->set_laser_index(1);
+    pause->set_repeats(1);
+    pause->mutable_exposure_pause()->set_pause_in_us(1000);
+
+    // a long polyline exposed twice, checked against a plain sum
+    auto wp_repeated = job.add_work_planes();
+    wp_repeated->set_repeats(1);
+    auto polyline = wp_repeated->add_vector_blocks();
+    polyline->set_marking_params_key(1);
+    double polyline_length = 0.0;
+    for (int i = 0; i < 37; i++)
+    {
+        polyline->mutable_line_sequence()->add_points((float)((i * 37) % 23));
+        polyline->mutable_line_sequence()->add_points((float)((i * 53) % 29));
+        if (i > 0)
+        {
+            const auto& pts = polyline->line_sequence().points();
+            polyline_length += std::hypot((double)pts[2 * i] - pts[2 * i - 2], (double)pts[2 * i + 1] - pts[2 * i - 1]);
+        }
+    }
+
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::OvfFileReader reader{};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+    auto statistics = reader.ComputeStatistics();
+
+    REQUIRE( statistics.work_planes.size() == 2 );
+    const auto& wp_statistics = statistics.work_planes[0];
+    REQUIRE( wp_statistics.lasers.size() == 2 );
+
+    const auto& laser_0 = wp_statistics.lasers[0];
+    REQUIRE( laser_0.laser_index == 0 );
+    REQUIRE( laser_0.num_vector_blocks == 2 );
+    REQUIRE( laser_0.num_points == 15 );
+    REQUIRE( laser_0.num_vectors == 8 );
+    REQUIRE( laser_0.mark_length_in_mm == Approx(11.0 + 60.0) );
+    const double laser_0_jumps = std::hypot(3.0, 10.0) + 5 * std::hypot(1.0, 10.0);
+    REQUIRE( laser_0.jump_length_in_mm == Approx(laser_0_jumps) );
+    REQUIRE( laser_0.mark_time_in_s == Approx(0.71) );
+    REQUIRE( laser_0.jump_time_in_s == Approx(laser_0_jumps / 1000.0) );
+    REQUIRE( laser_0.unestimated_length_in_mm == 0.0 );
+    REQUIRE( laser_0.bounds.x_min == 0.0f );
+    REQUIRE( laser_0.bounds.x_max == 5.0f );
+    REQUIRE( laser_0.bounds.y_max == 10.0f );
+
+    const auto& laser_1 = wp_statistics.lasers[1];
+    REQUIRE( laser_1.laser_index == 1 );
+    REQUIRE( laser_1.num_vector_blocks == 3 );
+    REQUIRE( laser_1.num_points == 5 );
+    REQUIRE( laser_1.num_vectors == 2 );
+    const double pi = 3.14159265358979323846;
+    REQUIRE( laser_1.mark_length_in_mm == Approx(pi) );
+    const double point_jumps = 3.0 + 5.0;
+    const double arc_jumps = 3.0 + std::hypot(11.0, 1.0);
+    REQUIRE( laser_1.jump_length_in_mm == Approx(point_jumps + arc_jumps) );
+    REQUIRE( laser_1.unestimated_length_in_mm == Approx(point_jumps) );
+    REQUIRE( laser_1.pause_time_in_s == Approx(0.002) );
+    REQUIRE( laser_1.total_time_in_s() == Approx(pi / 100.0 + arc_jumps / 1000.0 + 0.002) );
+
+    REQUIRE( wp_statistics.total.num_vector_blocks == 5 );
+    REQUIRE( wp_statistics.estimated_time_in_s() == Approx(laser_0.total_time_in_s()) );
+
+    const auto& repeated = statistics.work_planes[1].total;
+    REQUIRE( repeated.num_points == 37 );
+    REQUIRE( repeated.mark_length_in_mm == Approx(2 * polyline_length) );
+
+    REQUIRE( statistics.lasers.size() == 2 );
+    REQUIRE( statistics.lasers[0].mark_length_in_mm == Approx(71.0 + 2 * polyline_length) );
+    REQUIRE( statistics.total.num_vector_blocks == 6 );
+    REQUIRE( statistics.estimated_time_in_s == Approx(wp_statistics.estimated_time_in_s() + statistics.work_planes[1].estimated_time_in_s()) );
+    REQUIRE( statistics.load_balance() == Approx((statistics.lasers[0].total_time_in_s() + statistics.lasers[1].total_time_in_s()) / 2 / statistics.lasers[0].total_time_in_s()) );
+
+    // the same figures from messages
+    for (int i_wp = 0; i_wp < 2; i_wp++)
+    {
+        auto from_message = ovf::reader_writer::ComputeWorkPlaneStatistics(job.work_planes(i_wp), job.marking_params_map());
+        REQUIRE( from_message.lasers.size() == statistics.work_planes[i_wp].lasers.size() );
+        REQUIRE( from_message.total.num_points == statistics.work_planes[i_wp].total.num_points );
+        REQUIRE( from_message.total.mark_length_in_mm == Approx(statistics.work_planes[i_wp].total.mark_length_in_mm) );
+        REQUIRE( from_message.total.jump_length_in_mm == Approx(statistics.work_planes[i_wp].total.jump_length_in_mm) );
+        REQUIRE( from_message.estimated_time_in_s() == Approx(statistics.work_planes[i_wp].estimated_time_in_s()) );
+    }
+
+    reader.CloseFile();
+    REQUIRE_THROWS_AS( reader.ComputeStatistics(), std::runtime_error );
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "reads ranges of files into buffers", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_buffered.ovf").string();
+
+    auto job = ovf_test::MakeTestJob();
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    {
+        ovf::reader_writer::MemoryMapping mapping{path};
+        ovf::reader_writer::BufferedFile file{path};
+        REQUIRE( file.file_size() == mapping.file_size() );
+        REQUIRE( file.copies_data() );
+        REQUIRE( !mapping.copies_data() );
+
+        auto full_view = mapping.CreateView(0, 0);
+        auto matches_file = [&](const ovf::reader_writer::FileView& view, size_t offset){
+            return std::equal(view.data(), view.data() + view.size(), full_view.data() + offset);
+        };
+
+        auto view = file.CreateView(5, 17);
+        REQUIRE( view.size() == 17 );
+        REQUIRE( (uintptr_t)view.data() % ovf::reader_writer::ReadBufferPool::kAlignment == 0 );
+        REQUIRE( matches_file(view, 5) );
+
+        auto tail_view = file.CreateView(file.file_size() - 3, 0);
+        REQUIRE( tail_view.size() == 3 );
+        REQUIRE( matches_file(tail_view, file.file_size() - 3) );
+
+        // more ranges than io_uring entries, submitted in several rounds if available
+        std::vector<ovf::reader_writer::ByteRange> ranges;
+        for (size_t i = 0; i < 100; i++)
+            ranges.push_back({(i * 37) % (file.file_size() - 64), 1 + i % 64});
+
+        auto views = file.CreateViews(ranges);
+        REQUIRE( views.size() == ranges.size() );
+        for (size_t i = 0; i < ranges.size(); i++)
+        {
+            REQUIRE( views[i].size() == ranges[i].size );
+            REQUIRE( matches_file(views[i], ranges[i].offset) );
+        }
+
+        REQUIRE_THROWS_AS( file.CreateView(file.file_size(), 1), std::runtime_error );
+        ranges.push_back({file.file_size() - 1, 2});
+        REQUIRE_THROWS_AS( file.CreateViews(ranges), std::runtime_error );
+        REQUIRE_THROWS_AS( ovf::reader_writer::BufferedFile{path + ".missing"}, std::runtime_error );
+    }
+
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "populates, locks and releases the mapped work planes", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_residency.ovf").string();
+    auto job = ovf_test::MakeTestJob(6, 30);
+    ovf::reader_writer::OvfFileWriter{}.WriteFullJob(job, path);
+    const size_t file_size = (size_t)std::filesystem::file_size(path);
+
+    ovf::reader_writer::MappingOptions options{};
+    options.populate = true;
+    options.huge_pages = true;
+
+    ovf::reader_writer::OvfFileReader reader{0};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell, options);
+
+    // populated mappings are resident right away
+    auto memory = reader.GetResidentMemory();
+    REQUIRE( memory.resident_bytes >= file_size );
+
+    // locking is limited by the system, so the locked amount is only checked if it succeeds
+    if (reader.LockWorkPlanes(1))
+    {
+        REQUIRE( reader.GetResidentMemory().locked_bytes > 0 );
+        reader.UnlockWorkPlanes(1);
+        REQUIRE( reader.GetResidentMemory().locked_bytes == 0 );
+    }
+
+    reader.ReleaseWorkPlanes(2, 3);
+    auto released = reader.GetResidentMemory();
+    REQUIRE( released.resident_bytes < memory.resident_bytes );
+
+    // released work planes are read back from the file
+    ovf::WorkPlane wp{};
+    reader.GetWorkPlane(3, wp);
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(29), job.work_planes(3).vector_blocks(29)) );
+
+    REQUIRE_THROWS_AS( reader.ReleaseWorkPlanes(4, 3), std::runtime_error );
+    REQUIRE_THROWS_AS( reader.LockWorkPlanes(-1), std::runtime_error );
+
+    // streaming releases each work plane once it is decoded
+    {
+        ovf::reader_writer::WorkPlaneStreamOptions stream_options{};
+        stream_options.release_decoded = true;
+        ovf::reader_writer::WorkPlaneStream stream{reader, stream_options};
+        while (stream.Next(wp)) {}
+    }
+    REQUIRE( reader.GetResidentMemory().resident_bytes < file_size / 2 );
+
+    REQUIRE( ovf::reader_writer::GetProcessMemoryUsage().resident_bytes >= released.resident_bytes );
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "streams work planes with read ahead", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_stream.ovf").string();
+
+    auto job = ovf_test::MakeTestJob(7, 3);
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::OvfFileReader reader{};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+    REQUIRE( reader.GetNumWorkPlanes() == 7 );
+
+    ovf::reader_writer::WorkPlaneStreamOptions options{};
+    options.look_ahead = GENERATE(1, 3);
+    options.num_threads = GENERATE(1, 2);
+
+    SECTION( "all work planes" ) {
+        ovf::reader_writer::WorkPlaneStream stream{reader, options};
+        ovf::WorkPlane wp{};
+        for (int i_wp = 0; i_wp < 7; i_wp++)
+        {
+            REQUIRE( stream.next_work_plane() == i_wp );
+            REQUIRE( stream.Next(wp) );
+
+            ovf::WorkPlane expected{};
+            reader.GetWorkPlane(i_wp, expected);
+            REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp, expected) );
+        }
+        REQUIRE_FALSE( stream.Next(wp) );
+    }
+
+    SECTION( "range of work planes, stopped early" ) {
+        options.first_work_plane = 2;
+        options.num_work_planes = 4;
+        ovf::reader_writer::WorkPlaneStream stream{reader, options};
+        ovf::WorkPlane wp{};
+        REQUIRE( stream.Next(wp) );
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(
+            wp.vector_blocks(1), job.work_planes(2).vector_blocks(1)) );
+    }
+
+    options.first_work_plane = 5;
+    options.num_work_planes = 3;
+    REQUIRE_THROWS_AS( (ovf::reader_writer::WorkPlaneStream{reader, options}), std::runtime_error );
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "caches recently used work planes within a byte budget", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_lru.ovf").string();
+
+    auto job = ovf_test::MakeTestJob();
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::OvfFileReader reader{};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+
+    ovf::WorkPlane wp{};
+    reader.GetWorkPlane(0, wp);
+    size_t wp_size = (size_t)wp.SpaceUsedLong();
+
+    // room for two of the equally sized work planes
+    reader.CacheRecentlyUsed(wp_size * 5 / 2, true);
+    REQUIRE_FALSE( reader.IsWorkPlaneShellsCached() );
+
+    reader.GetWorkPlane(0, wp);
+    reader.GetWorkPlane(1, wp);
+    reader.GetWorkPlane(0, wp);
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(3), job.work_planes(0).vector_blocks(3)) );
+
+    auto stats = reader.GetCacheStatistics();
+    REQUIRE( stats.hits == 1 );
+    REQUIRE( stats.misses == 2 );
+    REQUIRE( stats.evictions == 0 );
+    REQUIRE( stats.num_entries == 2 );
+    REQUIRE( stats.size_bytes <= wp_size * 5 / 2 );
+
+    // evicts work plane 1, the least recently used one
+    reader.GetWorkPlane(2, wp);
+    stats = reader.GetCacheStatistics();
+    REQUIRE( stats.evictions == 1 );
+
+    // shells and vector blocks are served from cached work planes
+    reader.GetWorkPlaneShell(2, wp);
+    REQUIRE( wp.vector_blocks_size() == 0 );
+    ovf::VectorBlock vb{};
+    reader.GetVectorBlock(0, 2, vb);
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vb, job.work_planes(0).vector_blocks(2)) );
+    REQUIRE( reader.GetCacheStatistics().hits == 3 );
+
+    // single vector blocks of work planes that are not cached
+    vb.Clear();
+    reader.GetVectorBlock(1, 3, vb);
+    vb.Clear();
+    reader.GetVectorBlock(1, 3, vb);
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vb, job.work_planes(1).vector_blocks(3)) );
+    stats = reader.GetCacheStatistics();
+    REQUIRE( stats.hits == 4 );
+    REQUIRE( stats.misses == 4 );
+
+    REQUIRE_THROWS_AS( reader.GetVectorBlock(0, 4, vb), std::runtime_error );
+
+    reader.ClearCache();
+    REQUIRE( reader.GetCacheStatistics().num_entries == 0 );
+
+    // shells from a fully cached job don't include vector blocks
+    reader.CacheFullJob();
+    reader.GetWorkPlaneShell(1, wp);
+    REQUIRE( wp.vector_blocks_size() == 0 );
+
+    reader.CloseFile();
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "loads work plane luts eagerly, lazily or in the background", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_lazy_lut.ovf").string();
+
+    auto job = ovf_test::MakeTestJob(50, 2);
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    auto lut_loading = GENERATE(
+        ovf::reader_writer::LutLoading::kEager,
+        ovf::reader_writer::LutLoading::kLazy,
+        ovf::reader_writer::LutLoading::kBackground
+    );
+
+    ovf::reader_writer::OvfFileReader reader{0}; // caching would read all luts on open
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell, {}, lut_loading);
+    REQUIRE( reader.GetNumWorkPlanes() == 50 );
+
+    // access in reverse, racing the background loader
+    for (int i_wp = 49; i_wp >= 0; i_wp--)
+    {
+        ovf::VectorBlock vb{};
+        reader.GetVectorBlock(i_wp, 1, vb);
+        REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vb, job.work_planes(i_wp).vector_blocks(1)) );
+    }
+
+    // reopening stops a running background loader
+    reader.OpenFile(path, job_shell, {}, lut_loading);
+    reader.CloseFile();
+    REQUIRE_FALSE( reader.IsFileOpen() );
+
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "opens jobs from an up to date index file", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_index_file.ovf").string();
+    auto index_path = path + ovf::reader_writer::kIndexFileExtension;
+    std::filesystem::remove(index_path);
+
+    auto require_job = [&](const ovf::Job& expected){
+        ovf::reader_writer::OvfFileReader reader{0};
+        ovf::Job job_shell{};
+        reader.OpenFile(path, job_shell, {}, ovf::reader_writer::LutLoading::kIndexFile);
+        REQUIRE( reader.GetNumWorkPlanes() == expected.work_planes_size() );
+        REQUIRE( job_shell.job_meta_data().job_name() == expected.job_meta_data().job_name() );
+
+        for (int i_wp = 0; i_wp < expected.work_planes_size(); i_wp++)
+        {
+            ovf::WorkPlane wp{};
+            reader.GetWorkPlane(i_wp, wp);
+            REQUIRE( wp.vector_blocks_size() == expected.work_planes(i_wp).vector_blocks_size() );
+            for (int i_vb = 0; i_vb < wp.vector_blocks_size(); i_vb++)
+                REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(i_vb), expected.work_planes(i_wp).vector_blocks(i_vb)) );
+        }
+    };
+
+    SECTION( "generated on first open" ) {
+        auto job = ovf_test::MakeTestJob(5, 3);
+        ovf::reader_writer::OvfFileWriter writer{};
+        writer.WriteFullJob(job, path);
+        REQUIRE_FALSE( std::filesystem::exists(index_path) );
+
+        require_job(job);
+        REQUIRE( std::filesystem::exists(index_path) );
+        require_job(job);
+    }
+
+    SECTION( "written by the writer, and ignored once outdated or corrupted" ) {
+        auto job = ovf_test::MakeTestJob(5, 3);
+        ovf::reader_writer::WriterOptions options{};
+        options.write_index_file = true;
+        ovf::reader_writer::OvfFileWriter writer{options};
+        writer.WriteFullJob(job, path);
+        REQUIRE( std::filesystem::exists(index_path) );
+        require_job(job);
+
+        // overwriting the job without an index file outdates the existing one
+        auto other_job = ovf_test::MakeTestJob(4, 2);
+        ovf::reader_writer::OvfFileWriter{}.WriteFullJob(other_job, path);
+        require_job(other_job);
+
+        std::filesystem::resize_file(index_path, std::filesystem::file_size(index_path) - 8);
+        require_job(other_job);
+
+        // positions out of range are rejected as well, even though size and modification time match
+        auto index_size = std::filesystem::file_size(index_path);
+        {
+            std::fstream fs{index_path, std::ios::binary | std::ios::in | std::ios::out};
+            fs.seekp((std::streamoff)index_size - 8);
+            const uint64_t corrupted_position = (uint64_t)1 << 40;
+            fs.write((const char*)&corrupted_position, sizeof(corrupted_position));
+        }
+        require_job(other_job);
+    }
+
+    SECTION( "written by the writer if possible, without failing the write of the job" ) {
+        // a directory in place of the index file can't be replaced
+        std::filesystem::create_directory(index_path);
+        std::ofstream{index_path + "/blocker"} << "x";
+
+        auto job = ovf_test::MakeTestJob(5, 3);
+        ovf::reader_writer::WriterOptions options{};
+        options.write_index_file = true;
+        ovf::reader_writer::OvfFileWriter writer{options};
+        REQUIRE_NOTHROW( writer.WriteFullJob(job, path) );
+        require_job(job);
+
+        std::filesystem::remove_all(index_path);
+    }
+
+    std::filesystem::remove(index_path);
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "verifies checksums of the whole file and of work planes on first read", "[reader]" ) {
+    using ovf::reader_writer::ChecksumMode;
+
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_checksums.ovf").string();
+    auto job = ovf_test::MakeTestJob(4, 3);
+
+    auto write_job = [&](ChecksumMode checksum_mode){
+        ovf::reader_writer::WriterOptions options{};
+        options.checksum_mode = checksum_mode;
+        ovf::reader_writer::OvfFileWriter writer{options};
+        writer.WriteFullJob(job, path);
+
+        std::ifstream ifs{path, std::ios::binary};
+        return std::vector<uint8_t>{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+    };
+
+    // flips a bit in a coordinate of the second vector block of the third work plane
+    auto corrupt = [](std::vector<uint8_t> bytes){
+        const float coordinate = 2300.0f;
+        uint8_t pattern[sizeof(float)];
+        std::memcpy(pattern, &coordinate, sizeof(float));
+        auto it = std::search(bytes.begin(), bytes.end(), std::begin(pattern), std::end(pattern));
+        REQUIRE( it != bytes.end() );
+        *it ^= 0x01;
+        return bytes;
+    };
+
+    SECTION( "checksums of adjacent ranges are combined as if computed in one go" ) {
+        auto bytes = write_job(ChecksumMode::kNone);
+        for (size_t split : {(size_t)0, (size_t)1, (size_t)8, bytes.size() / 3, bytes.size()})
+        {
+            const uint32_t first = ovf::reader_writer::Crc32c(bytes.data(), split);
+            const uint32_t second = ovf::reader_writer::Crc32c(bytes.data() + split, bytes.size() - split);
+            REQUIRE( ovf::reader_writer::Crc32cCombine(first, second, bytes.size() - split)
+                == ovf::reader_writer::Crc32c(bytes.data(), bytes.size()) );
+        }
+    }
+
+    SECTION( "files without checksums can't be verified, but are read as before" ) {
+        ovf::reader_writer::OvfFileReader reader{0};
+        ovf::Job job_shell{};
+        reader.OpenBuffer(write_job(ChecksumMode::kNone), job_shell);
+        auto result = reader.Verify();
+        REQUIRE_FALSE( result.has_checksums );
+        REQUIRE_FALSE( result.is_intact() );
+    }
+
+    SECTION( "intact files are read as before" ) {
+        auto mode = GENERATE( ChecksumMode::kWorkPlanes, ChecksumMode::kVectorBlocks );
+        auto bytes = write_job(mode);
+
+        ovf::reader_writer::OvfFileReader reader{0};
+        reader.VerifyOnFirstRead();
+        ovf::Job job_shell{};
+        reader.OpenBuffer(std::move(bytes), job_shell);
+        REQUIRE( reader.Verify().is_intact() );
+
+        for (int i_wp = 0; i_wp < job.work_planes_size(); i_wp++)
+        {
+            ovf::WorkPlane wp{};
+            reader.GetWorkPlane(i_wp, wp);
+            REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(2), job.work_planes(i_wp).vector_blocks(2)) );
+        }
+
+        // the checksum section is ignored when reading the job
+        ovf::reader_writer::OvfFileReader other_reader{0};
+        other_reader.OpenFile(path, job_shell);
+        REQUIRE( other_reader.GetNumWorkPlanes() == job.work_planes_size() );
+    }
+
+    SECTION( "corrupted work planes and vector blocks are located" ) {
+        auto bytes = corrupt(write_job(ChecksumMode::kVectorBlocks));
+
+        ovf::reader_writer::OvfFileReader reader{0};
+        ovf::Job job_shell{};
+        reader.OpenBuffer(std::move(bytes), job_shell);
+        auto result = reader.Verify();
+        REQUIRE( result.has_checksums );
+        REQUIRE( result.is_job_intact );
+        REQUIRE_FALSE( result.is_intact() );
+        REQUIRE( result.corrupted_work_planes == std::vector<int>{2} );
+        REQUIRE( result.corrupted_vector_blocks == std::vector<ovf::reader_writer::VectorBlockLocation>{{2, 1}} );
+
+        // without verification on first read, the corrupted data is returned
+        ovf::VectorBlock vb{};
+        REQUIRE_NOTHROW( reader.GetVectorBlock(2, 1, vb) );
+    }
+
+    SECTION( "corrupted work planes are not read when verifying on first read" ) {
+        auto bytes = corrupt(write_job(ChecksumMode::kWorkPlanes));
+
+        ovf::reader_writer::OvfFileReader reader{0};
+        reader.VerifyOnFirstRead();
+        ovf::Job job_shell{};
+        reader.OpenBuffer(std::move(bytes), job_shell);
+
+        ovf::WorkPlane wp{};
+        ovf::VectorBlock vb{};
+        REQUIRE_NOTHROW( reader.GetWorkPlane(1, wp) );
+        REQUIRE_THROWS_AS( reader.GetWorkPlane(2, wp), std::runtime_error );
+        REQUIRE_THROWS_AS( reader.GetVectorBlock(2, 0, vb), std::runtime_error );
+        REQUIRE_NOTHROW( reader.GetVectorBlock(3, 0, vb) );
+
+        auto result = reader.Verify();
+        REQUIRE( result.corrupted_work_planes == std::vector<int>{2} );
+        REQUIRE( result.corrupted_vector_blocks.empty() );
+    }
+
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "opens jobs from borrowed and owned buffers and custom sources", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_buffer.ovf").string();
+
+    auto job = ovf_test::MakeTestJob(5, 3);
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    std::vector<uint8_t> buffer;
+    {
+        std::ifstream in{path, std::ios::binary};
+        buffer.assign(std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{});
+    }
+    std::filesystem::remove(path);
+
+    /** Counts the views created, to tell that the reader runs over the custom source. */
+    class CountingSource : public ovf::reader_writer::MemoryBuffer
+    {
+    public:
+        using MemoryBuffer::MemoryBuffer;
+
+        ovf::reader_writer::FileView CreateView(const size_t offset, const size_t min_size) const override
+        {
+            num_views++;
+            return MemoryBuffer::CreateView(offset, min_size);
+        }
+
+        mutable std::atomic<int> num_views{0};
+    };
+
+    auto require_job = [&](ovf::reader_writer::OvfFileReader& reader, const ovf::Job& job_shell){
+        REQUIRE( job_shell.job_meta_data().job_name() == "roundtrip" );
+        REQUIRE( reader.GetNumWorkPlanes() == 5 );
+        for (int i_wp = 0; i_wp < 5; i_wp++)
+        {
+            ovf::WorkPlane wp{};
+            reader.GetWorkPlane(i_wp, wp);
+            REQUIRE( wp.vector_blocks_size() == 3 );
+            for (int i_vb = 0; i_vb < 3; i_vb++)
+                REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(i_vb), job.work_planes(i_wp).vector_blocks(i_vb)) );
+        }
+    };
+
+    auto lut_loading = GENERATE(
+        ovf::reader_writer::LutLoading::kEager,
+        ovf::reader_writer::LutLoading::kLazy,
+        ovf::reader_writer::LutLoading::kIndexFile
+    );
+    auto auto_cache_threshold = GENERATE((size_t)0, (size_t)1 << 20);
+
+    ovf::reader_writer::OvfFileReader reader{auto_cache_threshold};
+    ovf::Job job_shell{};
+
+    // borrowed, views point into the buffer
+    reader.OpenBuffer(buffer, job_shell, lut_loading);
+    require_job(reader, job_shell);
+    auto view = reader.GetVectorBlockView(2, 1);
+    REQUIRE( view.raw_points().data() >= buffer.data() );
+    REQUIRE( view.raw_points().data() < buffer.data() + buffer.size() );
+
+    // owned, views stay valid after the file is closed
+    reader.OpenBuffer(std::vector<uint8_t>{buffer}, job_shell, lut_loading);
+    require_job(reader, job_shell);
+    auto owned_view = reader.GetVectorBlockView(4, 2);
+    reader.CloseFile();
+    ovf::VectorBlock vb{};
+    owned_view.Parse(vb);
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vb, job.work_planes(4).vector_blocks(2)) );
+
+    auto source = std::make_unique<CountingSource>(ovf::reader_writer::Span<const uint8_t>{buffer});
+    auto& counting_source = *source;
+    reader.OpenSource(std::move(source), job_shell, lut_loading);
+    require_job(reader, job_shell);
+    REQUIRE( counting_source.num_views > 0 );
+    reader.CloseFile();
+
+    REQUIRE_THROWS_AS( reader.OpenSource(nullptr, job_shell), std::runtime_error );
+    REQUIRE_THROWS_AS( reader.OpenBuffer(ovf::reader_writer::Span<const uint8_t>{buffer.data(), 8}, job_shell), std::runtime_error );
+    std::vector<uint8_t> corrupted{buffer};
+    corrupted[0] = 'X';
+    REQUIRE_THROWS_AS( reader.OpenBuffer(std::move(corrupted), job_shell), std::runtime_error );
+    REQUIRE_FALSE( reader.IsFileOpen() );
+}
+
+
+TEST_CASE( "caches jobs up to the threshold, in parallel or in the background", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_cache.ovf").string();
+
+    auto job = ovf_test::MakeTestJob(20, 3);
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+    auto file_size = std::filesystem::file_size(path);
+
+    ovf::Job job_shell{};
+    {
+        ovf::reader_writer::OvfFileReader reader{file_size};
+        reader.OpenFile(path, job_shell);
+        REQUIRE( reader.IsFullJobCached() );
+    }
+    {
+        ovf::reader_writer::OvfFileReader reader{file_size - 1};
+        reader.OpenFile(path, job_shell);
+        REQUIRE_FALSE( reader.IsWorkPlaneShellsCached() );
+    }
+
+    int num_cache_threads = GENERATE(1, 4);
+    ovf::reader_writer::OvfFileReader reader{0, num_cache_threads};
+    reader.OpenFile(path, job_shell);
+
+    auto require_job_equivalent = [&](){
+        for (int i_wp = 0; i_wp < 20; i_wp++)
+        {
+            ovf::WorkPlane wp{};
+            reader.GetWorkPlane(i_wp, wp);
+            REQUIRE( wp.vector_blocks_size() == 3 );
+            REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(2), job.work_planes(i_wp).vector_blocks(2)) );
+
+            reader.GetWorkPlaneShell(i_wp, wp);
+            REQUIRE( wp.vector_blocks_size() == 0 );
+        }
+    };
+
+    reader.CacheWorkPlaneShells();
+    REQUIRE( reader.IsWorkPlaneShellsCached() );
+    require_job_equivalent();
+
+    reader.CacheFullJob();
+    REQUIRE( reader.IsFullJobCached() );
+    require_job_equivalent();
+
+    reader.ClearCache();
+    reader.CacheFullJobAsync();
+    require_job_equivalent();
+
+    for (int i = 0; i < 1000 && !reader.IsFullJobCached(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE( reader.IsFullJobCached() );
+    require_job_equivalent();
+
+    // closing stops warming in progress
+    reader.ClearCache();
+    reader.CacheFullJobAsync();
+    reader.CloseFile();
+    REQUIRE_FALSE( reader.IsFullJobCached() );
+
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "reads concurrently while caches change and shares files between readers", "[reader]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_reader_snapshots.ovf").string();
+
+    auto job = ovf_test::MakeTestJob(6, 4);
+    ovf::reader_writer::OvfFileWriter writer{};
+    writer.WriteFullJob(job, path);
+
+    ovf::reader_writer::OvfFileReader reader{0};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+
+    // Catch2 assertions are not thread-safe, mismatches are counted instead
+    std::atomic<bool> is_stopped{false};
+    std::atomic<int> num_mismatches{0};
+    std::vector<std::thread> threads;
+    for (int i_thread = 0; i_thread < 4; i_thread++)
+    {
+        threads.emplace_back([&, i_thread](){
+            ovf::WorkPlane wp{};
+            for (int i = 0; !is_stopped; i++)
+            {
+                int i_wp = (i + i_thread) % 6;
+                reader.GetWorkPlane(i_wp, wp);
+                if (wp.vector_blocks_size() != 4 || !google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(3), job.work_planes(i_wp).vector_blocks(3)))
+                    num_mismatches++;
+            }
+        });
+    }
+
+    // background threads are started and stopped from several threads as well
+    std::thread changing_thread{[&](){
+        for (int i = 0; i < 20; i++)
+        {
+            reader.CacheFullJobAsync();
+            reader.BuildSpatialIndexAsync();
+        }
+    }};
+
+    for (int i = 0; i < 20; i++)
+    {
+        reader.CacheWorkPlaneShells();
+        reader.CacheFullJob();
+        reader.CacheRecentlyUsed(1 << 20);
+        reader.CacheFullJobAsync();
+        reader.BuildSpatialIndexAsync();
+        reader.ClearCache();
+    }
+
+    changing_thread.join();
+    is_stopped = true;
+    for (auto& thread : threads)
+        thread.join();
+    REQUIRE( num_mismatches == 0 );
+
+    // the shared file stays open after closing the reader it was shared from
+    reader.CacheRecentlyUsed(1 << 20);
+    ovf::WorkPlane cached_wp{};
+    reader.GetWorkPlane(1, cached_wp);
+    ovf::reader_writer::OvfFileReader shared_reader{0};
+    ovf::Job shared_job_shell{};
+    shared_reader.ShareFile(reader, shared_job_shell);
+    REQUIRE( shared_job_shell.job_meta_data().job_name() == job_shell.job_meta_data().job_name() );
+
+    // the recently used cache is not shared, reads of one reader don't count for the other
+    REQUIRE( shared_reader.GetCacheStatistics().num_entries == 0 );
+    reader.GetWorkPlane(1, cached_wp);
+    shared_reader.GetWorkPlane(1, cached_wp);
+    REQUIRE( reader.GetCacheStatistics().hits == 1 );
+    REQUIRE( shared_reader.GetCacheStatistics().hits == 0 );
+    REQUIRE( shared_reader.GetCacheStatistics().misses == 1 );
+
+    reader.CloseFile();
+    REQUIRE_FALSE( reader.IsFileOpen() );
+    REQUIRE( shared_reader.IsFileOpen() );
+
+    ovf::VectorBlock vb{};
+    shared_reader.GetVectorBlock(5, 2, vb);
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(vb, job.work_planes(5).vector_blocks(2)) );
+    REQUIRE_THROWS( reader.ShareFile(ovf::reader_writer::OvfFileReader{}, shared_job_shell) );
+
+    shared_reader.CloseFile();
+    std::filesystem::remove(path);
 }
\ No newline at end of file
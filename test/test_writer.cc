@@ -26,4 +26,345 @@ SOFTWARE.
 ---- Copyright End ----
 */
 
-#include <catch2/catch_test_macros.hpp>
\ No newline at end of file
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "google/protobuf/util/message_differencer.h"
+
+#include "ovf_reader_writer_export.h"
+#include "open_vector_format.pb.h"
+#include "ovf_file_reader.h"
+#include "ovf_file_writer.h"
+#include "util.h"
+
+#include "test_common.h"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace ovf = open_vector_format;
+
+namespace {
+
+/** Reads the whole content of a written file, to compare files byte by byte. */
+std::vector<char> ReadFile(const std::string& path)
+{
+    std::ifstream ifs{path, std::ios::binary};
+    return std::vector<char>{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+}
+
+}
+
+TEST_CASE( "writes identical files with any write buffer size", "[writer]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_writer_write_buffer.ovf").string();
+    auto job = ovf_test::MakeTestJob(4, 5);
+
+    ovf::reader_writer::OvfFileWriter{}.WriteFullJob(job, path);
+    const auto expected = ReadFile(path);
+
+    // no buffer, smaller than the header, smaller than a work plane and larger than the file
+    auto buffer_size = GENERATE( (size_t)0, (size_t)5, (size_t)100, (size_t)1 << 20 );
+
+    // a longer file is truncated
+    {
+        std::ofstream ofs{path, std::ios::binary | std::ios::app};
+        ofs << std::string(expected.size(), 'x');
+    }
+
+    ovf::reader_writer::WriterOptions options{};
+    options.write_buffer_size = buffer_size;
+    ovf::reader_writer::OvfFileWriter writer{options};
+    writer.WriteFullJob(job, path);
+    REQUIRE( ReadFile(path) == expected );
+
+    writer.StartWritePartial(job, path);
+    for (const auto& wp : job.work_planes())
+    {
+        ovf::WorkPlane wp_shell{wp};
+        wp_shell.clear_vector_blocks();
+        writer.AppendWorkPlane(wp_shell);
+        for (const auto& vb : wp.vector_blocks())
+            writer.AppendVectorBlock(vb);
+    }
+    writer.FinishWrite();
+    REQUIRE( ReadFile(path) == expected );
+
+    ovf::reader_writer::OvfFileReader reader{0};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+    REQUIRE( job_shell.num_work_planes() == 4 );
+    ovf::WorkPlane wp{};
+    reader.GetWorkPlane(3, wp);
+    REQUIRE( wp.vector_blocks_size() == 5 );
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(4), job.work_planes(3).vector_blocks(4)) );
+    reader.CloseFile();
+
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "streams appended work planes and vector blocks to the file", "[writer]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_writer_append_streamed.ovf").string();
+    auto job = ovf_test::MakeTestJob(3, 4);
+
+    // checksums of streamed work planes are combined from their parts, small buffers write the
+    // work plane lut offsets back into the file
+    auto checksum_mode = GENERATE( ovf::reader_writer::ChecksumMode::kNone, ovf::reader_writer::ChecksumMode::kVectorBlocks );
+    auto buffer_size = GENERATE( (size_t)16, ovf::reader_writer::OutputFile::kDefaultBufferSize );
+
+    ovf::reader_writer::WriterOptions options{};
+    options.checksum_mode = checksum_mode;
+    options.write_buffer_size = buffer_size;
+    ovf::reader_writer::OvfFileWriter writer{options};
+    writer.WriteFullJob(job, path);
+    const auto expected = ReadFile(path);
+
+    auto shell_of = [](const ovf::WorkPlane& wp){
+        ovf::WorkPlane wp_shell{wp};
+        wp_shell.clear_vector_blocks();
+        return wp_shell;
+    };
+
+    // moved work planes and vector blocks, a heap allocated vector block the writer takes ownership of
+    writer.StartWritePartial(job, path);
+    for (const auto& wp : job.work_planes())
+    {
+        auto wp_shell = shell_of(wp);
+        *wp_shell.add_vector_blocks() = wp.vector_blocks(0);
+        writer.AppendWorkPlane(std::move(wp_shell));
+
+        writer.AppendVectorBlock(std::make_unique<ovf::VectorBlock>(wp.vector_blocks(1)));
+        for (int i = 2; i < wp.vector_blocks_size(); i++)
+            writer.AppendVectorBlock(ovf::VectorBlock{wp.vector_blocks(i)});
+    }
+    writer.FinishWrite();
+    REQUIRE( ReadFile(path) == expected );
+
+    // work planes and vector blocks are written right away, so their arena can be reset after appending them
+    {
+        google::protobuf::Arena arena;
+        writer.StartWritePartial(job, path);
+        for (const auto& wp : job.work_planes())
+        {
+            auto arena_wp = ovf::util::CreateOnArena<ovf::WorkPlane>(arena);
+            *arena_wp = shell_of(wp);
+            writer.AppendWorkPlane(*arena_wp);
+            arena.Reset();
+
+            for (const auto& vb : wp.vector_blocks())
+            {
+                auto arena_vb = ovf::util::CreateOnArena<ovf::VectorBlock>(arena);
+                *arena_vb = vb;
+                writer.AppendVectorBlock(*arena_vb);
+                arena.Reset();
+            }
+        }
+        writer.FinishWrite();
+    }
+    REQUIRE( ReadFile(path) == expected );
+
+    ovf::reader_writer::OvfFileReader reader{0};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+    REQUIRE( reader.Verify().is_intact() == (checksum_mode != ovf::reader_writer::ChecksumMode::kNone) );
+    ovf::WorkPlane wp{};
+    reader.GetWorkPlane(2, wp);
+    REQUIRE( wp.work_plane_number() == 2 );
+    REQUIRE( google::protobuf::util::MessageDifferencer::Equivalent(wp.vector_blocks(3), job.work_planes(2).vector_blocks(3)) );
+    reader.CloseFile();
+
+    REQUIRE_THROWS_AS( writer.AppendVectorBlock(ovf::VectorBlock{}), std::runtime_error );
+    writer.StartWritePartial(job, path);
+    REQUIRE_THROWS_AS( writer.AppendVectorBlock(std::make_unique<ovf::VectorBlock>()), std::runtime_error );
+    writer.FinishWrite();
+
+    std::filesystem::remove(path);
+}
+
+#ifndef _WIN32
+TEST_CASE( "aborts a synchronous write if appending fails", "[writer]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_writer_append_failed.ovf").string();
+    auto job = ovf_test::MakeTestJob(2, 10);
+
+    ovf::reader_writer::WriterOptions options{};
+    options.write_buffer_size = 4096;
+    ovf::reader_writer::OvfFileWriter writer{options};
+    writer.WriteFullJob(job, path);
+    const auto expected = ReadFile(path);
+
+    // beyond the file size limit, writes fail with EFBIG instead of raising SIGXFSZ
+    rlimit limit{};
+    REQUIRE( getrlimit(RLIMIT_FSIZE, &limit) == 0 );
+    rlimit small_limit = limit;
+    small_limit.rlim_cur = expected.size() / 2;
+    auto previous_handler = std::signal(SIGXFSZ, SIG_IGN);
+    REQUIRE( setrlimit(RLIMIT_FSIZE, &small_limit) == 0 );
+
+    bool has_append_failed = false;
+    writer.StartWritePartial(job, path);
+    try
+    {
+        for (const auto& wp : job.work_planes())
+        {
+            ovf::WorkPlane wp_shell{wp};
+            wp_shell.clear_vector_blocks();
+            writer.AppendWorkPlane(wp_shell);
+            for (const auto& vb : wp.vector_blocks())
+                writer.AppendVectorBlock(vb);
+        }
+    }
+    catch (const std::runtime_error&)
+    {
+        has_append_failed = true;
+    }
+
+    // the failed write is aborted, later appends can't add to the incomplete file
+    CHECK( has_append_failed );
+    CHECK_THROWS_AS( writer.AppendVectorBlock(job.work_planes(1).vector_blocks(0)), std::runtime_error );
+    CHECK_THROWS_AS( writer.FinishWrite(), std::runtime_error );
+
+    REQUIRE( setrlimit(RLIMIT_FSIZE, &limit) == 0 );
+    std::signal(SIGXFSZ, previous_handler);
+
+    writer.StartWritePartial(job, path);
+    for (const auto& wp : job.work_planes())
+        writer.AppendWorkPlane(wp);
+    writer.FinishWrite();
+    REQUIRE( ReadFile(path) == expected );
+
+    std::filesystem::remove(path);
+}
+#endif
+
+TEST_CASE( "writes identical files with any number of serialization threads", "[writer]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_writer_parallel.ovf").string();
+    // more vector blocks per work plane than serialized by one task of the pipeline
+    auto job = ovf_test::MakeTestJob(3, 70);
+
+    // per vector block checksums are computed by the threads serializing them
+    auto checksum_mode = GENERATE( ovf::reader_writer::ChecksumMode::kNone, ovf::reader_writer::ChecksumMode::kVectorBlocks );
+    auto num_threads = GENERATE( 2, 3 );
+
+    ovf::reader_writer::WriterOptions options{};
+    options.checksum_mode = checksum_mode;
+    ovf::reader_writer::OvfFileWriter{options}.WriteFullJob(job, path);
+    const auto expected = ReadFile(path);
+
+    options.num_threads = num_threads;
+    ovf::reader_writer::OvfFileWriter writer{options};
+    writer.WriteFullJob(job, path);
+    REQUIRE( ReadFile(path) == expected );
+
+    // copied, moved and owned vector blocks are kept in memory until they are serialized
+    writer.StartWritePartial(job, path);
+    for (const auto& wp : job.work_planes())
+    {
+        ovf::WorkPlane wp_shell{wp};
+        wp_shell.mutable_vector_blocks()->DeleteSubrange(10, wp.vector_blocks_size() - 10);
+        writer.AppendWorkPlane(std::move(wp_shell));
+
+        for (int i = 10; i < wp.vector_blocks_size(); i++)
+        {
+            if (i % 3 == 0)
+                writer.AppendVectorBlock(wp.vector_blocks(i));
+            else if (i % 3 == 1)
+                writer.AppendVectorBlock(ovf::VectorBlock{wp.vector_blocks(i)});
+            else
+                writer.AppendVectorBlock(std::make_unique<ovf::VectorBlock>(wp.vector_blocks(i)));
+        }
+    }
+    writer.FinishWrite();
+    REQUIRE( ReadFile(path) == expected );
+
+    ovf::reader_writer::OvfFileReader reader{0};
+    ovf::Job job_shell{};
+    reader.OpenFile(path, job_shell);
+    REQUIRE( reader.Verify().is_intact() == (checksum_mode != ovf::reader_writer::ChecksumMode::kNone) );
+    reader.CloseFile();
+
+    std::filesystem::remove(path);
+}
+
+
+TEST_CASE( "queues appends within a memory budget and reports errors of the background threads", "[writer]" ) {
+    auto path = (std::filesystem::temp_directory_path() / "ovf_test_writer_append_queued.ovf").string();
+    auto job = ovf_test::MakeTestJob(3, 10);
+
+    ovf::reader_writer::WriterOptions options{};
+    options.checksum_mode = ovf::reader_writer::ChecksumMode::kVectorBlocks;
+    ovf::reader_writer::OvfFileWriter sync_writer{options};
+    sync_writer.WriteFullJob(job, path);
+    const auto expected = ReadFile(path);
+    REQUIRE( sync_writer.GetQueueStatistics().peak_queued_bytes == 0 );
+
+    // the job is larger than the budget, so appends have to wait for queued vector blocks to be written,
+    // and finishing the write waits until the file is stored on the device
+    const size_t queue_budget = (size_t)1 << 16;
+    ovf::reader_writer::WriterOptions queued_options{options};
+    queued_options.queue_budget = queue_budget;
+    queued_options.sync_on_finish = true;
+    ovf::reader_writer::OvfFileWriter writer{queued_options};
+    writer.StartWritePartial(job, path);
+    for (const auto& wp : job.work_planes())
+    {
+        writer.AppendWorkPlane(wp);
+    }
+    writer.FinishWrite();
+    REQUIRE( ReadFile(path) == expected );
+
+    auto statistics = writer.GetQueueStatistics();
+    REQUIRE( statistics.num_queued_tasks == 0 );
+    REQUIRE( statistics.queued_bytes == 0 );
+    REQUIRE( statistics.peak_queued_bytes > 0 );
+    REQUIRE( statistics.peak_queued_bytes <= queue_budget );
+    REQUIRE( statistics.stall_seconds >= 0 );
+
+    // writes fail on a full device, which the calling thread only learns about later on
+    if (std::filesystem::exists("/dev/full"))
+    {
+        ovf::reader_writer::WriterOptions failing_options{options};
+        failing_options.write_buffer_size = 16;
+        failing_options.queue_budget = queue_budget;
+        ovf::reader_writer::OvfFileWriter failing_writer{failing_options};
+        REQUIRE_NOTHROW( failing_writer.StartWritePartial(job, "/dev/full") );
+        try
+        {
+            for (const auto& wp : job.work_planes())
+            {
+                failing_writer.AppendWorkPlane(wp);
+            }
+        }
+        catch (const std::runtime_error&)
+        {
+            // the error of a queued vector block was reported by a later append
+        }
+        // either an append or finishing the write failed, the write can't be finished in any case
+        REQUIRE_THROWS_AS( failing_writer.FinishWrite(), std::runtime_error );
+        REQUIRE_THROWS_AS( failing_writer.AppendVectorBlock(job.work_planes(0).vector_blocks(0)), std::runtime_error );
+
+        // the failed write is aborted, so the writer can start a new one
+        failing_writer.StartWritePartial(job, path);
+        for (const auto& wp : job.work_planes())
+        {
+            failing_writer.AppendWorkPlane(wp);
+        }
+        failing_writer.FinishWrite();
+        REQUIRE( ReadFile(path) == expected );
+
+        // synchronous writes are aborted as well
+        REQUIRE_THROWS_AS( sync_writer.WriteFullJob(job, "/dev/full"), std::runtime_error );
+        sync_writer.WriteFullJob(job, path);
+        REQUIRE( ReadFile(path) == expected );
+    }
+
+    std::filesystem::remove(path);
+}
\ No newline at end of file